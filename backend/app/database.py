@@ -20,6 +20,13 @@ async def connect_db(uri: str, db_name: str):
         await db.devices.create_index("device_id", unique=True)
         await db.vitals.create_index([("device_id", 1), ("timestamp", -1)])
         await db.vitals.create_index([("user_id", 1), ("timestamp", -1)])
+        # One copy per device window: a resent window (lost response, reboot
+        # before the device saved its ack) hits this index
+        await db.vitals.create_index(
+            [("device_id", 1), ("seq", 1)],
+            unique=True,
+            partialFilterExpression={"seq": {"$exists": True}},
+        )
         await db.predictions.create_index([("device_id", 1), ("created_at", -1)])
         await db.predictions.create_index([("user_id", 1), ("created_at", -1)])
         print("[DB] Connected and indexes created.")
@@ -1,8 +1,20 @@
-from pydantic import BaseModel, Field
+from pydantic import BaseModel, Field, model_validator
 from typing import List, Optional
 from datetime import datetime
 
 
+class HrvFeatures(BaseModel):
+    """RR statistics computed on the device, same keys as feature_extractor."""
+    rr_count: int = Field(..., ge=0)
+    mean_rr: float = Field(..., ge=0)
+    sdnn: float = Field(..., ge=0)
+    rmssd: float = Field(..., ge=0)
+    pnn50: float = Field(..., ge=0, le=100)
+    mean_hr_ecg: float = Field(..., ge=0)
+    hr_std: float = Field(..., ge=0)
+    rr_range: float = Field(..., ge=0)
+
+
 class VitalsCreate(BaseModel):
     device_id: str = Field(..., min_length=1, max_length=50)
     timestamp: int = Field(..., description="Unix epoch seconds from ESP32")
@@ -13,6 +25,22 @@ class VitalsCreate(BaseModel):
     ecg_lead_off: bool = Field(default=False)
     ecg_samples: List[int] = Field(..., min_length=100, max_length=6000)
     beat_timestamps_ms: List[int] = Field(default_factory=list)
+    r_peak_samples: List[int] = Field(default_factory=list)  # ECG sample indices
+    hrv: Optional[HrvFeatures] = None
+    screen_score: Optional[float] = Field(default=None, ge=0, le=1)  # On-device CNN
+    seq: Optional[int] = Field(default=None, ge=1, le=0xFFFFFFFF)  # Device store seq, repeats on a resend
+
+    @model_validator(mode="after")
+    def check_r_peaks(self):
+        # extract_ecg_features() indexes ecg_samples with these directly
+        prev = -1
+        for idx in self.r_peak_samples:
+            if idx <= prev:
+                raise ValueError("r_peak_samples must be strictly increasing and >= 0")
+            if idx >= len(self.ecg_samples):
+                raise ValueError("r_peak_samples index beyond ecg_samples")
+            prev = idx
+        return self
 
 
 class VitalsResponse(BaseModel):
@@ -29,6 +57,18 @@ class VitalsResponse(BaseModel):
     created_at: datetime
 
 
+class VitalsBatchItem(BaseModel):
+    id: Optional[str] = None
+    timestamp: Optional[datetime] = None
+    prediction: Optional[dict] = None
+    error: Optional[str] = None  # Set when the record was rejected
+
+
+class VitalsBatchResponse(BaseModel):
+    results: List[VitalsBatchItem]  # One per record, in request order
+    inserted: int  # New documents (resent windows not counted)
+
+
 class VitalsListResponse(BaseModel):
     vitals: List[VitalsResponse]
     total: int
@@ -1,11 +1,21 @@
-from datetime import datetime
+import struct
+from datetime import datetime, timedelta
 
 from bson import ObjectId
-from fastapi import APIRouter, Depends, HTTPException, Query
+from fastapi import APIRouter, Depends, HTTPException, Query, Request
+from pydantic import ValidationError
+from pymongo.errors import BulkWriteError, DuplicateKeyError
 
 from app.database import get_db
 from app.middleware.auth import verify_api_key, get_current_user
-from app.models.vitals import VitalsCreate, VitalsResponse, VitalsListResponse
+from app.models.vitals import (
+    VitalsBatchItem,
+    VitalsBatchResponse,
+    VitalsCreate,
+    VitalsListResponse,
+    VitalsResponse,
+)
+from app.services import ecg_codec
 
 router = APIRouter()
 
@@ -35,15 +45,151 @@ async def _verify_device_ownership(device_id: str, user: dict):
         )
 
 
-@router.post("", response_model=VitalsResponse)
-async def upload_vitals(data: VitalsCreate, _=Depends(verify_api_key)):
-    db = get_db()
+# ── Binary upload format (see firmware/src/vitals_payload.h) ──
+
+BIN_MAGIC = b"CV"
+BIN_FLAG_LEAD_OFF = 0x01
+BIN_ENC_SHIFT = 1
+BIN_ENC_MASK = 0x0E
+BIN_ENC_PACKED12 = 0
+BIN_ENC_RICE = 1
+_BIN_HEADER = struct.Struct("<2sBBIHHHBB")
+_BIN_HRV = struct.Struct("<BHHHHHHH")
+BIN_NO_SCREEN = 0xFFFF
+MONGO_DUPLICATE_KEY = 11000
+
+BIN_BATCH_MAGIC = b"CB"
+BIN_BATCH_MAX = 64
+_BIN_BATCH_HEADER = struct.Struct("<2sBB")
+
+
+def _unpack_12bit(data: bytes, count: int) -> list:
+    samples = []
+    full = count // 2
+    for i in range(full):
+        b0, b1, b2 = data[3 * i], data[3 * i + 1], data[3 * i + 2]
+        samples.append(b0 | ((b1 & 0x0F) << 8))
+        samples.append((b1 >> 4) | (b2 << 4))
+    if count % 2:
+        off = 3 * full
+        samples.append(data[off] | ((data[off + 1] & 0x0F) << 8))
+    return samples
+
+
+def _decode_binary_vitals(payload: bytes) -> dict:
+    """Decode one binary vitals record into VitalsCreate fields."""
+    if len(payload) < _BIN_HEADER.size:
+        raise ValueError("payload shorter than header")
+
+    (magic, version, flags, timestamp, sample_rate_hz, window_ms,
+     hr_x10, spo2, id_len) = _BIN_HEADER.unpack_from(payload, 0)
+    if magic != BIN_MAGIC:
+        raise ValueError("bad magic")
+    if version not in (1, 2, 3, 4, 5):
+        raise ValueError(f"unsupported version {version}")
+
+    off = _BIN_HEADER.size
+    device_id = payload[off:off + id_len].decode("ascii")
+    off += id_len
+
+    if len(payload) < off + 3:
+        raise ValueError("truncated sample header")
+    sample_count, beat_count = struct.unpack_from("<HB", payload, off)
+    off += 3
+
+    encoding = (flags & BIN_ENC_MASK) >> BIN_ENC_SHIFT
+    if encoding == BIN_ENC_PACKED12:
+        sample_bytes = (sample_count * 3 + 1) // 2
+        if len(payload) < off + sample_bytes:
+            raise ValueError("truncated payload")
+        ecg_samples = _unpack_12bit(payload[off:off + sample_bytes], sample_count)
+    elif encoding == BIN_ENC_RICE:
+        if len(payload) < off + 2:
+            raise ValueError("truncated payload")
+        (frame_len,) = struct.unpack_from("<H", payload, off)
+        off += 2
+        if len(payload) < off + frame_len:
+            raise ValueError("truncated payload")
+        sample_bytes = frame_len
+        ecg_samples = ecg_codec.decode(payload[off:off + frame_len], sample_count)
+    else:
+        raise ValueError(f"unsupported sample encoding {encoding}")
+    off += sample_bytes
+
+    if len(payload) < off + 2 * beat_count:
+        raise ValueError("truncated payload")
+
+    beat_timestamps_ms = list(struct.unpack_from(f"<{beat_count}H", payload, off))
+    off += 2 * beat_count
+
+    # Version 2: R peaks from the on-device QRS detector
+    r_peak_samples = []
+    if version >= 2:
+        if len(payload) < off + 1:
+            raise ValueError("truncated payload")
+        r_peak_count = payload[off]
+        off += 1
+        if len(payload) < off + 2 * r_peak_count:
+            raise ValueError("truncated payload")
+        r_peak_samples = list(struct.unpack_from(f"<{r_peak_count}H", payload, off))
+        off += 2 * r_peak_count
+
+    # Version 3: HRV of those R peaks
+    hrv = None
+    if version >= 3:
+        if len(payload) < off + _BIN_HRV.size:
+            raise ValueError("truncated payload")
+        (rr_count, mean_rr, sdnn_x10, rmssd_x10, pnn50_x10,
+         hr_x10_ecg, hr_std_x10, rr_range) = _BIN_HRV.unpack_from(payload, off)
+        hrv = {
+            "rr_count": rr_count,
+            "mean_rr": float(mean_rr),
+            "sdnn": sdnn_x10 / 10.0,
+            "rmssd": rmssd_x10 / 10.0,
+            "pnn50": pnn50_x10 / 10.0,
+            "mean_hr_ecg": hr_x10_ecg / 10.0,
+            "hr_std": hr_std_x10 / 10.0,
+            "rr_range": float(rr_range),
+        }
+        off += _BIN_HRV.size
+
+    # Version 4: score of the on-device CNN screen
+    screen_score = None
+    if version >= 4:
+        if len(payload) < off + 2:
+            raise ValueError("truncated payload")
+        (screen_x10000,) = struct.unpack_from("<H", payload, off)
+        if screen_x10000 != BIN_NO_SCREEN:
+            screen_score = min(screen_x10000 / 10000.0, 1.0)
+        off += 2
+
+    # Version 5: the device's store seq, repeated when it resends the window
+    seq = None
+    if version >= 5:
+        if len(payload) < off + 4:
+            raise ValueError("truncated payload")
+        (seq,) = struct.unpack_from("<I", payload, off)
+        seq = seq or None
+
+    return {
+        "device_id": device_id,
+        "timestamp": timestamp,
+        "window_ms": window_ms,
+        "sample_rate_hz": sample_rate_hz,
+        "heart_rate_bpm": hr_x10 / 10.0,
+        "spo2_percent": spo2,
+        "ecg_lead_off": bool(flags & BIN_FLAG_LEAD_OFF),
+        "ecg_samples": ecg_samples,
+        "beat_timestamps_ms": beat_timestamps_ms,
+        "r_peak_samples": r_peak_samples,
+        "hrv": hrv,
+        "screen_score": screen_score,
+        "seq": seq,
+    }
 
-    # Resolve device → owner user_id
-    device_doc = await db.devices.find_one({"device_id": data.device_id})
-    user_id = device_doc.get("owner_user_id") if device_doc else None
 
-    vitals_doc = {
+def _new_vitals_doc(data: VitalsCreate, user_id) -> dict:
+    doc = {
         "device_id": data.device_id,
         "user_id": user_id,
         "timestamp": datetime.utcfromtimestamp(data.timestamp),
@@ -54,9 +200,180 @@ async def upload_vitals(data: VitalsCreate, _=Depends(verify_api_key)):
         "ecg_lead_off": data.ecg_lead_off,
         "ecg_samples": data.ecg_samples,
         "beat_timestamps_ms": data.beat_timestamps_ms,
+        "r_peak_samples": data.r_peak_samples,
+        "hrv": data.hrv.model_dump() if data.hrv else None,
+        "screen_score": data.screen_score,
         "created_at": datetime.utcnow(),
     }
-    result = await db.vitals.insert_one(vitals_doc)
+    # Only set when known: the unique (device_id, seq) index skips documents without it
+    if data.seq is not None:
+        doc["seq"] = data.seq
+    return doc
+
+
+async def _find_resent(db, data: VitalsCreate, projection: dict = None) -> dict:
+    """The stored copy of a window the device sent again (same seq)."""
+    return await db.vitals.find_one(
+        {"device_id": data.device_id, "seq": data.seq}, projection=projection
+    )
+
+
+def _wants_prediction(data: VitalsCreate) -> bool:
+    return not data.ecg_lead_off and len(data.ecg_samples) >= 100
+
+
+async def _load_user_context(db, device_doc: dict, user_id) -> tuple:
+    """User profile and 24h/7d vitals stats for personalized predictions."""
+    if not (device_doc and user_id):
+        return None, None, None
+
+    user_profile = None
+    user = await db.users.find_one({"_id": ObjectId(user_id)})
+    if user and user.get("profile"):
+        user_profile = user["profile"]
+
+    # Compute historical baselines (across all user's devices)
+    now = datetime.utcnow()
+    pipeline_24h = [
+        {"$match": {"user_id": user_id,
+                    "created_at": {"$gte": now - timedelta(hours=24)}}},
+        {"$group": {
+            "_id": None,
+            "avg_hr": {"$avg": "$heart_rate_bpm"},
+            "std_hr": {"$stdDevPop": "$heart_rate_bpm"},
+            "avg_spo2": {"$avg": "$spo2_percent"},
+            "std_spo2": {"$stdDevPop": "$spo2_percent"},
+            "count": {"$sum": 1},
+        }},
+    ]
+    pipeline_7d = [
+        {"$match": {"user_id": user_id,
+                    "created_at": {"$gte": now - timedelta(days=7)}}},
+        {"$group": {
+            "_id": None,
+            "avg_hr": {"$avg": "$heart_rate_bpm"},
+            "avg_spo2": {"$avg": "$spo2_percent"},
+        }},
+    ]
+
+    stats_24h = await db.vitals.aggregate(pipeline_24h).to_list(1)
+    stats_7d = await db.vitals.aggregate(pipeline_7d).to_list(1)
+    return user_profile, stats_24h, stats_7d
+
+
+def _history_features(data: VitalsCreate, stats_24h: list, stats_7d: list):
+    history_features = None
+    if stats_24h:
+        s = stats_24h[0]
+        hr_std = s.get("std_hr", 1) or 1
+        spo2_std = s.get("std_spo2", 1) or 1
+        history_features = {
+            "hr_baseline_24h": s.get("avg_hr", 0),
+            "spo2_baseline_24h": s.get("avg_spo2", 0),
+            "hr_deviation": abs(data.heart_rate_bpm - s.get("avg_hr", data.heart_rate_bpm)) / hr_std,
+            "spo2_deviation": abs(data.spo2_percent - s.get("avg_spo2", data.spo2_percent)) / spo2_std,
+            "readings_count_24h": s.get("count", 0),
+        }
+    if stats_7d:
+        if history_features is None:
+            history_features = {}
+        history_features["hr_baseline_7d"] = stats_7d[0].get("avg_hr", 0)
+    return history_features
+
+
+def _predict_window(data: VitalsCreate, vitals_doc: dict, context: tuple) -> tuple:
+    """Run the ML model on one window.
+
+    Returns (prediction for the response, document for db.predictions),
+    both None when the model has no answer.
+    """
+    from app.services.ml_service import predict
+
+    user_profile, stats_24h, stats_7d = context
+    ml_result = predict(
+        ecg_samples=data.ecg_samples,
+        sample_rate_hz=data.sample_rate_hz,
+        heart_rate_bpm=data.heart_rate_bpm,
+        spo2_percent=data.spo2_percent,
+        user_profile=user_profile,
+        history_features=_history_features(data, stats_24h, stats_7d),
+        r_peaks=data.r_peak_samples,
+        hrv=data.hrv.model_dump() if data.hrv else None,
+        screen_score=data.screen_score,
+    )
+    if ml_result["risk_label"] == "unknown":
+        return None, None
+
+    pred_doc = {
+        "vitals_id": str(vitals_doc["_id"]),
+        "device_id": data.device_id,
+        "user_id": vitals_doc["user_id"],
+        "risk_score": ml_result["risk_score"],
+        "risk_label": ml_result["risk_label"],
+        "confidence": ml_result["confidence"],
+        "features": ml_result["features"],
+        "model_version": ml_result["model_version"],
+        "created_at": datetime.utcnow(),
+    }
+    prediction = {
+        "risk_score": ml_result["risk_score"],
+        "risk_label": ml_result["risk_label"],
+        "confidence": ml_result["confidence"],
+    }
+    return prediction, pred_doc
+
+
+def _split_binary_batch(payload: bytes) -> list:
+    """Split a batch body into its binary vitals records."""
+    if len(payload) < _BIN_BATCH_HEADER.size:
+        raise ValueError("payload shorter than header")
+
+    magic, version, count = _BIN_BATCH_HEADER.unpack_from(payload, 0)
+    if magic != BIN_BATCH_MAGIC:
+        raise ValueError("bad magic")
+    if version != 1:
+        raise ValueError(f"unsupported version {version}")
+    if count > BIN_BATCH_MAX:
+        raise ValueError(f"more than {BIN_BATCH_MAX} records")
+
+    records = []
+    off = _BIN_BATCH_HEADER.size
+    for _ in range(count):
+        if len(payload) < off + 2:
+            raise ValueError("truncated payload")
+        (length,) = struct.unpack_from("<H", payload, off)
+        off += 2
+        if len(payload) < off + length:
+            raise ValueError("truncated payload")
+        records.append(payload[off:off + length])
+        off += length
+    if off != len(payload):
+        raise ValueError("trailing bytes after last record")
+    return records
+
+
+async def _ingest_vitals(data: VitalsCreate) -> VitalsResponse:
+    db = get_db()
+
+    # Resolve device → owner user_id
+    device_doc = await db.devices.find_one({"device_id": data.device_id})
+    user_id = device_doc.get("owner_user_id") if device_doc else None
+
+    vitals_doc = _new_vitals_doc(data, user_id)
+    try:
+        result = await db.vitals.insert_one(vitals_doc)
+    except DuplicateKeyError:
+        # Already stored (the device never saw our answer): answer again
+        doc = await _find_resent(db, data)
+        pred = await db.predictions.find_one({"vitals_id": str(doc["_id"])})
+        pred_dict = None
+        if pred:
+            pred_dict = {
+                "risk_score": pred["risk_score"],
+                "risk_label": pred["risk_label"],
+                "confidence": pred["confidence"],
+            }
+        return _vitals_doc_to_response(doc, pred_dict)
     vitals_doc["_id"] = result.inserted_id
 
     # Update device last_seen
@@ -68,92 +385,16 @@ async def upload_vitals(data: VitalsCreate, _=Depends(verify_api_key)):
     # Run ML prediction if models are available
     prediction = None
     try:
-        from app.services.ml_service import predict, _models_loaded, load_models
+        from app.services.ml_service import _models_loaded, load_models
 
         if not _models_loaded:
             load_models()
 
-        if not data.ecg_lead_off and len(data.ecg_samples) >= 100:
-            # Get user profile for personalized prediction
-            user_profile = None
-            history_features = None
-
-            if device_doc and user_id:
-                user = await db.users.find_one({"_id": ObjectId(user_id)})
-                if user and user.get("profile"):
-                    user_profile = user["profile"]
-
-                # Compute historical baselines (across all user's devices)
-                from datetime import timedelta
-                now = datetime.utcnow()
-                pipeline_24h = [
-                    {"$match": {"user_id": user_id,
-                                "created_at": {"$gte": now - timedelta(hours=24)}}},
-                    {"$group": {
-                        "_id": None,
-                        "avg_hr": {"$avg": "$heart_rate_bpm"},
-                        "std_hr": {"$stdDevPop": "$heart_rate_bpm"},
-                        "avg_spo2": {"$avg": "$spo2_percent"},
-                        "std_spo2": {"$stdDevPop": "$spo2_percent"},
-                        "count": {"$sum": 1},
-                    }},
-                ]
-                pipeline_7d = [
-                    {"$match": {"user_id": user_id,
-                                "created_at": {"$gte": now - timedelta(days=7)}}},
-                    {"$group": {
-                        "_id": None,
-                        "avg_hr": {"$avg": "$heart_rate_bpm"},
-                        "avg_spo2": {"$avg": "$spo2_percent"},
-                    }},
-                ]
-
-                stats_24h = await db.vitals.aggregate(pipeline_24h).to_list(1)
-                stats_7d = await db.vitals.aggregate(pipeline_7d).to_list(1)
-
-                if stats_24h:
-                    s = stats_24h[0]
-                    hr_std = s.get("std_hr", 1) or 1
-                    spo2_std = s.get("std_spo2", 1) or 1
-                    history_features = {
-                        "hr_baseline_24h": s.get("avg_hr", 0),
-                        "spo2_baseline_24h": s.get("avg_spo2", 0),
-                        "hr_deviation": abs(data.heart_rate_bpm - s.get("avg_hr", data.heart_rate_bpm)) / hr_std,
-                        "spo2_deviation": abs(data.spo2_percent - s.get("avg_spo2", data.spo2_percent)) / spo2_std,
-                        "readings_count_24h": s.get("count", 0),
-                    }
-                if stats_7d:
-                    if history_features is None:
-                        history_features = {}
-                    history_features["hr_baseline_7d"] = stats_7d[0].get("avg_hr", 0)
-
-            ml_result = predict(
-                ecg_samples=data.ecg_samples,
-                sample_rate_hz=data.sample_rate_hz,
-                heart_rate_bpm=data.heart_rate_bpm,
-                spo2_percent=data.spo2_percent,
-                user_profile=user_profile,
-                history_features=history_features,
-            )
-
-            if ml_result["risk_label"] != "unknown":
-                pred_doc = {
-                    "vitals_id": str(result.inserted_id),
-                    "device_id": data.device_id,
-                    "user_id": user_id,
-                    "risk_score": ml_result["risk_score"],
-                    "risk_label": ml_result["risk_label"],
-                    "confidence": ml_result["confidence"],
-                    "features": ml_result["features"],
-                    "model_version": ml_result["model_version"],
-                    "created_at": datetime.utcnow(),
-                }
+        if _wants_prediction(data):
+            context = await _load_user_context(db, device_doc, user_id)
+            prediction, pred_doc = _predict_window(data, vitals_doc, context)
+            if pred_doc:
                 await db.predictions.insert_one(pred_doc)
-                prediction = {
-                    "risk_score": ml_result["risk_score"],
-                    "risk_label": ml_result["risk_label"],
-                    "confidence": ml_result["confidence"],
-                }
     except ImportError:
         pass  # ML dependencies not installed, skip prediction
     except Exception as e:
@@ -162,6 +403,147 @@ async def upload_vitals(data: VitalsCreate, _=Depends(verify_api_key)):
     return _vitals_doc_to_response(vitals_doc, prediction)
 
 
+async def _ingest_vitals_batch(items: list) -> tuple:
+    """Insert several windows in one round trip.
+
+    Returns ([(vitals_doc, prediction) per item, in order], inserted count).
+    A window already stored (same device_id and seq) gets its stored
+    document and no new prediction. Device owners and user baselines are
+    looked up once per device, not once per window.
+    """
+    db = get_db()
+
+    device_ids = sorted({data.device_id for data in items})
+    devices = {}
+    async for doc in db.devices.find({"device_id": {"$in": device_ids}}):
+        devices[doc["device_id"]] = doc
+
+    vitals_docs = []
+    for data in items:
+        device_doc = devices.get(data.device_id)
+        user_id = device_doc.get("owner_user_id") if device_doc else None
+        vitals_docs.append(_new_vitals_doc(data, user_id))
+
+    # insert_many() sets each document's _id before it is sent. Unordered,
+    # a resent window only fails itself; any other write error fails the
+    # request and the device resends the batch.
+    resent = set()
+    try:
+        await db.vitals.insert_many(vitals_docs, ordered=False)
+    except BulkWriteError as e:
+        errors = e.details.get("writeErrors", [])
+        if any(err["code"] != MONGO_DUPLICATE_KEY for err in errors):
+            raise
+        for err in errors:
+            i = err["index"]
+            vitals_docs[i] = await _find_resent(
+                db, items[i], {"ecg_samples": 0, "beat_timestamps_ms": 0, "r_peak_samples": 0}
+            )
+            resent.add(i)
+
+    await db.devices.update_many(
+        {"device_id": {"$in": device_ids}},
+        {"$set": {"last_seen": datetime.utcnow()}},
+    )
+
+    predictions = [None] * len(items)
+    inserted = len(items) - len(resent)
+    try:
+        from app.services.ml_service import _models_loaded, load_models
+
+        if not _models_loaded:
+            load_models()
+    except ImportError:
+        return list(zip(vitals_docs, predictions)), inserted  # ML dependencies not installed, skip prediction
+    except Exception as e:
+        print(f"[ML] Model load error: {e}")
+        return list(zip(vitals_docs, predictions)), inserted
+
+    # A window the model chokes on only loses its own prediction
+    contexts = {}
+    pred_docs = []
+    for i, (data, doc) in enumerate(zip(items, vitals_docs)):
+        if i in resent or not _wants_prediction(data):
+            continue
+        try:
+            if data.device_id not in contexts:
+                contexts[data.device_id] = await _load_user_context(
+                    db, devices.get(data.device_id), doc["user_id"]
+                )
+            predictions[i], pred_doc = _predict_window(data, doc, contexts[data.device_id])
+        except Exception as e:
+            print(f"[ML] Prediction error for vitals {doc['_id']}: {e}")
+            continue
+        if pred_doc:
+            pred_docs.append(pred_doc)
+
+    if pred_docs:
+        try:
+            await db.predictions.insert_many(pred_docs)
+        except Exception as e:
+            print(f"[ML] Prediction insert error: {e}")
+
+    return list(zip(vitals_docs, predictions)), inserted
+
+
+@router.post("", response_model=VitalsResponse)
+async def upload_vitals(data: VitalsCreate, _=Depends(verify_api_key)):
+    return await _ingest_vitals(data)
+
+
+@router.post("/bin", response_model=VitalsResponse)
+async def upload_vitals_binary(request: Request, _=Depends(verify_api_key)):
+    """Same as POST /vitals, but with the compact application/octet-stream body."""
+    payload = await request.body()
+    try:
+        fields = _decode_binary_vitals(payload)
+    except (ValueError, struct.error) as e:
+        raise HTTPException(status_code=400, detail=f"Invalid binary payload: {e}")
+    try:
+        data = VitalsCreate(**fields)
+    except ValidationError as e:
+        raise HTTPException(status_code=422, detail=str(e))
+    return await _ingest_vitals(data)
+
+
+@router.post("/batch", response_model=VitalsBatchResponse)
+async def upload_vitals_batch(request: Request, _=Depends(verify_api_key)):
+    """Several binary records in one request (a device draining its backlog).
+
+    Body: "CB", version 1, record count, then per record a u16 length and
+    one /bin record. A record that fails to decode or validate is reported
+    in its result slot and skipped; the others are still stored. A record
+    already stored (same device_id and seq) gets the id of the stored copy.
+    """
+    payload = await request.body()
+    try:
+        records = _split_binary_batch(payload)
+    except (ValueError, struct.error) as e:
+        raise HTTPException(status_code=400, detail=f"Invalid batch payload: {e}")
+
+    results = []
+    items = []
+    for record in records:
+        try:
+            items.append(VitalsCreate(**_decode_binary_vitals(record)))
+            results.append(None)
+        except (ValueError, struct.error) as e:  # ValidationError is a ValueError
+            results.append(VitalsBatchItem(error=str(e)))
+
+    ingested, inserted = await _ingest_vitals_batch(items) if items else ([], 0)
+    ingested = iter(ingested)
+    for i, item in enumerate(results):
+        if item is None:
+            doc, prediction = next(ingested)
+            results[i] = VitalsBatchItem(
+                id=str(doc["_id"]),
+                timestamp=doc["timestamp"],
+                prediction=prediction,
+            )
+
+    return VitalsBatchResponse(results=results, inserted=inserted)
+
+
 # ── User-based endpoints (must be before /{device_id} routes) ──
 
 
@@ -173,7 +555,7 @@ async def get_user_latest_vitals(
     db = get_db()
     user_id = str(user["_id"])
 
-    projection = None if include_ecg else {"ecg_samples": 0, "beat_timestamps_ms": 0}
+    projection = None if include_ecg else {"ecg_samples": 0, "beat_timestamps_ms": 0, "r_peak_samples": 0}
     doc = await db.vitals.find_one(
         {"user_id": user_id},
         projection=projection,
@@ -231,7 +613,7 @@ async def get_latest_vitals(
     db = get_db()
     await _verify_device_ownership(device_id, user)
 
-    projection = None if include_ecg else {"ecg_samples": 0, "beat_timestamps_ms": 0}
+    projection = None if include_ecg else {"ecg_samples": 0, "beat_timestamps_ms": 0, "r_peak_samples": 0}
     doc = await db.vitals.find_one(
         {"device_id": device_id},
         projection=projection,
@@ -0,0 +1,80 @@
+"""
+Lossless ECG codec decoder (2nd order prediction + block-adaptive Rice).
+Bit-exact mirror of firmware/src/ecg_codec.cpp — keep the constants in sync.
+
+Run as a module to verify a dump written by the firmware codec benchmark:
+    python -m app.services.ecg_codec codec_dump.bin
+"""
+
+import struct
+import sys
+
+BLOCK = 32
+ESCAPE_Q = 16
+ESCAPE_BITS = 20
+
+
+def decode(data: bytes, count: int) -> list:
+    """Decode `count` samples from one codec frame. Raises ValueError if truncated."""
+    total_bits = len(data) * 8
+    pos = 0
+
+    def read(bits: int) -> int:
+        nonlocal pos
+        if pos + bits > total_bits:
+            raise ValueError("truncated ECG codec frame")
+        value = 0
+        for _ in range(bits):
+            value = (value << 1) | ((data[pos >> 3] >> (7 - (pos & 7))) & 1)
+            pos += 1
+        return value
+
+    out = []
+    x1 = x2 = 0
+    for block_start in range(0, count, BLOCK):
+        k = read(4)
+        for n in range(block_start, min(block_start + BLOCK, count)):
+            if n == 0:
+                x = read(16)
+            else:
+                q = 0
+                while q < ESCAPE_Q and read(1):
+                    q += 1
+                if q == ESCAPE_Q:
+                    u = read(ESCAPE_BITS)
+                else:
+                    u = (q << k) | read(k)
+                e = (u >> 1) ^ -(u & 1)
+                pred = x1 if n == 1 else 2 * x1 - x2
+                x = pred + e
+            out.append(x & 0xFFFF)
+            x2, x1 = x1, x
+    return out
+
+
+def _verify_dump(path: str) -> int:
+    """Dump records: u16 count, count x u16 original, u16 frame length, frame."""
+    with open(path, "rb") as f:
+        blob = f.read()
+
+    off = windows = 0
+    while off < len(blob):
+        (count,) = struct.unpack_from("<H", blob, off)
+        off += 2
+        original = list(struct.unpack_from(f"<{count}H", blob, off))
+        off += 2 * count
+        (frame_len,) = struct.unpack_from("<H", blob, off)
+        off += 2
+        decoded = decode(blob[off:off + frame_len], count)
+        off += frame_len
+        if decoded != original:
+            print(f"window {windows}: MISMATCH")
+            return 1
+        windows += 1
+
+    print(f"{windows} windows decoded bit-exact")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(_verify_dump(sys.argv[1]))
@@ -25,6 +25,10 @@ MODEL_DIR = os.path.join(BACKEND_ROOT, "ml_models")
 ECG_WEIGHT = 0.60
 XGB_WEIGHT = 0.40
 
+# Windows the device's CNN screen (distilled from ECGFounder) scores below
+# this skip ECGFounder; the screen score takes its place in the ensemble
+SCREEN_SKIP_BELOW = 0.10
+
 # Risk labels
 RISK_LABELS = {
     (0.0, 0.2): "normal",
@@ -111,7 +115,9 @@ def load_models():
 
 def predict(ecg_samples: list, sample_rate_hz: int = 100,
             heart_rate_bpm: float = None, spo2_percent: float = None,
-            user_profile: dict = None, history_features: dict = None) -> dict:
+            user_profile: dict = None, history_features: dict = None,
+            r_peaks: list = None, hrv: dict = None,
+            screen_score: float = None) -> dict:
     """
     Run ensemble prediction on ECG data.
 
@@ -122,6 +128,9 @@ def predict(ecg_samples: list, sample_rate_hz: int = 100,
         spo2_percent: SpO2 from MAX30100
         user_profile: dict with age, sex, bmi, is_diabetic, etc.
         history_features: dict with hr_baseline_24h, etc.
+        r_peaks: R peak sample indices detected on the device (optional)
+        hrv: device HRV features for those peaks (optional)
+        screen_score: on-device CNN screen probability (optional)
 
     Returns:
         dict with risk_score, risk_label, confidence, features, model_version
@@ -141,8 +150,11 @@ def predict(ecg_samples: list, sample_rate_hz: int = 100,
     prob_ecg = None
     prob_xgb = None
 
-    # --- ECGFounder Prediction ---
-    if _ecg_model is not None:
+    # --- ECGFounder Prediction (skipped for windows the device screened low) ---
+    screened = screen_score is not None and screen_score < SCREEN_SKIP_BELOW
+    if screened:
+        prob_ecg = float(screen_score)
+    elif _ecg_model is not None:
         try:
             # Upsample from device rate to 500Hz (5000 samples for 10s)
             target_length = 5000
@@ -176,6 +188,8 @@ def predict(ecg_samples: list, sample_rate_hz: int = 100,
                 ecg, sample_rate=sample_rate_hz,
                 heart_rate_sensor=heart_rate_bpm,
                 spo2=spo2_percent,
+                r_peaks=r_peaks,
+                hrv=hrv,
             )
 
             # Add user profile features
@@ -213,11 +227,11 @@ def predict(ecg_samples: list, sample_rate_hz: int = 100,
     if prob_ecg is not None and prob_xgb is not None:
         risk_score = ECG_WEIGHT * prob_ecg + XGB_WEIGHT * prob_xgb
         confidence = 1.0 - abs(prob_ecg - prob_xgb)  # Higher when models agree
-        result["model_version"] = "v1.0-ensemble"
+        result["model_version"] = "v1.0-ensemble-screened" if screened else "v1.0-ensemble"
     elif prob_ecg is not None:
         risk_score = prob_ecg
         confidence = 0.7
-        result["model_version"] = "v1.0-ecgfounder-only"
+        result["model_version"] = "v1.0-screen-only" if screened else "v1.0-ecgfounder-only"
     elif prob_xgb is not None:
         risk_score = prob_xgb
         confidence = 0.6
@@ -36,6 +36,31 @@
 #define IR_LED_CURRENT          MAX30100_LED_CURR_27_1MA
 #define STALL_TIMEOUT_MS        10000
 #define HR_REPORT_PERIOD_MS     1000
+#ifndef PPG_SAMPLE_CLOCK
+#define PPG_SAMPLE_CLOCK        1       // Time PPG beats by sample count (1) or millis() when drained (0)
+#endif
+
+// FIFO readout. Burst mode reads every pending sample in one transaction at
+// 400kHz; after repeated bus errors it drops back to one transaction per
+// sample at 100kHz (safe with weak pull-ups) until reboot.
+#ifndef MAX30100_I2C_BURST
+#define MAX30100_I2C_BURST      0       // 1 = burst reads at 400kHz, 0 = per-sample at 100kHz
+#endif
+#define I2C_STATS_PERIOD_MS     10000   // [I2C] bus usage log period
+
+// FIFO servicing. Poll mode reads the FIFO pointers on every sensorUpdate()
+// even when nothing is pending; the interrupt modes wake a task from
+// PIN_MAX30100_INT so the bus is only used when samples exist.
+#define MAX30100_IRQ_POLL       0       // pox.update() from loop()
+#define MAX30100_IRQ_SAMPLE     1       // SpO2-ready: one wake per sample (100Hz)
+#define MAX30100_IRQ_FIFO_FULL  2       // A_FULL: one wake per 15 samples (150ms batches)
+#ifndef MAX30100_IRQ_MODE
+#define MAX30100_IRQ_MODE       MAX30100_IRQ_SAMPLE
+#endif
+#define PPG_TASK_STACK          4096
+#define PPG_TASK_PRIORITY       3       // Above loop(), below the ECG DMA task
+#define PPG_TASK_CORE           1
+#define PPG_IRQ_TIMEOUT_MS      1000    // Service the FIFO anyway after this long without INT
 
 // ============================================================
 //  ECG SAMPLING CONFIG
@@ -47,6 +72,68 @@
 #define ECG_TEXT_DIVISOR         25      // Text mode: print every 25th sample (10Hz)
 #define ECG_OVERSAMPLE_COUNT    4       // Read ADC 4x and average per sample
 #define MAX_BEATS_PER_WINDOW    30      // Max ~180bpm for 10s
+#define ECG_RING_SIZE           4096    // Continuous filtered ECG ring, power of 2 (16.4s @ 250Hz)
+#define ECG_WINDOW_OVERLAP_SAMPLES 0    // Samples shared by consecutive windows (0 = back-to-back)
+#define ECG_WINDOW_HOP_SAMPLES  (ECG_SAMPLES_PER_WINDOW - ECG_WINDOW_OVERLAP_SAMPLES)
+#define BEAT_RING_SIZE          64      // Recent beat positions, power of 2
+
+// ECG filter corners. ecg_filter.h designs the coefficients from these and
+// ECG_SAMPLE_RATE_HZ at compile time (filter_design.h).
+#ifndef ECG_MAINS_HZ
+#define ECG_MAINS_HZ            50      // Powerline notch: 50 (Europe, Asia) or 60 (Americas)
+#endif
+#define ECG_NOTCH_Q             25      // f0 / notch bandwidth
+#define ECG_LPF_HZ              40      // 2nd order Butterworth low-pass
+#define ECG_HPF_HZ              0.5     // Baseline wander removal (DC remover corner)
+
+// ECG filter arithmetic (notch, LPF and DC remover in ecg_filter.h)
+//   ECG_FILTER_FLOAT = single precision on the FPU
+//   ECG_FILTER_FIXED = Q16 samples, Q2.30 coefficients, integer only
+#define ECG_FILTER_FLOAT        0
+#define ECG_FILTER_FIXED        1
+#ifndef ECG_FILTER_IMPL
+#define ECG_FILTER_IMPL         ECG_FILTER_FLOAT
+#endif
+#define ECG_FILTER_BLOCK        32      // Max samples per filter process() call
+
+// ECG acquisition backend
+//   ECG_ACQ_POLL  = millis() polling from loop() (legacy, loop latency = jitter)
+//   ECG_ACQ_TIMER = esp_timer periodic callback at exactly ECG_SAMPLE_RATE_HZ
+//   ECG_ACQ_DMA   = I2S0 built-in ADC mode (continuous DMA), oversampled and decimated
+//                   (ESP32 only, not available in [env:native])
+#define ECG_ACQ_POLL            0
+#define ECG_ACQ_TIMER           1
+#define ECG_ACQ_DMA             2
+#ifndef ECG_ACQ_MODE
+#define ECG_ACQ_MODE            ECG_ACQ_TIMER
+#endif
+#define ECG_SAMPLE_PERIOD_US    (1000000UL / ECG_SAMPLE_RATE_HZ)  // 4000us
+#define ECG_ACQ_BUFFER_SIZE     128     // Raw sample ring, power of 2 (512ms @ 250Hz)
+
+// DMA backend (ECG_ACQ_DMA only)
+#define ECG_DMA_DECIMATION      8       // ADC runs at 8x the output rate (2kHz)
+#define ECG_DMA_SAMPLE_RATE_HZ  (ECG_SAMPLE_RATE_HZ * ECG_DMA_DECIMATION)
+#define ECG_DMA_LPF_HZ          80      // 4th order Butterworth anti-alias before decimation
+#define ECG_DMA_BUF_COUNT       4
+#define ECG_DMA_BUF_LEN         (ECG_DMA_DECIMATION * 8)  // 8 output samples (32ms) per DMA buffer
+#define ECG_DMA_TASK_STACK      3072
+#define ECG_DMA_TASK_PRIORITY   5       // Above loop(), blocks on DMA between buffers
+#define ECG_DMA_TASK_CORE       1
+
+// Acquisition + DSP context. The sensor task wakes on the ECG sample clock,
+// filters, detects and cuts windows, and hands windows and latency reports
+// to loop() through lock-free queues, so BLE, WiFi and serial work in
+// loop() cannot delay a sample. 0 runs the same code from sensorUpdate().
+// ECG_ACQ_POLL has no clock to wake a task and always runs from loop().
+#ifndef SENSOR_TASK
+#define SENSOR_TASK             (ECG_ACQ_MODE != ECG_ACQ_POLL)
+#endif
+#define SENSOR_TASK_STACK       6144
+#define SENSOR_TASK_PRIORITY    4       // Above the PPG task and loop(), below the ECG DMA task
+#define SENSOR_TASK_CORE        1       // WiFi, BLE and the HTTPS sender run on core 0
+#define SENSOR_TASK_TIMEOUT_MS  10      // Run anyway without a sample signal
+#define SENSOR_LATENCY_REPORT_MS 10000  // [LATENCY] log period
+#define SENSOR_LATENCY_BUDGET_US ECG_SAMPLE_PERIOD_US   // Sample filtered before the next is due
 
 // ============================================================
 //  WIFI CONFIGURATION (Phase 4: credentials from NVS via BLE)
@@ -80,15 +167,60 @@
 // ============================================================
 #define API_BASE_URL            "https://sanuka0523-cardiac-monitor-api.hf.space"
 #define API_VITALS_PATH         "/api/v1/vitals"
+#define API_VITALS_BIN_PATH     "/api/v1/vitals/bin"
+#define API_VITALS_BATCH_PATH   "/api/v1/vitals/batch"
 #define API_KEY                 "esp32-cardiac-device-key-2026"
+#define API_PORT                443
 #define API_TIMEOUT_MS          10000
-#define API_MAX_RETRIES         2
+#define API_KEEPALIVE_IDLE_MS   25000   // Reconnect if idle longer (backend keeps 30s)
+#define API_UPLOAD_CHUNK_SIZE   512     // Request body bytes per TLS write
+
+// Upload body format
+//   API_FORMAT_JSON   = ArduinoJson document to API_VITALS_PATH
+//   API_FORMAT_BINARY = packed binary (vitals_payload.h) to API_VITALS_BIN_PATH
+#define API_FORMAT_JSON         0
+#define API_FORMAT_BINARY       1
+#ifndef API_UPLOAD_FORMAT
+#define API_UPLOAD_FORMAT       API_FORMAT_BINARY
+#endif
+
+// Binary format only: Rice-code ECG samples (ecg_codec.h) instead of packed
+// 12-bit. Falls back to packed per window if coding would be larger.
+#ifndef API_ECG_COMPRESSION
+#define API_ECG_COMPRESSION     1
+#endif
 
 // Background data sender task (FreeRTOS)
 #define DATA_SEND_TASK_STACK    12288   // 12KB stack for HTTPS + JSON + TLS
 #define DATA_SEND_TASK_PRIORITY 1       // Low priority (sensor loop is higher)
 #define DATA_SEND_TASK_CORE     0       // Core 0 (Arduino loop runs on Core 1)
-#define DATA_SEND_QUEUE_DEPTH   2       // Buffer up to 2 windows
+#define DATA_SEND_QUEUE_DEPTH   2       // Windows waiting while one is in flight (pool = depth + 1)
+
+// ============================================================
+//  STORE-AND-FORWARD (LittleFS on the "spiffs" partition, 128KB in min_spiffs.csv)
+// ============================================================
+// Windows that cannot be uploaded (WiFi down, NTP not synced, server
+// unreachable) are appended to flash and drained in order by the sender task.
+#define STORE_DIR               "/q"        // Segment files: /q/<first seq, hex>
+#define STORE_SEGMENT_BYTES     16384       // Start a new segment file beyond this
+#define STORE_MAX_BYTES         (96 * 1024) // Drop the oldest segment beyond this
+#define STORE_SEQ_RESERVE       64          // Seq numbers reserved per NVS write
+#define STORE_DRAIN_RETRY_MS    5000        // Backoff after a failed backlog upload
+#define STORE_BATCH_MAX         8           // Stored windows per backlog request (API_VITALS_BATCH_PATH)
+#define NVS_STORE_NAMESPACE     "store"
+
+// ============================================================
+//  ON-DEVICE MODELS (generated src/risk_model_data.h, src/ecg_cnn_data.h)
+// ============================================================
+// Local risk while offline: the XGBoost score and the CNN screen blended
+// like the server ensemble, the CNN standing in for ECGFounder
+#define LOCAL_RISK_CNN_WEIGHT   0.60f
+#define LOCAL_RISK_XGB_WEIGHT   0.40f
+
+// ============================================================
+//  DSP BENCHMARK (serial 'm', native --bench)
+// ============================================================
+#define DSP_BENCH_SAMPLES       10000       // Samples per timing loop and stage
 
 // ============================================================
 //  BLE CONFIGURATION
@@ -111,6 +243,8 @@
 #define BLE_CARDIAC_LABEL_UUID   "0000CC04-1234-5678-9ABC-DEF012345678"
 #define BLE_CARDIAC_STATUS_UUID  "0000CC05-1234-5678-9ABC-DEF012345678"
 #define BLE_CARDIAC_ECG_UUID     "0000CC06-1234-5678-9ABC-DEF012345678"
+#define BLE_CARDIAC_ECG_RICE_UUID "0000CC07-1234-5678-9ABC-DEF012345678"
+#define BLE_CARDIAC_HRV_UUID     "0000CC08-1234-5678-9ABC-DEF012345678"
 
 // BLE Provisioning commands (written to CMD characteristic)
 #define BLE_CMD_CONNECT         0x01
@@ -138,6 +272,10 @@
 // BLE ECG streaming
 #define ECG_BLE_NOTIFY_MS        200     // Send ECG batch every 200ms
 #define ECG_BLE_BATCH_MAX        60      // Max samples per notification (60*2=120 < 123 MTU)
+// Compressed stream (CC07), used instead of CC06 while a client subscribes to it.
+// Frame: [u8 sample count][Rice bitstream]; typically ~5 bits/sample.
+#define ECG_BLE_FRAME_MAX        120     // Notification payload bytes (< 123 MTU)
+#define ECG_BLE_RICE_BATCH_MAX   160     // Max samples offered per compressed frame
 
 // WiFi Scan Configuration
 #define WIFI_SCAN_TIMEOUT_MS        10000
@@ -0,0 +1,96 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// ============================================================
+//  Lock-free single-producer single-consumer ring
+// ============================================================
+// One context pushes and one other context pops: a task, an ISR or
+// esp_timer callback, or a task on the other core. Indices run free (no
+// slot is sacrificed, all N are usable); the producer alone writes head,
+// the consumer alone writes tail. Each side publishes its index with a
+// release store and reads the other one with an acquire load, so the
+// slots written before a push are complete when the pop that sees it
+// reads them. head and tail sit a cache line apart so the two sides do
+// not share one (ESP32 internal RAM is uncached; this is for the host).
+//
+// push()/pop() and the batch forms are wait-free. size() and empty() may
+// be called from any context; the snapshot errs on the safe side for the
+// caller (the producer may see fewer free slots, the consumer fewer items).
+
+#ifndef SPSC_CACHE_LINE
+#define SPSC_CACHE_LINE     64
+#endif
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of 2");
+
+public:
+    SpscRing() : _head(0), _tail(0) {}
+
+    static constexpr size_t capacity() { return N; }
+
+    // --- Producer ---
+    // False when full (the item is not stored)
+    bool push(const T& item) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) == N) return false;
+        _items[head & (N - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // As many of items as fit, in order, published together. Returns the count stored.
+    size_t push(const T* items, size_t count) {
+        uint32_t head = _head.load(std::memory_order_relaxed);
+        size_t space = N - (head - _tail.load(std::memory_order_acquire));
+        if (count > space) count = space;
+        for (size_t i = 0; i < count; i++) _items[(head + i) & (N - 1)] = items[i];
+        _head.store(head + (uint32_t)count, std::memory_order_release);
+        return count;
+    }
+
+    // --- Consumer ---
+    // False when empty
+    bool pop(T& item) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        item = _items[tail & (N - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Up to count of the oldest items, in order. Returns the count taken.
+    size_t pop(T* items, size_t count) {
+        uint32_t tail = _tail.load(std::memory_order_relaxed);
+        size_t available = _head.load(std::memory_order_acquire) - tail;
+        if (count > available) count = available;
+        for (size_t i = 0; i < count; i++) items[i] = _items[(tail + i) & (N - 1)];
+        _tail.store(tail + (uint32_t)count, std::memory_order_release);
+        return count;
+    }
+
+    // --- Either side ---
+    // Tail first: head only grows, so the difference cannot go negative
+    size_t size() const {
+        uint32_t tail = _tail.load(std::memory_order_acquire);
+        return _head.load(std::memory_order_acquire) - tail;
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+private:
+    std::atomic<uint32_t> _head;        // Items pushed since start (producer writes)
+    char _headPad[SPSC_CACHE_LINE - sizeof(std::atomic<uint32_t>)];
+    std::atomic<uint32_t> _tail;        // Items popped since start (consumer writes)
+    char _tailPad[SPSC_CACHE_LINE - sizeof(std::atomic<uint32_t>)];
+    T _items[N];
+};
+
+#endif // SPSC_RING_H
@@ -20,7 +20,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "MAX30100.h"
 
-MAX30100::MAX30100()
+MAX30100::MAX30100() :
+    burstEnabled(false),
+    burstErrors(0),
+    burstReadouts(0),
+    busStats(),
+    overflowCount(0)
 {
 }
 
@@ -82,9 +87,9 @@ void MAX30100::update()
 
 bool MAX30100::getRawValues(uint16_t *ir, uint16_t *red)
 {
-    if (!readoutsBuffer.isEmpty()) {
-        SensorReadout readout = readoutsBuffer.pop();
+    SensorReadout readout;
 
+    if (readoutsBuffer.pop(readout)) {
         *ir = readout.ir;
         *red = readout.red;
 
@@ -106,7 +111,11 @@ uint8_t MAX30100::readRegister(uint8_t address)
     Wire.beginTransmission(MAX30100_I2C_ADDRESS);
     Wire.write(address);
     Wire.endTransmission(false);
-    Wire.requestFrom(MAX30100_I2C_ADDRESS, 1);
+    if (Wire.requestFrom(MAX30100_I2C_ADDRESS, 1) != 1) {
+        busStats.errors++;
+    }
+    busStats.transactions++;
+    busStats.bytes += 4;
 
     return Wire.read();
 }
@@ -116,23 +125,103 @@ void MAX30100::writeRegister(uint8_t address, uint8_t data)
     Wire.beginTransmission(MAX30100_I2C_ADDRESS);
     Wire.write(address);
     Wire.write(data);
-    Wire.endTransmission();
+    if (Wire.endTransmission() != 0) {
+        busStats.errors++;
+    }
+    busStats.transactions++;
+    busStats.bytes += 3;
 }
 
-void MAX30100::burstRead(uint8_t baseAddress, uint8_t *buffer, uint8_t length)
+// Returns the bytes received; anything short of length counts as an error
+uint8_t MAX30100::burstRead(uint8_t baseAddress, uint8_t *buffer, uint8_t length)
 {
+    busStats.transactions++;
+    busStats.bytes += 2;
+
     Wire.beginTransmission(MAX30100_I2C_ADDRESS);
     Wire.write(baseAddress);
-    Wire.endTransmission(false);
+    if (Wire.endTransmission(false) != 0) {
+        busStats.errors++;
+        return 0;
+    }
     Wire.requestFrom((uint8_t)MAX30100_I2C_ADDRESS, length);
 
     uint8_t idx = 0;
     while (Wire.available()) {
-        buffer[idx++] = Wire.read();
+        uint8_t value = Wire.read();
+        if (idx < length) {
+            buffer[idx++] = value;
+        }
+    }
+    busStats.bytes += 1 + idx;
+    if (idx != length) {
+        busStats.errors++;
+    }
+
+    return idx;
+}
+
+// A full ring keeps its oldest readouts and counts the new one as an
+// overflow, so the sample clock still advances over it
+void MAX30100::pushReadout(const uint8_t *buffer)
+{
+    if (!readoutsBuffer.push({
+            .ir=(uint16_t)((buffer[0] << 8) | buffer[1]),
+            .red=(uint16_t)((buffer[2] << 8) | buffer[3])})) {
+        overflowCount++;
     }
 }
 
 void MAX30100::readFifoData()
+{
+    if (burstEnabled) {
+        readFifoBurst();
+    } else {
+        readFifoPerSample();
+    }
+}
+
+// Two transactions whatever the backlog: the write pointer, overflow counter
+// and read pointer (consecutive registers), then every pending sample from
+// FIFO_DATA, which does not auto-increment.
+void MAX30100::readFifoBurst()
+{
+    if (++burstReadouts >= BURST_ERROR_WINDOW) {
+        burstReadouts = 0;
+        burstErrors = 0;
+    }
+
+    uint8_t pointers[3];
+    if (burstRead(MAX30100_REG_FIFO_WRITE_POINTER, pointers, 3) != 3) {
+        noteBurstError();
+        return;
+    }
+
+    // The overflow counter restarts on every pop, so each pass sees only
+    // the samples lost since the previous one. A full FIFO has equal pointers.
+    uint8_t toRead = (pointers[0] - pointers[2]) & (MAX30100_FIFO_DEPTH-1);
+    overflowCount += pointers[1];
+    if (!toRead && pointers[1]) {
+        toRead = MAX30100_FIFO_DEPTH;
+    }
+    if (!toRead) {
+        return;
+    }
+
+    uint8_t buffer[MAX30100_FIFO_DEPTH * 4];
+    uint8_t got = burstRead(MAX30100_REG_FIFO_DATA, buffer, toRead * 4);
+
+    // Whole samples of a short read are still good; the rest are lost
+    for (uint8_t i = 0; i + 4 <= got; i += 4) {
+        pushReadout(buffer + i);
+    }
+
+    if (got != toRead * 4) {
+        noteBurstError();
+    }
+}
+
+void MAX30100::readFifoPerSample()
 {
     uint8_t toRead;
 
@@ -144,26 +233,43 @@ void MAX30100::readFifoData()
         // MAX30100 modules that have weak/incorrect pull-up resistors.
         for (uint8_t i = 0; i < toRead; ++i) {
             uint8_t buffer[4];
-            Wire.beginTransmission(MAX30100_I2C_ADDRESS);
-            Wire.write(MAX30100_REG_FIFO_DATA);
-            Wire.endTransmission(false);
-            uint8_t got = Wire.requestFrom((uint8_t)MAX30100_I2C_ADDRESS, (uint8_t)4);
-            if (got == 4) {
-                buffer[0] = Wire.read();
-                buffer[1] = Wire.read();
-                buffer[2] = Wire.read();
-                buffer[3] = Wire.read();
-                readoutsBuffer.push({
-                    .ir=(uint16_t)((buffer[0] << 8) | buffer[1]),
-                    .red=(uint16_t)((buffer[2] << 8) | buffer[3])});
-            } else {
-                // Drain any partial data
-                while (Wire.available()) Wire.read();
+            if (burstRead(MAX30100_REG_FIFO_DATA, buffer, 4) == 4) {
+                pushReadout(buffer);
             }
         }
     }
 }
 
+void MAX30100::noteBurstError()
+{
+    if (++burstErrors >= BURST_ERROR_LIMIT) {
+        burstEnabled = false;
+        busStats.fallbacks++;
+    }
+}
+
+void MAX30100::setBurstReadEnabled(bool enabled)
+{
+    burstEnabled = enabled;
+    burstErrors = 0;
+    burstReadouts = 0;
+}
+
+bool MAX30100::isBurstReadEnabled()
+{
+    return burstEnabled;
+}
+
+const MAX30100BusStats& MAX30100::getBusStats()
+{
+    return busStats;
+}
+
+uint32_t MAX30100::getOverflowCount()
+{
+    return overflowCount;
+}
+
 void MAX30100::startTemperatureSampling()
 {
     uint8_t modeConfig = readRegister(MAX30100_REG_MODE_CONFIGURATION);
@@ -201,6 +307,21 @@ void MAX30100::resume()
     writeRegister(MAX30100_REG_MODE_CONFIGURATION, modeConfig);
 }
 
+uint8_t MAX30100::getQueuedReadouts()
+{
+    return readoutsBuffer.size();
+}
+
+void MAX30100::setInterruptsEnabled(uint8_t mask)
+{
+    writeRegister(MAX30100_REG_INTERRUPT_ENABLE, mask);
+}
+
+uint8_t MAX30100::getInterruptStatus()
+{
+    return readRegister(MAX30100_REG_INTERRUPT_STATUS);
+}
+
 uint8_t MAX30100::getPartId()
 {
     return readRegister(0xff);
@@ -21,8 +21,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <stdint.h>
 
-#define CIRCULAR_BUFFER_XS
-#include "CircularBuffer.h"
+#include "spsc_ring.h"
 #include "MAX30100_Registers.h"
 
 #define DEFAULT_MODE                MAX30100_MODE_HRONLY
@@ -34,12 +33,24 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #define RINGBUFFER_SIZE             16
 
 #define I2C_BUS_SPEED               400000UL
+#define I2C_FALLBACK_BUS_SPEED      100000UL
+#define BURST_ERROR_LIMIT           3       // Failed bursts within BURST_ERROR_WINDOW readouts
+#define BURST_ERROR_WINDOW          100     //   before falling back to per-sample reads
 
 typedef struct {
     uint16_t ir;
     uint16_t red;
 } SensorReadout;
 
+// Cumulative bus counters. Bytes are everything clocked on the wire for a
+// transaction: address bytes, register pointer and data.
+typedef struct {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t errors;            // NACKs and short reads
+    uint32_t fallbacks;         // Burst mode dropped after BURST_ERROR_LIMIT errors
+} MAX30100BusStats;
+
 class MAX30100 {
 public:
     MAX30100();
@@ -51,6 +62,7 @@ public:
     void setHighresModeEnabled(bool enabled);
     void update();
     bool getRawValues(uint16_t *ir, uint16_t *red);
+    uint8_t getQueuedReadouts();
     void resetFifo();
     void startTemperatureSampling();
     bool isTemperatureReady();
@@ -58,14 +70,39 @@ public:
     void shutdown();
     void resume();
     uint8_t getPartId();
+    // INT pin sources (MAX30100_IE_* bits). The pin stays low until the
+    // status register is read; PWR_RDY is always enabled.
+    void setInterruptsEnabled(uint8_t mask);
+    uint8_t getInterruptStatus();
+    // Read all pending FIFO entries in one transaction instead of one per
+    // sample. The caller sets the bus clock (I2C_BUS_SPEED for burst mode).
+    // After BURST_ERROR_LIMIT errors within BURST_ERROR_WINDOW readouts the
+    // driver turns burst mode off by itself and the caller should drop to
+    // I2C_FALLBACK_BUS_SPEED.
+    void setBurstReadEnabled(bool enabled);
+    bool isBurstReadEnabled();
+    const MAX30100BusStats& getBusStats();
+    // Samples dropped since boot: by the FIFO (burst mode only, the
+    // per-sample mode does not read its overflow counter) or because the
+    // readout ring was full.
+    uint32_t getOverflowCount();
 
 private:
-    CircularBuffer<SensorReadout, RINGBUFFER_SIZE> readoutsBuffer;
+    SpscRing<SensorReadout, RINGBUFFER_SIZE> readoutsBuffer;
+    bool burstEnabled;
+    uint8_t burstErrors;
+    uint8_t burstReadouts;
+    MAX30100BusStats busStats;
+    uint32_t overflowCount;
 
     uint8_t readRegister(uint8_t address);
     void writeRegister(uint8_t address, uint8_t data);
-    void burstRead(uint8_t baseAddress, uint8_t *buffer, uint8_t length);
+    uint8_t burstRead(uint8_t baseAddress, uint8_t *buffer, uint8_t length);
     void readFifoData();
+    void readFifoBurst();
+    void readFifoPerSample();
+    void noteBurstError();
+    void pushReadout(const uint8_t *buffer);
 };
 
 #endif
@@ -38,7 +38,12 @@ BeatDetector::BeatDetector() :
 
 bool BeatDetector::addSample(float sample)
 {
-    return checkForBeat(sample);
+    return checkForBeat(sample, millis());
+}
+
+bool BeatDetector::addSample(float sample, uint32_t timestampMs)
+{
+    return checkForBeat(sample, timestampMs);
 }
 
 float BeatDetector::getRate()
@@ -55,13 +60,13 @@ float BeatDetector::getCurrentThreshold()
     return threshold;
 }
 
-bool BeatDetector::checkForBeat(float sample)
+bool BeatDetector::checkForBeat(float sample, uint32_t now)
 {
     bool beatDetected = false;
 
     switch (state) {
         case BEATDETECTOR_STATE_INIT:
-            if (millis() > BEATDETECTOR_INIT_HOLDOFF) {
+            if (now > BEATDETECTOR_INIT_HOLDOFF) {
                 state = BEATDETECTOR_STATE_WAITING;
             }
             break;
@@ -73,7 +78,7 @@ bool BeatDetector::checkForBeat(float sample)
             }
 
             // Tracking lost, resetting
-            if (millis() - tsLastBeat > BEATDETECTOR_INVALID_READOUT_DELAY) {
+            if (now - tsLastBeat > BEATDETECTOR_INVALID_READOUT_DELAY) {
                 beatPeriod = 0;
                 lastMaxValue = 0;
             }
@@ -95,20 +100,20 @@ bool BeatDetector::checkForBeat(float sample)
                 beatDetected = true;
                 lastMaxValue = sample;
                 state = BEATDETECTOR_STATE_MASKING;
-                float delta = millis() - tsLastBeat;
+                float delta = now - tsLastBeat;
                 if (delta) {
                     beatPeriod = BEATDETECTOR_BPFILTER_ALPHA * delta +
                             (1 - BEATDETECTOR_BPFILTER_ALPHA) * beatPeriod;
                 }
 
-                tsLastBeat = millis();
+                tsLastBeat = now;
             } else {
                 state = BEATDETECTOR_STATE_FOLLOWING_SLOPE;
             }
             break;
 
         case BEATDETECTOR_STATE_MASKING:
-            if (millis() - tsLastBeat > BEATDETECTOR_MASKING_HOLDOFF) {
+            if (now - tsLastBeat > BEATDETECTOR_MASKING_HOLDOFF) {
                 state = BEATDETECTOR_STATE_WAITING;
             }
             decreaseThreshold();
@@ -47,11 +47,13 @@ class BeatDetector
 public:
     BeatDetector();
     bool addSample(float sample);
+    // Same, timed by the caller (e.g. sample index / Fs) instead of millis()
+    bool addSample(float sample, uint32_t timestampMs);
     float getRate();
     float getCurrentThreshold();
 
 private:
-    bool checkForBeat(float value);
+    bool checkForBeat(float value, uint32_t now);
     void decreaseThreshold();
 
     BeatDetectorState state;
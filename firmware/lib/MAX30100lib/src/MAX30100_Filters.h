@@ -28,6 +28,7 @@ class  FilterBuLp1
 		FilterBuLp1()
 		{
 			v[0]=0.0;
+			v[1]=0.0;
 		}
 	private:
 		float v[2];
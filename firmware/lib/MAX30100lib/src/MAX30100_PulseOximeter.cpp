@@ -29,6 +29,9 @@ PulseOximeter::PulseOximeter() :
     tsLastCurrentAdjustment(0),
     redLedCurrentIndex((uint8_t)RED_LED_CURRENT_START),
     irLedCurrent(DEFAULT_IR_LED_CURRENT),
+    sampleClockEnabled(false),
+    sampleCount(0),
+    overflowsSeen(0),
     onBeatDetected(NULL)
 {
 }
@@ -101,10 +104,50 @@ void PulseOximeter::resume()
     hrm.resume();
 }
 
+void PulseOximeter::setBurstReadEnabled(bool enabled)
+{
+    hrm.setBurstReadEnabled(enabled);
+}
+
+bool PulseOximeter::isBurstReadEnabled()
+{
+    return hrm.isBurstReadEnabled();
+}
+
+const MAX30100BusStats& PulseOximeter::getBusStats()
+{
+    return hrm.getBusStats();
+}
+
+void PulseOximeter::setInterruptsEnabled(uint8_t mask)
+{
+    hrm.setInterruptsEnabled(mask);
+}
+
+uint8_t PulseOximeter::getInterruptStatus()
+{
+    return hrm.getInterruptStatus();
+}
+
+void PulseOximeter::setSampleClockEnabled(bool enabled)
+{
+    sampleClockEnabled = enabled;
+}
+
+uint8_t PulseOximeter::getQueuedSamples()
+{
+    return hrm.getQueuedReadouts();
+}
+
 void PulseOximeter::checkSample()
 {
     uint16_t rawIRValue, rawRedValue;
 
+    // Samples the FIFO dropped came before this batch
+    uint32_t overflows = hrm.getOverflowCount();
+    sampleCount += overflows - overflowsSeen;
+    overflowsSeen = overflows;
+
     // Dequeue all available samples, they're properly timed by the HRM
     while (hrm.getRawValues(&rawIRValue, &rawRedValue)) {
         float irACValue = irDCRemover.step(rawIRValue);
@@ -112,7 +155,14 @@ void PulseOximeter::checkSample()
 
         // The signal fed to the beat detector is mirrored since the cleanest monotonic spike is below zero
         float filteredPulseValue = lpf.step(-irACValue);
-        bool beatDetected = beatDetector.addSample(filteredPulseValue);
+        bool beatDetected;
+        if (sampleClockEnabled) {
+            uint32_t sampleMs = (uint32_t)((uint64_t)sampleCount * 1000 / SAMPLING_FREQUENCY);
+            beatDetected = beatDetector.addSample(filteredPulseValue, sampleMs);
+        } else {
+            beatDetected = beatDetector.addSample(filteredPulseValue);
+        }
+        ++sampleCount;
 
         if (beatDetector.getRate() > 0) {
             state = PULSEOXIMETER_STATE_DETECTING;
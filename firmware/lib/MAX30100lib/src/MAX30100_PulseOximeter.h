@@ -59,6 +59,18 @@ public:
     void setIRLedCurrent(LEDCurrent irLedCurrent);
     void shutdown();
     void resume();
+    void setBurstReadEnabled(bool enabled);
+    bool isBurstReadEnabled();
+    const MAX30100BusStats& getBusStats();
+    void setInterruptsEnabled(uint8_t mask);
+    uint8_t getInterruptStatus();
+    // Time beats by sample count (1000 / SAMPLING_FREQUENCY ms per sample,
+    // FIFO overflows included) instead of millis() at drain time, so beat
+    // periods do not depend on when update() runs
+    void setSampleClockEnabled(bool enabled);
+    // Samples read after the one being processed: in the beat callback, how
+    // many sample periods the beat precedes the newest readout
+    uint8_t getQueuedSamples();
 
 private:
     void checkSample();
@@ -78,6 +90,9 @@ private:
     LEDCurrent irLedCurrent;
     SpO2Calculator spO2calculator;
     MAX30100 hrm;
+    bool sampleClockEnabled;
+    uint32_t sampleCount;
+    uint32_t overflowsSeen;
 
     void (*onBeatDetected)();
 };
@@ -0,0 +1,292 @@
+#include "api_client.h"
+#include "config.h"
+#include "hal.h"
+
+#if WIFI_MODE_ENABLED
+static char      _host[64] = {0};
+static bool      _connected = false;
+static bool      _closeAfterResponse = false;
+static uint32_t  _lastUseMs = 0;
+static uint32_t  _phaseStartMs = 0;
+static ApiTiming _timing = {};
+
+// Response body view over the connection, limited to Content-Length
+class BodyStream : public Stream {
+public:
+    void begin(int32_t length) { _remaining = length; }
+    int32_t remaining() const { return _remaining; }
+
+    int available() override {
+        if (_remaining == 0) return 0;
+        int n = halNetAvailable();
+        return (_remaining > 0 && n > _remaining) ? _remaining : n;
+    }
+    int read() override {
+        if (_remaining == 0) return -1;
+        int c = halNetRead();
+        if (c >= 0 && _remaining > 0) _remaining--;
+        return c;
+    }
+    int peek() override {
+        return _remaining == 0 ? -1 : halNetPeek();
+    }
+    using Stream::readBytes;
+    size_t readBytes(char* buffer, size_t length) override {
+        // Never wait for bytes past the end of the body
+        if (_remaining >= 0 && length > (size_t)_remaining) length = _remaining;
+        return length ? Stream::readBytes(buffer, length) : 0;
+    }
+    size_t write(uint8_t) override { return 0; }
+
+private:
+    int32_t _remaining = 0;     // -1 = until the server closes the connection
+};
+static BodyStream _body;
+
+static bool sendRaw(const uint8_t* data, size_t len);
+
+// Request body sink, sent in API_UPLOAD_CHUNK_SIZE pieces
+class RequestBody : public Print {
+public:
+    void begin(size_t declared) {
+        _declared = declared;
+        _written = 0;
+        _fill = 0;
+        _failed = false;
+    }
+    size_t write(uint8_t c) override {
+        return write(&c, 1);
+    }
+    size_t write(const uint8_t* data, size_t len) override {
+        if (_failed) return 0;
+        size_t done = 0;
+        while (done < len) {
+            size_t n = len - done;
+            if (n > sizeof(_chunk) - _fill) n = sizeof(_chunk) - _fill;
+            memcpy(_chunk + _fill, data + done, n);
+            _fill += n;
+            done += n;
+            if (_fill == sizeof(_chunk) && !flush()) return 0;
+        }
+        _written += len;
+        return len;
+    }
+    bool flush() {
+        if (_fill > 0 && !_failed) {
+            _failed = !sendRaw(_chunk, _fill);
+            _fill = 0;
+        }
+        return !_failed;
+    }
+    bool complete() { return flush() && _written == _declared; }
+
+private:
+    uint8_t _chunk[API_UPLOAD_CHUNK_SIZE];
+    size_t  _fill = 0;
+    size_t  _declared = 0;
+    size_t  _written = 0;
+    bool    _failed = false;
+};
+static RequestBody _request;
+
+// ============================================================
+//  Connection
+// ============================================================
+static const char* apiHost() {
+    if (_host[0] == '\0') {
+        const char* p = strstr(API_BASE_URL, "://");
+        p = p ? p + 3 : API_BASE_URL;
+        size_t n = strcspn(p, ":/");
+        if (n >= sizeof(_host)) n = sizeof(_host) - 1;
+        memcpy(_host, p, n);
+        _host[n] = '\0';
+    }
+    return _host;
+}
+
+static bool ensureConnected() {
+    if (_connected && halMillis() - _lastUseMs > API_KEEPALIVE_IDLE_MS) {
+        Serial.println("[API] Keep-alive idle too long, reconnecting");
+        apiClose();
+    }
+    if (_connected && !halNetConnected()) {
+        Serial.println("[API] Server closed keep-alive connection");
+        apiClose();
+    }
+    if (_connected) {
+        _timing.reused = true;
+        return true;
+    }
+
+    uint32_t t0 = halMillis();
+    if (!halNetResolve(apiHost())) {
+        Serial.printf("[API] DNS lookup failed for %s\n", apiHost());
+        return false;
+    }
+    uint32_t t1 = halMillis();
+
+    if (!halNetConnect(apiHost(), API_PORT, API_TIMEOUT_MS)) {
+        Serial.printf("[API] TLS connect to %s failed\n", apiHost());
+        return false;
+    }
+    uint32_t t2 = halMillis();
+
+    _connected = true;
+    _timing.dnsMs = (uint16_t)(t1 - t0);
+    _timing.connectMs = (uint16_t)(t2 - t1);
+    Serial.printf("[API] Connected to %s (dns %lums, tcp+tls %lums)\n",
+                  apiHost(), (unsigned long)(t1 - t0), (unsigned long)(t2 - t1));
+    return true;
+}
+
+// Read one header line (CRLF stripped, overlong lines truncated)
+static bool readLine(char* buf, size_t size) {
+    size_t n = 0;
+    uint32_t start = halMillis();
+    while (halMillis() - start < API_TIMEOUT_MS) {
+        int c = halNetRead();
+        if (c < 0) {
+            if (!halNetConnected() && !halNetAvailable()) return false;
+            halDelay(1);
+            continue;
+        }
+        if (c == '\n') {
+            if (n > 0 && buf[n - 1] == '\r') n--;
+            buf[n] = '\0';
+            return true;
+        }
+        if (n + 1 < size) buf[n++] = (char)c;
+    }
+    return false;
+}
+
+static bool headerIs(const char* line, const char* name, const char** value) {
+    size_t len = strlen(name);
+    if (strncasecmp(line, name, len) != 0 || line[len] != ':') return false;
+    const char* v = line + len + 1;
+    while (*v == ' ') v++;
+    *value = v;
+    return true;
+}
+
+// ============================================================
+//  Public API
+// ============================================================
+bool apiBeginRequest(const char* path, const char* contentType, size_t contentLength) {
+    memset(&_timing, 0, sizeof(_timing));
+    if (!ensureConnected()) return false;
+
+    _phaseStartMs = halMillis();
+    char head[256];
+    int n = snprintf(head, sizeof(head),
+                     "POST %s HTTP/1.1\r\n"
+                     "Host: %s\r\n"
+                     "Connection: keep-alive\r\n"
+                     "Content-Type: %s\r\n"
+                     "Content-Length: %u\r\n"
+                     "X-API-Key: %s\r\n"
+                     "\r\n",
+                     path, apiHost(), contentType, (unsigned)contentLength, API_KEY);
+    if (n <= 0 || (size_t)n >= sizeof(head)) return false;
+    _request.begin(contentLength);
+    return sendRaw((const uint8_t*)head, n);
+}
+
+Print& apiRequestBody() {
+    return _request;
+}
+
+static bool sendRaw(const uint8_t* data, size_t len) {
+    if (halNetWrite(data, len) != len) {
+        Serial.println("[API] Write failed, closing connection");
+        apiClose();
+        return false;
+    }
+    return true;
+}
+
+int apiReadResponseHead() {
+    if (!_request.complete()) {
+        Serial.println("[API] Request body incomplete, closing connection");
+        apiClose();
+        return -1;
+    }
+    uint32_t sentMs = halMillis();
+    _timing.sendMs = (uint16_t)(sentMs - _phaseStartMs);
+
+    while (!halNetAvailable()) {
+        if (!halNetConnected() || halMillis() - sentMs >= API_TIMEOUT_MS) {
+            Serial.println("[API] No response, closing connection");
+            apiClose();
+            return -1;
+        }
+        halDelay(2);
+    }
+    _phaseStartMs = halMillis();
+    _timing.waitMs = (uint16_t)(_phaseStartMs - sentMs);
+
+    char line[128];
+    int status = 0;
+    if (!readLine(line, sizeof(line)) || sscanf(line, "HTTP/1.%*d %d", &status) != 1) {
+        Serial.println("[API] Bad status line, closing connection");
+        apiClose();
+        return -1;
+    }
+
+    int32_t length = -1;
+    _closeAfterResponse = false;
+    while (true) {
+        if (!readLine(line, sizeof(line))) {
+            apiClose();
+            return -1;
+        }
+        if (line[0] == '\0') break;
+
+        const char* value;
+        if (headerIs(line, "Content-Length", &value)) {
+            length = atol(value);
+        } else if (headerIs(line, "Connection", &value)) {
+            if (strncasecmp(value, "close", 5) == 0) _closeAfterResponse = true;
+        } else if (headerIs(line, "Transfer-Encoding", &value)) {
+            Serial.println("[API] Chunked response not supported");
+            _closeAfterResponse = true;
+        }
+    }
+
+    // Without a length the body ends when the server closes
+    if (length < 0) _closeAfterResponse = true;
+    _body.begin(length);
+    _body.setTimeout(API_TIMEOUT_MS);
+    return status;
+}
+
+Stream& apiResponseBody() {
+    return _body;
+}
+
+void apiEndResponse() {
+    // Leave the stream at a message boundary for the next request
+    if (!_closeAfterResponse) {
+        uint8_t scratch[64];
+        while (_body.remaining() > 0) {
+            if (_body.readBytes((char*)scratch, sizeof(scratch)) == 0) break;
+        }
+        if (_body.remaining() > 0) _closeAfterResponse = true;
+    }
+
+    _timing.receiveMs = (uint16_t)(halMillis() - _phaseStartMs);
+    _lastUseMs = halMillis();
+    if (_closeAfterResponse) apiClose();
+}
+
+void apiClose() {
+    halNetClose();
+    _connected = false;
+    _body.begin(0);
+}
+
+const ApiTiming& apiLastTiming() {
+    return _timing;
+}
+
+#endif // WIFI_MODE_ENABLED
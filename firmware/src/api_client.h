@@ -0,0 +1,49 @@
+#ifndef API_CLIENT_H
+#define API_CLIENT_H
+
+#include <Arduino.h>
+
+// ============================================================
+//  Persistent HTTPS connection to the API host (keep-alive)
+// ============================================================
+// Owned by the DataSender task: not thread safe. The TLS connection is
+// opened on first use and kept across requests; it is only torn down on an
+// I/O error, a "Connection: close" response or after API_KEEPALIVE_IDLE_MS
+// without traffic (before the server's own idle timeout fires).
+
+// Per-request phase timing (ms)
+struct ApiTiming {
+    uint16_t dnsMs;         // Hostname lookup (0 when reused)
+    uint16_t connectMs;     // TCP connect + TLS handshake (0 when reused)
+    uint16_t sendMs;        // Request head + body written
+    uint16_t waitMs;        // Last body byte to first response byte
+    uint16_t receiveMs;     // Response head + body read
+    bool     reused;        // Request went over an already open connection
+};
+
+// Open the connection if needed and write the request head.
+// Returns false on DNS/connect/write failure (connection is closed).
+bool apiBeginRequest(const char* path, const char* contentType, size_t contentLength);
+
+// Request body sink: buffers API_UPLOAD_CHUNK_SIZE bytes per socket write.
+// Exactly contentLength bytes must be written before apiReadResponseHead().
+Print& apiRequestBody();
+
+// Flush the body, then wait for and parse the response status line +
+// headers. Returns the HTTP status code, or -1 on a write failure, body
+// length mismatch, timeout or network error (connection is closed).
+int apiReadResponseHead();
+
+// Response body, bounded by Content-Length. Valid until apiEndResponse().
+Stream& apiResponseBody();
+
+// Discard any unread body and finish the request timing. Keeps the
+// connection open unless the server asked to close it.
+void apiEndResponse();
+
+// Close the connection (next request reconnects).
+void apiClose();
+
+const ApiTiming& apiLastTiming();
+
+#endif // API_CLIENT_H
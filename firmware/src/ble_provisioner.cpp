@@ -1,6 +1,8 @@
 #include "ble_provisioner.h"
 #include "config.h"
 #include "wifi_manager.h"
+#include "ecg_codec.h"
+#include "spsc_ring.h"
 
 #include <NimBLEDevice.h>
 #include <Preferences.h>
@@ -10,7 +12,7 @@
 #endif
 
 // ============================================================
-//  Event Ring Buffer (single-producer single-consumer, ISR-safe)
+//  Event Queue (NimBLE host task -> loop)
 // ============================================================
 enum BleEventType {
     BLE_EVT_NONE = 0,
@@ -22,23 +24,16 @@ enum BleEventType {
 };
 
 #define BLE_EVT_QUEUE_SIZE 8
-static volatile BleEventType _evtQueue[BLE_EVT_QUEUE_SIZE];
-static volatile uint8_t _evtHead = 0;
-static volatile uint8_t _evtTail = 0;
+static SpscRing<BleEventType, BLE_EVT_QUEUE_SIZE> _evtQueue;
 
+// Dropped when full: loop() drains every pass, 8 pending events means it is stuck
 static void evtPush(BleEventType evt) {
-    uint8_t next = (_evtHead + 1) % BLE_EVT_QUEUE_SIZE;
-    if (next != _evtTail) {
-        _evtQueue[_evtHead] = evt;
-        _evtHead = next;
-    }
+    _evtQueue.push(evt);
 }
 
 static BleEventType evtPoll() {
-    if (_evtTail == _evtHead) return BLE_EVT_NONE;
-    BleEventType evt = _evtQueue[_evtTail];
-    _evtTail = (_evtTail + 1) % BLE_EVT_QUEUE_SIZE;
-    return evt;
+    BleEventType evt;
+    return _evtQueue.pop(evt) ? evt : BLE_EVT_NONE;
 }
 
 // ============================================================
@@ -60,6 +55,9 @@ static NimBLECharacteristic* _pRiskChar = nullptr;
 static NimBLECharacteristic* _pLabelChar = nullptr;
 static NimBLECharacteristic* _pDevStatusChar = nullptr;
 static NimBLECharacteristic* _pEcgChar = nullptr;
+static NimBLECharacteristic* _pEcgRiceChar = nullptr;
+static NimBLECharacteristic* _pHrvChar = nullptr;
+static volatile bool _ecgRiceSubscribed = false;
 
 // WiFi scan state machine
 enum WifiScanState { WSCAN_IDLE, WSCAN_RUNNING, WSCAN_SENDING };
@@ -84,6 +82,7 @@ class ServerCallbacks : public NimBLEServerCallbacks {
 
     void onDisconnect(NimBLEServer* pServer, NimBLEConnInfo& connInfo, int reason) override {
         _clientConnected = false;
+        _ecgRiceSubscribed = false;
         evtPush(BLE_EVT_CLIENT_DISCONNECTED);
         Serial.printf("[BLE] Client disconnected (reason=%d)\n", reason);
         NimBLEDevice::getAdvertising()->start();
@@ -124,8 +123,18 @@ class ProvCallbacks : public NimBLECharacteristicCallbacks {
     }
 };
 
-static ServerCallbacks _serverCb;
-static ProvCallbacks   _provCb;
+class EcgRiceCallbacks : public NimBLECharacteristicCallbacks {
+    void onSubscribe(NimBLECharacteristic* pChar, NimBLEConnInfo& connInfo,
+                     uint16_t subValue) override {
+        _ecgRiceSubscribed = (subValue != 0);
+        Serial.printf("[BLE] Compressed ECG stream %s\n",
+                      _ecgRiceSubscribed ? "subscribed" : "unsubscribed");
+    }
+};
+
+static ServerCallbacks  _serverCb;
+static ProvCallbacks    _provCb;
+static EcgRiceCallbacks _ecgRiceCb;
 
 // ============================================================
 //  NVS Functions
@@ -223,11 +232,39 @@ void bleNotifyDeviceStatus(uint8_t statusBits) {
     _pDevStatusChar->notify();
 }
 
-void bleNotifyEcgBatch(const uint16_t* samples, uint8_t count) {
-    if (!_pEcgChar || !_clientConnected || count == 0) return;
+void bleNotifyHrv(const HrvFeatures& hrv) {
+    if (!_pHrvChar) return;
+    uint8_t buf[HRV_PACKED_SIZE];
+    _pHrvChar->setValue(buf, hrvPack(hrv, buf));
+    if (_clientConnected) _pHrvChar->notify();
+}
+
+uint8_t bleNotifyEcgBatch(const uint16_t* samples, uint8_t count) {
+    if (!_clientConnected || count == 0) return 0;
+
+    if (_ecgRiceSubscribed && _pEcgRiceChar) {
+        // Encode as many whole codec blocks as fit in one notification
+        uint8_t frame[ECG_BLE_FRAME_MAX];
+        EcgRiceEncoder enc;
+        enc.begin(frame + 1, sizeof(frame) - 1);
+        uint16_t sent = enc.encode(samples, count);
+        if (sent == 0) return 0;
+        frame[0] = (uint8_t)sent;
+        _pEcgRiceChar->setValue(frame, 1 + enc.finish());
+        _pEcgRiceChar->notify();
+        return (uint8_t)sent;
+    }
+
+    if (!_pEcgChar) return 0;
+    if (count > ECG_BLE_BATCH_MAX) count = ECG_BLE_BATCH_MAX;
     // ESP32 is little-endian, so uint16_t array is already in LE byte order
     _pEcgChar->setValue((const uint8_t*)samples, count * sizeof(uint16_t));
     _pEcgChar->notify();
+    return count;
+}
+
+uint8_t bleEcgBatchMax() {
+    return _ecgRiceSubscribed && _pEcgRiceChar ? ECG_BLE_RICE_BATCH_MAX : ECG_BLE_BATCH_MAX;
 }
 
 // ============================================================
@@ -335,6 +372,17 @@ BleBootMode bleInit() {
         NIMBLE_PROPERTY::NOTIFY
     );
 
+    _pEcgRiceChar = pCardSvc->createCharacteristic(
+        BLE_CARDIAC_ECG_RICE_UUID,
+        NIMBLE_PROPERTY::NOTIFY
+    );
+    _pEcgRiceChar->setCallbacks(&_ecgRiceCb);
+
+    _pHrvChar = pCardSvc->createCharacteristic(
+        BLE_CARDIAC_HRV_UUID,
+        NIMBLE_PROPERTY::READ | NIMBLE_PROPERTY::NOTIFY
+    );
+
     pCardSvc->start();
 
     // 5. Check NVS for stored credentials
@@ -2,6 +2,7 @@
 #define BLE_PROVISIONER_H
 
 #include <Arduino.h>
+#include "hrv.h"
 
 // Boot mode determined by NVS credential check
 enum BleBootMode {
@@ -34,7 +35,15 @@ void        bleNotifyHeartRate(float hr);
 void        bleNotifySpO2(uint8_t spo2);
 void        bleNotifyRisk(float score, const char* label);
 void        bleNotifyDeviceStatus(uint8_t statusBits);
-void        bleNotifyEcgBatch(const uint16_t* samples, uint8_t count);
+
+// HRV of the last window (hrvPack() layout), once per window
+void        bleNotifyHrv(const HrvFeatures& hrv);
+
+// Sends one ECG notification: Rice-coded on CC07 if subscribed, raw uint16 on
+// CC06 otherwise. Returns the samples actually sent (may be < count).
+uint8_t     bleNotifyEcgBatch(const uint16_t* samples, uint8_t count);
+// Most samples one bleNotifyEcgBatch() call can send in the active format
+uint8_t     bleEcgBatchMax();
 
 // Update provisioning status characteristic
 void        bleSetProvisioningStatus(uint8_t status);
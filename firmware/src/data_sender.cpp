@@ -1,25 +1,33 @@
 #include "data_sender.h"
 #include "config.h"
-
-#include <freertos/FreeRTOS.h>
-#include <freertos/task.h>
-#include <freertos/queue.h>
+#include "window_pool.h"
+#include "vitals_payload.h"
+#include "hal.h"
 
 #if WIFI_MODE_ENABLED
-#include <WiFi.h>
-#include <WiFiClientSecure.h>
-#include <HTTPClient.h>
 #include <ArduinoJson.h>
+#include "api_client.h"
+#include "wifi_manager.h"
+#include "window_store.h"
+#endif
+
+#if API_UPLOAD_FORMAT == API_FORMAT_BINARY
+#define UPLOAD_PATH         API_VITALS_BIN_PATH
+#define UPLOAD_CONTENT_TYPE "application/octet-stream"
+#define UPLOAD_FORMAT_NAME  "binary"
+#else
+#define UPLOAD_PATH         API_VITALS_PATH
+#define UPLOAD_CONTENT_TYPE "application/json"
+#define UPLOAD_FORMAT_NAME  "json"
 #endif
 
 static int _lastHttpCode = 0;
 static uint32_t _successCount = 0;
 static uint32_t _failCount = 0;
 
-// FreeRTOS async sending
-static QueueHandle_t _sendQueue = nullptr;
-static QueueHandle_t _resultQueue = nullptr;
-static TaskHandle_t  _sendTaskHandle = nullptr;
+// Async sending (FreeRTOS queues + task via hal.h)
+static HalQueue _sendQueue = nullptr;
+static HalQueue _resultQueue = nullptr;
 
 void dataSenderInit() {
     _lastHttpCode = 0;
@@ -27,186 +35,334 @@ void dataSenderInit() {
     _failCount = 0;
 }
 
-SendResult dataSenderPost(const SensorWindow& window,
-                          const char* deviceId,
-                          time_t timestamp,
-                          PredictionResult& prediction) {
-    prediction.valid = false;
-
-#if !WIFI_MODE_ENABLED
-    return SEND_NOT_READY;
+#if WIFI_MODE_ENABLED
+static size_t writeBody(const SensorWindow& window, const char* deviceId,
+                        time_t timestamp, uint32_t seq, Print& out) {
+#if API_UPLOAD_FORMAT == API_FORMAT_BINARY
+    return vitalsWriteBinary(window, deviceId, timestamp, seq, out);
 #else
+    return vitalsWriteJson(window, deviceId, timestamp, seq, out);
+#endif
+}
+#endif
 
-    // --- Build JSON payload ---
-    JsonDocument doc;
-
-    doc["device_id"] = deviceId;
-    doc["timestamp"] = (long long)timestamp;
-    doc["window_ms"] = ECG_WINDOW_MS;
-    doc["sample_rate_hz"] = ECG_SAMPLE_RATE_HZ;
-    doc["heart_rate_bpm"] = round(window.heartRateBpm * 10.0f) / 10.0f;
-    doc["spo2_percent"] = window.spo2Percent;
-    doc["ecg_lead_off"] = window.ecgLeadOff;
+#if WIFI_MODE_ENABLED
+// Read the response to a request whose body has been written. A 200/201
+// body is parsed straight off the socket into doc, keeping only the fields
+// in filter (the echoed ecg_samples array is skipped, never buffered).
+static SendResult readResponse(JsonDocument& filter, JsonDocument& doc) {
+    int httpCode = apiReadResponseHead();
+    _lastHttpCode = httpCode;
 
-    JsonArray ecgArr = doc["ecg_samples"].to<JsonArray>();
-    for (uint16_t i = 0; i < window.ecgSampleCount; i++) {
-        ecgArr.add(window.ecgSamples[i]);
+    if (httpCode <= 0) {
+        Serial.println("[SEND] POST failed: no response");
+        _failCount++;
+        return SEND_NETWORK_ERROR;
     }
 
-    JsonArray beatArr = doc["beat_timestamps_ms"].to<JsonArray>();
-    for (uint8_t i = 0; i < window.beatCount; i++) {
-        beatArr.add(window.beatTimestampsMs[i]);
-    }
+    Serial.printf("[SEND] HTTP %d\n", httpCode);
 
-    // Serialize to String
-    String jsonPayload;
-    size_t jsonSize = measureJson(doc);
-    if (!jsonPayload.reserve(jsonSize + 1)) {
-        Serial.println("[SEND] JSON allocation failed!");
+    SendResult result;
+    if (httpCode == 200 || httpCode == 201) {
+        DeserializationError err = deserializeJson(doc, apiResponseBody(),
+                                                   DeserializationOption::Filter(filter));
+        if (err) {
+            Serial.printf("[SEND] Response parse error: %s\n", err.c_str());
+        }
+
+        _successCount++;
+        result = SEND_OK;
+    } else {
+        char errorBody[128];
+        size_t n = apiResponseBody().readBytes(errorBody, sizeof(errorBody) - 1);
+        errorBody[n] = '\0';
+        Serial.printf("[SEND] Server error: %s\n", errorBody);
         _failCount++;
-        return SEND_JSON_ERROR;
+        result = SEND_HTTP_ERROR;
     }
-    serializeJson(doc, jsonPayload);
+    apiEndResponse();
 
-    Serial.printf("[SEND] Payload: %u bytes, %u samples, %u beats\n",
-                  jsonPayload.length(), window.ecgSampleCount, window.beatCount);
+    const ApiTiming& t = apiLastTiming();
+    Serial.printf("[SEND] Timing: dns=%u tcp+tls=%u send=%u wait=%u recv=%u ms (%s)\n",
+                  t.dnsMs, t.connectMs, t.sendMs, t.waitMs, t.receiveMs,
+                  t.reused ? "reused" : "new connection");
+    return result;
+}
+#endif
 
-    // Free JsonDocument before HTTP
-    doc.clear();
+SendResult dataSenderPost(const SensorWindow& window,
+                          const char* deviceId,
+                          time_t timestamp,
+                          uint32_t seq,
+                          PredictionResult& prediction) {
+    prediction.valid = false;
 
-    // --- HTTPS POST ---
-    WiFiClientSecure client;
-    client.setInsecure();  // Skip TLS cert verification (dev mode)
+#if !WIFI_MODE_ENABLED
+    return SEND_NOT_READY;
+#else
+    // --- Stream the body: one pass to measure, one into the socket ---
+    PayloadCounter counter;
+    size_t bodyLen = writeBody(window, deviceId, timestamp, seq, counter);
 
-    HTTPClient http;
-    String url = String(API_BASE_URL) + API_VITALS_PATH;
+    Serial.printf("[SEND] Payload: %lu bytes (%s), %u samples, %u beats\n",
+                  (unsigned long)bodyLen, UPLOAD_FORMAT_NAME, window.ecgSampleCount, window.beatCount);
 
-    if (!http.begin(client, url)) {
-        Serial.println("[SEND] HTTP begin failed!");
+    if (!apiBeginRequest(UPLOAD_PATH, UPLOAD_CONTENT_TYPE, bodyLen)) {
+        Serial.println("[SEND] Request failed (connect/write)");
+        _lastHttpCode = -1;
         _failCount++;
         return SEND_NETWORK_ERROR;
     }
+    writeBody(window, deviceId, timestamp, seq, apiRequestBody());
+
+    JsonDocument filter;
+    filter["prediction"] = true;
+    JsonDocument respDoc;
+    SendResult result = readResponse(filter, respDoc);
+
+    if (respDoc["prediction"].is<JsonObject>()) {
+        JsonObject pred = respDoc["prediction"];
+        prediction.riskScore = pred["risk_score"] | 0.0f;
+        prediction.confidence = pred["confidence"] | 0.0f;
+        const char* label = pred["risk_label"] | "unknown";
+        strncpy(prediction.riskLabel, label, sizeof(prediction.riskLabel) - 1);
+        prediction.riskLabel[sizeof(prediction.riskLabel) - 1] = '\0';
+        prediction.valid = true;
+
+        Serial.printf("[SEND] Risk: %s (score=%.3f, conf=%.3f)\n",
+            prediction.riskLabel, prediction.riskScore, prediction.confidence);
+    }
+    return result;
 
-    http.setTimeout(API_TIMEOUT_MS);
-    http.addHeader("Content-Type", "application/json");
-    http.addHeader("X-API-Key", API_KEY);
+#endif // WIFI_MODE_ENABLED
+}
 
-    int httpCode = http.POST(jsonPayload);
-    _lastHttpCode = httpCode;
+#if WIFI_MODE_ENABLED
+// Upload stored windows in one request (always the binary format).
+// Records with timestamps[i] == 0 are left out of the body. On success
+// results holds one entry per included record, in order: "id" when the
+// server stored it, "error" when it refused that record.
+static SendResult postBatch(const StoreRecord* recs, const time_t* timestamps,
+                            uint8_t count, uint8_t included, JsonDocument& results) {
+    size_t bodyLen = VITALS_BATCH_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++) {
+        if (timestamps[i]) bodyLen += 2 + recs[i].length;
+    }
 
-    // Free payload before parsing response
-    jsonPayload = "";
+    Serial.printf("[SEND] Backlog: %u windows, %lu bytes (%lu pending)\n",
+                  included, (unsigned long)bodyLen, (unsigned long)storePendingCount());
 
-    if (httpCode <= 0) {
-        Serial.printf("[SEND] POST failed: %s\n", http.errorToString(httpCode).c_str());
-        http.end();
+    if (!apiBeginRequest(API_VITALS_BATCH_PATH, "application/octet-stream", bodyLen)) {
+        Serial.println("[SEND] Request failed (connect/write)");
+        _lastHttpCode = -1;
         _failCount++;
         return SEND_NETWORK_ERROR;
     }
 
-    Serial.printf("[SEND] HTTP %d\n", httpCode);
-
-    if (httpCode == 200 || httpCode == 201) {
-        String response = http.getString();
-        http.end();
-
-        JsonDocument respDoc;
-        DeserializationError err = deserializeJson(respDoc, response);
-        if (err) {
-            Serial.printf("[SEND] Response parse error: %s\n", err.c_str());
-        } else if (respDoc["prediction"].is<JsonObject>()) {
-            JsonObject pred = respDoc["prediction"];
-            prediction.riskScore = pred["risk_score"] | 0.0f;
-            prediction.confidence = pred["confidence"] | 0.0f;
-            const char* label = pred["risk_label"] | "unknown";
-            strncpy(prediction.riskLabel, label, sizeof(prediction.riskLabel) - 1);
-            prediction.riskLabel[sizeof(prediction.riskLabel) - 1] = '\0';
-            prediction.valid = true;
-
-            Serial.printf("[SEND] Risk: %s (score=%.3f, conf=%.3f)\n",
-                prediction.riskLabel, prediction.riskScore, prediction.confidence);
-        }
-
-        _successCount++;
-        return SEND_OK;
-    } else {
-        String errorBody = http.getString();
-        http.end();
-        Serial.printf("[SEND] Server error: %s\n", errorBody.c_str());
-        _failCount++;
-        return SEND_HTTP_ERROR;
+    Print& body = apiRequestBody();
+    uint8_t head[VITALS_BATCH_HEADER_SIZE] = {
+        VITALS_BIN_MAGIC0, VITALS_BATCH_MAGIC1, VITALS_BATCH_VERSION, included
+    };
+    body.write(head, sizeof(head));
+    for (uint8_t i = 0; i < count; i++) {
+        if (!timestamps[i]) continue;
+        uint8_t len[2] = { (uint8_t)recs[i].length, (uint8_t)(recs[i].length >> 8) };
+        body.write(len, sizeof(len));
+        storeWritePayload(recs[i], timestamps[i], body);
     }
 
-#endif // WIFI_MODE_ENABLED
+    // Predictions for backlog windows are stale by now: not kept
+    JsonDocument filter;
+    filter["results"][0]["id"] = true;
+    filter["results"][0]["error"] = true;
+    return readResponse(filter, results);
 }
+#endif
 
 int      dataSenderGetLastHttpCode() { return _lastHttpCode; }
+
+#if WIFI_MODE_ENABLED
+ApiTiming dataSenderGetLastTiming()  { return apiLastTiming(); }
+#else
+ApiTiming dataSenderGetLastTiming()  { return ApiTiming(); }
+#endif
 uint32_t dataSenderGetSuccessCount() { return _successCount; }
 uint32_t dataSenderGetFailCount()    { return _failCount; }
 
 // ============================================================
 //  FreeRTOS Background Task
 // ============================================================
+#if WIFI_MODE_ENABLED
+// The server refused the body itself: resending the same bytes cannot
+// succeed. Anything else (network, 5xx, 401/403 auth, 404, 429) keeps the
+// window for a later attempt.
+static bool isRejected(SendResult result) {
+    return result == SEND_HTTP_ERROR &&
+           (_lastHttpCode == 400 || _lastHttpCode == 413 || _lastHttpCode == 422);
+}
+
+static void processJob(DataSendJob& job) {
+    PredictionResult prediction;
+    prediction.valid = false;
+    SendResult result = SEND_NOT_READY;
+
+    // Upload live only when it cannot overtake older stored windows.
+    // One attempt: a failed window goes to the store and the backlog drain
+    // retries it with backoff, so the sender is never tied up for long and
+    // later windows follow it into the store in order. Auth failures are
+    // kept too; the backlog uploads once the key is fixed.
+    // The live attempt and the stored copy share one seq: when the server
+    // stored the window but the response was lost, it drops the resend.
+    uint32_t seq = storeTakeSeq();
+    bool live = wifiIsReady() && job.timestamp != 0 && storeIsEmpty();
+    if (live) {
+        result = dataSenderPost(*job.window, job.deviceId, job.timestamp, seq, prediction);
+    }
+
+    if (live && isRejected(result)) {
+        Serial.printf("[SEND] Window rejected (HTTP %d), dropped\n", _lastHttpCode);
+    } else if (!live || result != SEND_OK) {
+        if (storeAppend(*job.window, job.deviceId, job.timestamp, job.capturedMs, seq)) {
+            Serial.printf("[STORE] Window stored (%lu pending)\n",
+                          (unsigned long)storePendingCount());
+        } else {
+            Serial.println("[STORE] Window dropped");
+        }
+    }
+    windowPoolRelease(job.window);
+
+    if (live) {
+        DataSendResult res = { prediction, result };
+        halQueueOverwrite(_resultQueue, &res);
+    }
+}
+
+// Upload the oldest stored windows, up to STORE_BATCH_MAX per request.
+// Returns false when nothing could be done (offline, clock not synced,
+// empty log or upload failed).
+static bool drainBacklog() {
+    time_t now = wifiGetTimestamp();
+    if (!wifiIsReady() || now == 0) return false;
+
+    StoreRecord recs[STORE_BATCH_MAX];
+    time_t timestamps[STORE_BATCH_MAX];
+    uint8_t count = storePeekMany(recs, STORE_BATCH_MAX);
+    if (count == 0) return false;
+
+    uint8_t included = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        timestamps[i] = storeResolveTime(recs[i], now);
+        if (timestamps[i]) {
+            included++;
+        } else {
+            Serial.printf("[STORE] Seq %lu has no time base, dropped\n", (unsigned long)recs[i].seq);
+        }
+    }
+
+    // Only a rejected body drops the batch. Auth errors, 404 (no batch
+    // endpoint), 429 and server errors keep it and back off.
+    JsonDocument doc;
+    if (included > 0) {
+        SendResult result = postBatch(recs, timestamps, count, included, doc);
+        if (isRejected(result)) {
+            Serial.printf("[STORE] Seq %lu..%lu rejected (HTTP %d), dropped\n",
+                          (unsigned long)recs[0].seq, (unsigned long)recs[count - 1].seq,
+                          _lastHttpCode);
+            for (uint8_t i = 0; i < count; i++) storeAck(recs[i]);
+            return true;
+        }
+        if (result != SEND_OK) return false;
+    }
+
+    // Acknowledge, oldest first, what the server stored or refused; a
+    // record without a result stays for the next attempt
+    JsonArrayConst results = doc["results"].as<JsonArrayConst>();
+    uint8_t acked = 0;
+    size_t next = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (timestamps[i]) {
+            if (next >= results.size()) break;
+            JsonObjectConst r = results[next++].as<JsonObjectConst>();
+            if (!r["error"].isNull()) {
+                Serial.printf("[STORE] Seq %lu rejected (%s), dropped\n",
+                              (unsigned long)recs[i].seq, r["error"] | "?");
+            }
+        }
+        storeAck(recs[i]);
+        acked++;
+    }
+    if (acked < count) {
+        Serial.printf("[STORE] %u of %u windows without a result, kept\n", count - acked, count);
+    }
+    return acked > 0;
+}
+#endif
+
 static void dataSenderTaskFn(void* param) {
     DataSendJob job;
+#if WIFI_MODE_ENABLED
+    uint32_t drainWait = 0;
     while (true) {
-        if (xQueueReceive(_sendQueue, &job, portMAX_DELAY) == pdTRUE) {
-            PredictionResult prediction;
-            prediction.valid = false;
-            SendResult result = SEND_NOT_READY;
-
-            for (int attempt = 0; attempt <= API_MAX_RETRIES; attempt++) {
-                if (attempt > 0) {
-                    Serial.printf("[SEND] Retry %d/%d...\n", attempt, API_MAX_RETRIES);
-                    vTaskDelay(pdMS_TO_TICKS(500));
-                }
-                result = dataSenderPost(job.window, job.deviceId, job.timestamp, prediction);
-                if (result == SEND_OK || result == SEND_JSON_ERROR || result == SEND_NOT_READY) break;
-            }
+        storeSetClock(wifiGetTimestamp());
 
-            DataSendResult res = { prediction, result };
-            xQueueOverwrite(_resultQueue, &res);
+        // Live windows first; wake up periodically while a backlog waits
+        uint32_t wait = storeIsEmpty() ? HAL_WAIT_FOREVER : drainWait;
+        if (halQueueReceive(_sendQueue, &job, wait)) {
+            processJob(job);
+            continue;
         }
+        drainWait = drainBacklog() ? 0 : STORE_DRAIN_RETRY_MS;
+        storeCommitAcks();
     }
+#else
+    while (true) {
+        if (halQueueReceive(_sendQueue, &job, HAL_WAIT_FOREVER)) {
+            windowPoolRelease(job.window);
+        }
+    }
+#endif
 }
 
 void dataSenderStartTask() {
-    _sendQueue = xQueueCreate(DATA_SEND_QUEUE_DEPTH, sizeof(DataSendJob));
-    _resultQueue = xQueueCreate(1, sizeof(DataSendResult));
+    // Holds every pool buffer, so dataSenderEnqueue() never finds it full
+    _sendQueue = halQueueCreate(WINDOW_POOL_SIZE, sizeof(DataSendJob));
+    _resultQueue = halQueueCreate(1, sizeof(DataSendResult));
+#if WIFI_MODE_ENABLED
+    storeInit();
+#endif
 
-    xTaskCreatePinnedToCore(
+    halTaskStart(
         dataSenderTaskFn,
         "DataSender",
         DATA_SEND_TASK_STACK,
-        nullptr,
         DATA_SEND_TASK_PRIORITY,
-        &_sendTaskHandle,
         DATA_SEND_TASK_CORE
     );
     Serial.println("[SEND] Background task started on Core 0");
 }
 
-bool dataSenderEnqueue(const SensorWindow& window, const char* deviceId, time_t timestamp) {
-    if (!_sendQueue) return false;
+bool dataSenderEnqueue(SensorWindow* window, const char* deviceId, time_t timestamp) {
+    if (!_sendQueue) {
+        windowPoolRelease(window);
+        return false;
+    }
     DataSendJob job;
     job.window = window;
     strncpy(job.deviceId, deviceId, sizeof(job.deviceId) - 1);
     job.deviceId[sizeof(job.deviceId) - 1] = '\0';
     job.timestamp = timestamp;
+    job.capturedMs = halMillis();
 
-    if (xQueueSend(_sendQueue, &job, 0) != pdTRUE) {
-        Serial.println("[SEND] Queue full, window dropped");
-        return false;
-    }
-    return true;
+    // Cannot block: the queue has a slot for every pool buffer
+    return halQueueSend(_sendQueue, &job, HAL_WAIT_FOREVER);
 }
 
 bool dataSenderPollResult(DataSendResult& out) {
     if (!_resultQueue) return false;
-    return xQueueReceive(_resultQueue, &out, 0) == pdTRUE;
+    return halQueueReceive(_resultQueue, &out, 0);
 }
 
 bool dataSenderIsBusy() {
     if (!_sendQueue) return false;
-    return uxQueueMessagesWaiting(_sendQueue) > 0;
+    return halQueueCount(_sendQueue) > 0;
 }
@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include "sensor_manager.h"
+#include "api_client.h"
 
 enum SendResult {
     SEND_OK,
@@ -19,11 +20,12 @@ struct PredictionResult {
     bool  valid;
 };
 
-// Job passed from main loop to background task
+// Job passed from main loop to background task (window is a window_pool buffer)
 struct DataSendJob {
-    SensorWindow window;
+    SensorWindow* window;
     char deviceId[20];
-    time_t timestamp;
+    time_t timestamp;       // 0 if NTP was not synced at capture
+    uint32_t capturedMs;    // millis() at enqueue
 };
 
 // Result passed back from background task to main loop
@@ -33,17 +35,25 @@ struct DataSendResult {
 };
 
 void       dataSenderInit();
+// seq: the window's store seq (0 = none), lets the server drop a resend
 SendResult dataSenderPost(const SensorWindow& window,
                           const char* deviceId,
                           time_t timestamp,
+                          uint32_t seq,
                           PredictionResult& prediction);
 int        dataSenderGetLastHttpCode();
+ApiTiming  dataSenderGetLastTiming();    // Phases of the last request
 uint32_t   dataSenderGetSuccessCount();
 uint32_t   dataSenderGetFailCount();
 
 // Async API (FreeRTOS background task)
 void       dataSenderStartTask();
-bool       dataSenderEnqueue(const SensorWindow& window, const char* deviceId, time_t timestamp);
+// Takes ownership of a window_pool buffer; it is released after the POST
+// (or immediately if the task is not started). Never drops a window for a
+// full queue: the queue holds every pool buffer. Windows that cannot be uploaded
+// now (offline, timestamp 0, server unreachable) go to the flash store
+// (window_store.h) and are sent in order once the device is back online.
+bool       dataSenderEnqueue(SensorWindow* window, const char* deviceId, time_t timestamp);
 bool       dataSenderPollResult(DataSendResult& out);
 bool       dataSenderIsBusy();
 
@@ -0,0 +1,290 @@
+#include "dsp_bench.h"
+#include "config.h"
+#include "hal.h"
+#include "ecg_filter.h"
+#include "qrs_detector.h"
+#include "MAX30100_Filters.h"
+#include "MAX30100_BeatDetector.h"
+#include "MAX30100_SpO2Calculator.h"
+#include "MAX30100_PulseOximeter.h"
+
+// Two beats at 75 bpm of each signal, looped
+#define BENCH_BEAT_MS           800
+#define BENCH_PPG_RATE_HZ       (1000 / BEATDETECTOR_SAMPLES_PERIOD)
+#define BENCH_ECG_LEN           (2 * BENCH_BEAT_MS * ECG_SAMPLE_RATE_HZ / 1000)
+#define BENCH_PPG_LEN           (2 * BENCH_BEAT_MS * BENCH_PPG_RATE_HZ / 1000)
+#define BENCH_REPEATS           5       // Batch loops per stage, the fastest counts
+
+static float _ecgIn[BENCH_ECG_LEN];         // ADC counts
+static float _irIn[BENCH_PPG_LEN];          // MAX30100 counts
+static float _redIn[BENCH_PPG_LEN];
+static float _irAc[BENCH_PPG_LEN];          // After the DC removers
+static float _redAc[BENCH_PPG_LEN];
+static float _pulseIn[BENCH_PPG_LEN];       // Beat detector input
+static bool  _beatIn[BENCH_PPG_LEN];        // One beat flag per pulse
+
+static volatile float _sink;                // Keeps results alive
+
+// ============================================================
+//  Input
+// ============================================================
+static float gauss(float x, float mu, float sigma) {
+    float d = (x - mu) / sigma;
+    return expf(-0.5f * d * d);
+}
+
+static void makeInput() {
+    for (int i = 0; i < BENCH_ECG_LEN; i++) {
+        float p = fmodf(i * 1000.0f / ECG_SAMPLE_RATE_HZ, BENCH_BEAT_MS) / BENCH_BEAT_MS;
+        float mv = 0.15f * gauss(p, 0.16f, 0.025f) - 0.10f * gauss(p, 0.235f, 0.008f)
+                 + 1.00f * gauss(p, 0.25f, 0.010f) - 0.20f * gauss(p, 0.265f, 0.010f)
+                 + 0.30f * gauss(p, 0.50f, 0.050f);
+        // Plus some mains hum for the notch to work on
+        _ecgIn[i] = 1900.0f + 600.0f * mv + 20.0f * sinf(2.0f * (float)M_PI * ECG_MAINS_HZ * i / ECG_SAMPLE_RATE_HZ);
+    }
+
+    for (int i = 0; i < BENCH_PPG_LEN; i++) {
+        float p = fmodf(i * 1000.0f / BENCH_PPG_RATE_HZ, BENCH_BEAT_MS) / BENCH_BEAT_MS;
+        float pulse = gauss(p, 0.15f, 0.06f) + 0.4f * gauss(p, 0.45f, 0.10f);
+        _irIn[i]  = 40000.0f - 400.0f * pulse;
+        _redIn[i] = 30000.0f - 150.0f * pulse;
+        _beatIn[i] = (i % (BENCH_PPG_LEN / 2)) == 0;
+    }
+
+    // Stage inputs as PulseOximeter::checkSample() would see them (settled)
+    DCRemover irDc(DC_REMOVER_ALPHA), redDc(DC_REMOVER_ALPHA);
+    FilterBuLp1 lpf;
+    for (int pass = 0; pass < 3; pass++) {
+        for (int i = 0; i < BENCH_PPG_LEN; i++) {
+            _irAc[i] = irDc.step(_irIn[i]);
+            _redAc[i] = redDc.step(_redIn[i]);
+            _pulseIn[i] = lpf.step(-_irAc[i]);
+        }
+    }
+}
+
+// ============================================================
+//  Timing
+// ============================================================
+struct BenchTiming {
+    uint32_t total;         // Cycles for all samples, fastest loop
+    uint32_t worst;         // Slowest single call
+    uint32_t best;
+};
+
+template<typename Step>
+static BenchTiming timeStage(uint32_t samples, Step step,
+                             void (*tick)(uint32_t), uint32_t periodUs) {
+    BenchTiming t;
+    float acc = 0;
+
+    // Interrupts and preemption only ever add time
+    t.total = UINT32_MAX;
+    for (int r = 0; r < BENCH_REPEATS; r++) {
+        uint32_t start = halCycleCount();
+        for (uint32_t i = 0; i < samples; i++) {
+            acc += step(i);
+            if (tick) tick(periodUs);
+        }
+        uint32_t d = halCycleCount() - start;
+        if (d < t.total) t.total = d;
+    }
+
+    t.worst = 0;
+    t.best = UINT32_MAX;
+    for (uint32_t i = 0; i < samples; i++) {
+        uint32_t s = halCycleCount();
+        acc += step(i);
+        uint32_t d = halCycleCount() - s;
+        if (d > t.worst) t.worst = d;
+        if (d < t.best) t.best = d;
+        if (tick) tick(periodUs);
+    }
+
+    _sink = acc;
+    return t;
+}
+
+struct BenchReport {
+    Print&   out;
+    uint32_t samples;
+    uint32_t hz;
+    bool     first;
+};
+
+static double cyclesToNs(const BenchReport& r, double cycles) {
+    return cycles * 1e9 / r.hz;
+}
+
+// Print one stage net of the loop overhead measured on the same input.
+// Returns ns per sample.
+static double report(BenchReport& r, const char* name, uint16_t rateHz,
+                     const BenchTiming& t, const BenchTiming& base) {
+    double perSample = cyclesToNs(r, t.total > base.total ? t.total - base.total : 0) / r.samples;
+    double worst = cyclesToNs(r, t.worst > base.best ? t.worst - base.best : 0);
+
+    r.out.printf("%s\n    {\"name\":\"%s\",\"rate_hz\":%u,\"ns_per_sample\":%.1f,"
+                 "\"max_ns\":%.0f,\"msamples_per_s\":%.2f}",
+                 r.first ? "" : ",", name, rateHz, perSample, worst,
+                 perSample > 0 ? 1e3 / perSample : 0.0);
+    r.first = false;
+    return perSample;
+}
+
+// ============================================================
+//  Public API
+// ============================================================
+void dspBenchRun(Print& out, uint32_t samples, void (*tick)(uint32_t us)) {
+    makeInput();
+
+    const uint32_t ecgUs = ECG_SAMPLE_PERIOD_US;
+    const uint32_t ppgUs = BEATDETECTOR_SAMPLES_PERIOD * 1000;
+    // Past the detector's start-up holdoff, as on a running device
+    if (tick) tick((BEATDETECTOR_INIT_HOLDOFF + BEATDETECTOR_SAMPLES_PERIOD) * 1000UL);
+
+    BenchReport r = { out, samples, halCycleHz(), true };
+    out.printf("{\"bench\":\"dsp\",\"platform\":\"%s\",\"clock_hz\":%lu,\"samples\":%lu,\n"
+               "  \"stages\":[",
+#if defined(ESP32)
+               "esp32",
+#else
+               "native",
+#endif
+               (unsigned long)r.hz, (unsigned long)samples);
+
+    // --- ECG (ECG_SAMPLE_RATE_HZ) ---
+    BenchTiming ecgBase = timeStage(samples, [](uint32_t i) {
+        return _ecgIn[i % BENCH_ECG_LEN];
+    }, nullptr, ecgUs);
+
+    EcgNotch notch;
+    report(r, "EcgNotch::step", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return notch.step(_ecgIn[i % BENCH_ECG_LEN]);
+    }, nullptr, ecgUs), ecgBase);
+
+    EcgLowPass lowPass;
+    report(r, "EcgLowPass::step", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return lowPass.step(_ecgIn[i % BENCH_ECG_LEN]);
+    }, nullptr, ecgUs), ecgBase);
+
+    EcgDCRemover dcRemover;
+    report(r, "EcgDCRemover::step", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return dcRemover.step(_ecgIn[i % BENCH_ECG_LEN]);
+    }, nullptr, ecgUs), ecgBase);
+
+    // Filter chain one step() at a time
+    EcgNotch chainNotch;
+    EcgLowPass chainLpf;
+    EcgDCRemover chainDc;
+    double ecgChainNs = report(r, "ecg_chain", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        float centered = chainDc.step(chainLpf.step(chainNotch.step(_ecgIn[i % BENCH_ECG_LEN])));
+        return (float)constrain((int)(centered + 2048.0f), 0, 4095);
+    }, nullptr, ecgUs), ecgBase);
+
+    // Same chain through process(), as sensor_manager.cpp filterEcgBlock()
+    EcgNotch blockNotch;
+    EcgLowPass blockLpf;
+    EcgDCRemover blockDc;
+    float block[ECG_FILTER_BLOCK];
+    double ecgChainBlockNs = report(r, "ecg_chain_block", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        uint32_t k = i % ECG_FILTER_BLOCK;
+        if (k == 0) {
+            for (uint32_t j = 0; j < ECG_FILTER_BLOCK; j++) block[j] = _ecgIn[(i + j) % BENCH_ECG_LEN];
+            blockNotch.process(block, ECG_FILTER_BLOCK);
+            blockLpf.process(block, ECG_FILTER_BLOCK);
+            blockDc.process(block, ECG_FILTER_BLOCK);
+        }
+        return (float)constrain((int)(block[k] + 2048.0f), 0, 4095);
+    }, nullptr, ecgUs), ecgBase);
+
+    // Integer-only variants (ECG_FILTER_FIXED)
+    BenchTiming ecgFixedBase = timeStage(samples, [](uint32_t i) {
+        return (float)ecgToFixed(_ecgIn[i % BENCH_ECG_LEN]);
+    }, nullptr, ecgUs);
+
+    EcgNotchFixed notchFixed;
+    report(r, "EcgNotchFixed::step", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return (float)notchFixed.step(ecgToFixed(_ecgIn[i % BENCH_ECG_LEN]));
+    }, nullptr, ecgUs), ecgFixedBase);
+
+    EcgLowPassFixed lowPassFixed;
+    report(r, "EcgLowPassFixed::step", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return (float)lowPassFixed.step(ecgToFixed(_ecgIn[i % BENCH_ECG_LEN]));
+    }, nullptr, ecgUs), ecgFixedBase);
+
+    EcgDCRemoverFixed dcRemoverFixed;
+    report(r, "EcgDCRemoverFixed::step", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return (float)dcRemoverFixed.step(ecgToFixed(_ecgIn[i % BENCH_ECG_LEN]));
+    }, nullptr, ecgUs), ecgFixedBase);
+
+    EcgNotchFixed chainNotchFixed;
+    EcgLowPassFixed chainLpfFixed;
+    EcgDCRemoverFixed chainDcFixed;
+    double ecgChainFixedNs = report(r, "ecg_chain_fixed", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        int32_t centered = chainDcFixed.step(chainLpfFixed.step(
+            chainNotchFixed.step(ecgToFixed(_ecgIn[i % BENCH_ECG_LEN]))));
+        return (float)constrain(ecgFixedToCounts(centered) + 2048, 0, 4095);
+    }, nullptr, ecgUs), ecgFixedBase);
+
+    // R peak detection on the filtered signal (training included)
+    QrsDetector qrs;
+    report(r, "QrsDetector::step", ECG_SAMPLE_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        uint32_t ago;
+        return qrs.step((int32_t)_ecgIn[i % BENCH_ECG_LEN] - 2048, ago) ? 1.0f : 0.0f;
+    }, nullptr, ecgUs), ecgBase);
+
+    // --- PPG (MAX30100 at 100Hz) ---
+    // Only the stages that read millis() need the clock ticked
+    BenchTiming ppgBase = timeStage(samples, [](uint32_t i) {
+        return _irIn[i % BENCH_PPG_LEN];
+    }, nullptr, ppgUs);
+    BenchTiming ppgTickBase = timeStage(samples, [](uint32_t i) {
+        return _irIn[i % BENCH_PPG_LEN];
+    }, tick, ppgUs);
+
+    DCRemover ppgDc(DC_REMOVER_ALPHA);
+    report(r, "DCRemover::step", BENCH_PPG_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return ppgDc.step(_irIn[i % BENCH_PPG_LEN]);
+    }, nullptr, ppgUs), ppgBase);
+
+    FilterBuLp1 ppgLpf;
+    report(r, "FilterBuLp1::step", BENCH_PPG_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return ppgLpf.step(-_irAc[i % BENCH_PPG_LEN]);
+    }, nullptr, ppgUs), ppgBase);
+
+    BeatDetector detector;
+    report(r, "BeatDetector::addSample", BENCH_PPG_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        return detector.addSample(_pulseIn[i % BENCH_PPG_LEN]) ? 1.0f : 0.0f;
+    }, tick, ppgUs), ppgTickBase);
+
+    SpO2Calculator spo2;
+    report(r, "SpO2Calculator::update", BENCH_PPG_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        uint32_t k = i % BENCH_PPG_LEN;
+        spo2.update(_irAc[k], _redAc[k], _beatIn[k]);
+        return (float)spo2.getSpO2();
+    }, nullptr, ppgUs), ppgBase);
+
+    // Same sequence as PulseOximeter::checkSample()
+    DCRemover chainIrDc(DC_REMOVER_ALPHA), chainRedDc(DC_REMOVER_ALPHA);
+    FilterBuLp1 chainPpgLpf;
+    BeatDetector chainDetector;
+    SpO2Calculator chainSpo2;
+    double ppgChainNs = report(r, "ppg_chain", BENCH_PPG_RATE_HZ, timeStage(samples, [&](uint32_t i) {
+        uint32_t k = i % BENCH_PPG_LEN;
+        float irAc = chainIrDc.step(_irIn[k]);
+        float redAc = chainRedDc.step(_redIn[k]);
+        bool beat = chainDetector.addSample(chainPpgLpf.step(-irAc));
+        if (chainDetector.getRate() > 0) chainSpo2.update(irAc, redAc, beat);
+        return (float)beat;
+    }, tick, ppgUs), ppgTickBase);
+
+#if ECG_FILTER_IMPL == ECG_FILTER_FIXED
+    ecgChainNs = ecgChainFixedNs;
+    (void)ecgChainBlockNs;
+#else
+    ecgChainNs = ecgChainBlockNs;
+    (void)ecgChainFixedNs;
+#endif
+    double load = (ecgChainNs * ECG_SAMPLE_RATE_HZ + ppgChainNs * BENCH_PPG_RATE_HZ) / 1e7;
+    out.printf("\n  ],\n  \"load_percent\":%.4f}\n", load);
+}
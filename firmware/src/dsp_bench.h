@@ -0,0 +1,32 @@
+#ifndef DSP_BENCH_H
+#define DSP_BENCH_H
+
+#include <Arduino.h>
+
+// ============================================================
+//  DSP microbenchmarks
+// ============================================================
+// Times the per-sample filter and detection stages (ECG filters in float and
+// fixed point, MAX30100 PPG filter, beat detector, SpO2 calculator) and the
+// full chains over synthetic input, and prints one JSON object to out:
+//
+//   {"bench":"dsp","platform":"esp32","clock_hz":240000000,"samples":10000,
+//    "stages":[{"name":"EcgNotch::step","rate_hz":250,"ns_per_sample":41.2,
+//               "max_ns":308,"msamples_per_s":24.27}, ...],
+//    "load_percent":0.0213}
+//
+// ns_per_sample is net of the loop and input overhead. max_ns is the
+// slowest single call, which includes interrupts on the device. Block
+// stages (process()) filter ECG_FILTER_BLOCK samples on every
+// ECG_FILTER_BLOCK-th call, so their max_ns is one whole block.
+// load_percent is the CPU share of both chains at their real sample rates,
+// with the ECG chain selected by ECG_FILTER_IMPL.
+// Blocks the caller for the whole run.
+//
+// The MAX30100 BeatDetector times beats with millis(). On the device the
+// clock runs by itself. On the host, tick is called with the sample period
+// after each sample of the stages that use it, so the virtual clock keeps up
+// with the data.
+void dspBenchRun(Print& out, uint32_t samples, void (*tick)(uint32_t us) = nullptr);
+
+#endif // DSP_BENCH_H
@@ -0,0 +1,251 @@
+#include "ecg_acquisition.h"
+#include "hal.h"
+
+#include <atomic>
+#include "spsc_ring.h"
+
+#if ECG_ACQ_MODE == ECG_ACQ_DMA
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <driver/i2s.h>
+#include <driver/adc.h>
+#include "ecg_filter.h"
+
+static_assert(PIN_ECG_OUTPUT == 34, "DMA backend is wired to ADC1_CH6 (GPIO34)");
+#endif
+
+// ============================================================
+//  Sample Ring (single producer: sample clock, single consumer: sensor side)
+// ============================================================
+static SpscRing<EcgRawSample, ECG_ACQ_BUFFER_SIZE> _ring;
+
+// Clock statistics (producer accumulates, consumer swaps out per window)
+static std::atomic<uint32_t> _statDropped(0);
+static std::atomic<uint32_t> _statMaxJitterUs(0);
+
+static HalSignal _readySignal = nullptr;     // Wakes the consumer, may be null
+
+#if ECG_ACQ_MODE == ECG_ACQ_TIMER
+static bool _timerStarted = false;
+#elif ECG_ACQ_MODE == ECG_ACQ_DMA
+static TaskHandle_t _dmaTaskHandle = nullptr;
+#else
+static uint32_t _tsLastPollMs = 0;
+#endif
+
+// Samples that do not fit are dropped and counted
+static void ringPush(const EcgRawSample* samples, size_t count) {
+    size_t pushed = _ring.push(samples, count);
+    if (pushed < count) _statDropped.fetch_add((uint32_t)(count - pushed), std::memory_order_relaxed);
+}
+
+#if ECG_ACQ_MODE != ECG_ACQ_DMA
+// Producer-only timing state
+static int64_t _lastSampleUs = 0;
+static int64_t _tickUs = 0;                 // Scheduled time of the last sample
+
+static void recordSpacing(int64_t nowUs) {
+    if (_lastSampleUs != 0) {
+        int64_t delta = nowUs - _lastSampleUs;
+
+        // A gap of ~2+ periods means whole samples never happened
+        int64_t periods = (delta + ECG_SAMPLE_PERIOD_US / 2) / ECG_SAMPLE_PERIOD_US;
+        if (periods > 1) {
+            _statDropped.fetch_add((uint32_t)(periods - 1), std::memory_order_relaxed);
+        }
+
+        int64_t err = delta - (int64_t)ECG_SAMPLE_PERIOD_US * (periods > 0 ? periods : 1);
+        uint32_t jitter = (uint32_t)(err < 0 ? -err : err);
+        uint32_t prev = _statMaxJitterUs.load(std::memory_order_relaxed);
+        while (jitter > prev &&
+               !_statMaxJitterUs.compare_exchange_weak(prev, jitter, std::memory_order_relaxed)) {
+        }
+    }
+    _lastSampleUs = nowUs;
+}
+
+// Whole periods on from the last tick: a late sample keeps its own slot,
+// a period that never ran moves the schedule past it
+static uint32_t nextTick(int64_t nowUs) {
+    if (_tickUs == 0) {
+        _tickUs = nowUs;
+    } else {
+        int64_t periods = (nowUs - _tickUs) / ECG_SAMPLE_PERIOD_US;
+        _tickUs += (int64_t)ECG_SAMPLE_PERIOD_US * (periods > 1 ? periods : 1);
+    }
+    return (uint32_t)_tickUs;
+}
+
+// Read lead-off pins and the oversampled ADC. Runs in the sample clock context.
+static void acquireSample(int64_t nowUs) {
+    recordSpacing(nowUs);
+
+    EcgRawSample sample;
+    sample.tickUs = nextTick(nowUs);
+    sample.leadOff = halDigitalRead(PIN_ECG_LO_PLUS) || halDigitalRead(PIN_ECG_LO_MINUS);
+
+    if (sample.leadOff) {
+        sample.value = 0.0f;
+    } else {
+        // ADC oversampling for ~6dB noise reduction
+        uint32_t sum = 0;
+        for (int i = 0; i < ECG_OVERSAMPLE_COUNT; i++) {
+            sum += halAdcRead(PIN_ECG_OUTPUT);
+        }
+        sample.value = (float)sum / ECG_OVERSAMPLE_COUNT;
+    }
+
+    ringPush(&sample, 1);
+}
+#endif
+
+#if ECG_ACQ_MODE == ECG_ACQ_TIMER
+// esp_timer task context (high priority, not an ISR): ADC reads are safe here
+static void onSampleTimer(void* arg) {
+    acquireSample(halMicros());
+    if (_readySignal) halSignalGive(_readySignal);
+}
+#endif
+
+#if ECG_ACQ_MODE == ECG_ACQ_DMA
+// ============================================================
+//  DMA Backend: I2S0 samples ADC1_CH6 at ECG_DMA_SAMPLE_RATE_HZ, this task
+//  anti-alias filters and keeps every ECG_DMA_DECIMATION-th sample.
+//  The sample clock is the I2S hardware clock, so spacing jitter is zero;
+//  only hand-off ring overflows are counted as drops.
+// ============================================================
+static bool dmaStart() {
+    i2s_config_t cfg = {};
+    cfg.mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN);
+    cfg.sample_rate = ECG_DMA_SAMPLE_RATE_HZ;
+    cfg.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    cfg.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT;
+    cfg.communication_format = I2S_COMM_FORMAT_STAND_I2S;
+    cfg.intr_alloc_flags = 0;
+    cfg.dma_buf_count = ECG_DMA_BUF_COUNT;
+    cfg.dma_buf_len = ECG_DMA_BUF_LEN;
+    cfg.use_apll = false;
+
+    if (i2s_driver_install(I2S_NUM_0, &cfg, 0, nullptr) != ESP_OK) return false;
+
+    adc1_config_width(ADC_WIDTH_BIT_12);
+    adc1_config_channel_atten(ADC1_CHANNEL_6, ADC_ATTEN_DB_11);
+    if (i2s_set_adc_mode(ADC_UNIT_1, ADC1_CHANNEL_6) != ESP_OK) return false;
+    return i2s_adc_enable(I2S_NUM_0) == ESP_OK;
+}
+
+static void dmaReaderTaskFn(void* param) {
+    static uint16_t buf[ECG_DMA_BUF_LEN];
+    static float block[ECG_DMA_BUF_LEN];
+    static EcgRawSample out[ECG_DMA_BUF_LEN / ECG_DMA_DECIMATION + 1];
+    EcgDecimationLpf antiAlias;
+    uint8_t phase = 0;
+    int64_t tickUs = 0;     // Output sample clock, anchored at the first buffer
+
+    while (true) {
+        size_t bytesRead = 0;
+        if (i2s_read(I2S_NUM_0, buf, sizeof(buf), &bytesRead, portMAX_DELAY) != ESP_OK) {
+            continue;
+        }
+        size_t count = bytesRead / sizeof(uint16_t);
+        if (tickUs == 0) {
+            tickUs = halMicros() - (int64_t)(count / ECG_DMA_DECIMATION) * ECG_SAMPLE_PERIOD_US;
+        }
+
+        // One lead-off read per DMA buffer (32ms) is plenty for electrode contact
+        bool leadOff = halDigitalRead(PIN_ECG_LO_PLUS) || halDigitalRead(PIN_ECG_LO_MINUS);
+
+        // I2S packs two 16-bit samples per 32-bit word with the later one
+        // in the low half, so restore time order pairwise
+        for (size_t i = 0; i + 1 < count; i += 2) {
+            uint16_t t = buf[i];
+            buf[i] = buf[i + 1];
+            buf[i + 1] = t;
+        }
+
+        // Top 4 bits carry the channel number, low 12 bits the conversion
+        for (size_t i = 0; i < count; i++) {
+            block[i] = (float)(buf[i] & 0x0FFF);
+        }
+        antiAlias.process(block, count);
+
+        // Decimate, then publish the block's samples in one push
+        size_t n = 0;
+        for (size_t i = 0; i < count; i++) {
+            if (++phase < ECG_DMA_DECIMATION) continue;
+            phase = 0;
+
+            EcgRawSample& sample = out[n++];
+            sample.leadOff = leadOff;
+            sample.value = leadOff ? 0.0f : block[i];
+            sample.tickUs = (uint32_t)tickUs;
+            tickUs += ECG_SAMPLE_PERIOD_US;
+        }
+        ringPush(out, n);
+        if (_readySignal) halSignalGive(_readySignal);
+    }
+}
+#endif
+
+// ============================================================
+//  Public API
+// ============================================================
+void ecgAcqBegin(HalSignal ready) {
+    _readySignal = ready;
+    halPinMode(PIN_ECG_LO_PLUS, HAL_PIN_INPUT);
+    halPinMode(PIN_ECG_LO_MINUS, HAL_PIN_INPUT);
+    halAdcInit(PIN_ECG_OUTPUT);
+
+#if ECG_ACQ_MODE == ECG_ACQ_TIMER
+    if (_timerStarted) return;
+
+    if (!halTimerStart(onSampleTimer, ECG_SAMPLE_PERIOD_US, "ecg_sample")) {
+        Serial.println("[ECG] Sample timer start FAILED!");
+        return;
+    }
+    _timerStarted = true;
+    Serial.printf("[ECG] Timer acquisition at %d Hz (%lu us period)\n",
+                  ECG_SAMPLE_RATE_HZ, (unsigned long)ECG_SAMPLE_PERIOD_US);
+#elif ECG_ACQ_MODE == ECG_ACQ_DMA
+    if (_dmaTaskHandle) return;
+
+    if (!dmaStart()) {
+        Serial.println("[ECG] I2S ADC DMA start FAILED!");
+        return;
+    }
+    xTaskCreatePinnedToCore(
+        dmaReaderTaskFn,
+        "EcgDma",
+        ECG_DMA_TASK_STACK,
+        nullptr,
+        ECG_DMA_TASK_PRIORITY,
+        &_dmaTaskHandle,
+        ECG_DMA_TASK_CORE
+    );
+    Serial.printf("[ECG] DMA acquisition at %d Hz, decimated %dx to %d Hz\n",
+                  ECG_DMA_SAMPLE_RATE_HZ, ECG_DMA_DECIMATION, ECG_SAMPLE_RATE_HZ);
+#else
+    Serial.printf("[ECG] Polled acquisition at %d Hz\n", ECG_SAMPLE_RATE_HZ);
+#endif
+}
+
+void ecgAcqPoll() {
+#if ECG_ACQ_MODE == ECG_ACQ_POLL
+    uint32_t now = halMillis();
+    if (now - _tsLastPollMs >= ECG_SAMPLE_PERIOD_MS) {
+        _tsLastPollMs = now;
+        acquireSample(halMicros());
+    }
+#endif
+}
+
+uint16_t ecgAcqRead(EcgRawSample* samples, uint16_t max) {
+    return (uint16_t)_ring.pop(samples, max);
+}
+
+void ecgAcqTakeStats(EcgAcqStats& stats) {
+    uint32_t dropped = _statDropped.exchange(0, std::memory_order_relaxed);
+    uint32_t jitter  = _statMaxJitterUs.exchange(0, std::memory_order_relaxed);
+    stats.droppedSamples = dropped > 0xFFFF ? 0xFFFF : (uint16_t)dropped;
+    stats.maxJitterUs    = jitter  > 0xFFFF ? 0xFFFF : (uint16_t)jitter;
+}
@@ -0,0 +1,36 @@
+#ifndef ECG_ACQUISITION_H
+#define ECG_ACQUISITION_H
+
+#include <Arduino.h>
+#include "config.h"
+#include "hal.h"
+
+// One averaged AD8232 reading, produced at the ECG sample clock
+struct EcgRawSample {
+    float value;        // Averaged ADC counts (0-4095)
+    bool  leadOff;      // LO+ or LO- asserted at sample time
+    uint32_t tickUs;    // Scheduled time on the sample clock (halMicros(), low 32 bits)
+};
+
+// Sample clock health, accumulated since the last ecgAcqTakeStats()
+struct EcgAcqStats {
+    uint16_t droppedSamples;    // Missed clock periods + hand-off ring overflows
+    uint16_t maxJitterUs;       // Worst |actual - nominal| spacing between samples
+};
+
+// Configure ADC + lead-off pins and start the sample clock (ECG_ACQ_MODE).
+// ready (optional) is given after every sample, or every DMA block, pushed
+// by the timer or DMA backend; the poll backend never gives it.
+void ecgAcqBegin(HalSignal ready = nullptr);
+
+// Poll-mode sampler. No-op for the timer backend. Call from loop().
+void ecgAcqPoll();
+
+// Pop up to max of the oldest acquired samples, in order. Returns the
+// count taken (0 when the ring is empty).
+uint16_t ecgAcqRead(EcgRawSample* samples, uint16_t max);
+
+// Copy the accumulated clock statistics and reset them for the next window.
+void ecgAcqTakeStats(EcgAcqStats& stats);
+
+#endif // ECG_ACQUISITION_H
@@ -0,0 +1,105 @@
+#include "ecg_cnn.h"
+#include <math.h>
+
+#if defined(__has_include)
+#if __has_include("ecg_cnn_data.h")
+#include "ecg_cnn_data.h"
+#define ECG_CNN_AVAILABLE       1
+#endif
+#endif
+
+#ifndef ECG_CNN_AVAILABLE
+#define ECG_CNN_AVAILABLE       0
+#endif
+
+bool ecgCnnAvailable() {
+    return ECG_CNN_AVAILABLE;
+}
+
+#if ECG_CNN_AVAILABLE
+
+// Layer i reads _arena[i % 2] and writes the other buffer
+static int8_t _arena[2][ECG_CNN_BUFFER_BYTES];
+
+// Rounded arithmetic shift of acc * mult, with the ReLU
+static inline int8_t requantize(int32_t acc, int32_t mult, uint8_t shift) {
+    int32_t y = (int32_t)(((int64_t)acc * mult + (1LL << (shift - 1))) >> shift);
+    return (int8_t)(y < 0 ? 0 : y > 127 ? 127 : y);
+}
+
+static void conv(const EcgCnnLayer& l, const int8_t* in, int8_t* out) {
+    const int32_t pad = l.kernel / 2;
+    for (uint16_t oc = 0; oc < l.outChannels; oc++) {
+        const int8_t* w = l.weights + (uint32_t)oc * l.inChannels * l.kernel;
+        int8_t* y = out + (uint32_t)oc * l.outLength;
+        for (uint16_t t = 0; t < l.outLength; t++) {
+            // Taps that fall inside the input (zero padding at the edges)
+            int32_t start = (int32_t)t * l.stride - pad;
+            int32_t kLo = start < 0 ? -start : 0;
+            int32_t kHi = start + l.kernel > l.inLength ? l.inLength - start : l.kernel;
+
+            int32_t acc = l.bias[oc];
+            for (uint16_t ic = 0; ic < l.inChannels; ic++) {
+                const int8_t* x = in + (uint32_t)ic * l.inLength + (start + kLo);
+                const int8_t* wk = w + (uint32_t)ic * l.kernel + kLo;
+                for (int32_t k = 0; k < kHi - kLo; k++) acc += (int32_t)wk[k] * x[k];
+            }
+            y[t] = requantize(acc, l.mult[oc], l.shift[oc]);
+        }
+    }
+}
+
+// z-score to int8: integer sums, float32 in the same order as the reference
+static bool quantizeInput(const uint16_t* samples, int8_t* out) {
+    const int32_t n = ECG_CNN_INPUT_LEN;
+    int32_t sum = 0;
+    int64_t sum2 = 0;
+    for (int32_t i = 0; i < n; i++) {
+        int32_t c = (int32_t)samples[i] - 2048;
+        sum += c;
+        sum2 += c * c;
+    }
+    int64_t varN2 = (int64_t)n * sum2 - (int64_t)sum * sum;     // n^2 * variance
+    if (varN2 <= 0) return false;
+
+    float mean = (float)sum / (float)n;
+    float scale = ECG_CNN_INPUT_SCALE * (float)n / sqrtf((float)varN2);
+    for (int32_t i = 0; i < n; i++) {
+        long q = lroundf(((float)((int32_t)samples[i] - 2048) - mean) * scale);
+        out[i] = (int8_t)(q < -127 ? -127 : q > 127 ? 127 : q);
+    }
+    return true;
+}
+
+bool ecgCnnScore(const uint16_t* samples, uint16_t count, float& score) {
+    if (count != ECG_CNN_INPUT_LEN) return false;
+    if (!quantizeInput(samples, _arena[0])) return false;
+
+    for (uint8_t i = 0; i < ECG_CNN_LAYER_COUNT; i++) {
+        conv(ECG_CNN_LAYERS[i], _arena[i & 1], _arena[(i + 1) & 1]);
+    }
+
+    // Global average pool folded into ECG_CNN_FC_SCALE
+    const EcgCnnLayer& last = ECG_CNN_LAYERS[ECG_CNN_LAYER_COUNT - 1];
+    const int8_t* h = _arena[ECG_CNN_LAYER_COUNT & 1];
+    int32_t acc = 0;
+    for (uint16_t c = 0; c < last.outChannels; c++) {
+        int32_t sum = 0;
+        for (uint16_t t = 0; t < last.outLength; t++) sum += h[(uint32_t)c * last.outLength + t];
+        acc += (int32_t)ECG_CNN_FC_WEIGHTS[c] * sum;
+    }
+    float logit = (float)acc * ECG_CNN_FC_SCALE + ECG_CNN_FC_BIAS;
+    score = 1.0f / (1.0f + expf(-logit));
+    return true;
+}
+
+#else
+
+bool ecgCnnScore(const uint16_t* samples, uint16_t count, float& score) {
+    (void)samples;
+    (void)count;
+    (void)score;
+    return false;
+}
+
+#endif
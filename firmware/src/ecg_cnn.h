@@ -0,0 +1,41 @@
+#ifndef ECG_CNN_H
+#define ECG_CNN_H
+
+#include <stdint.h>
+
+// ============================================================
+//  Tiny int8 1D CNN for on-device ECG screening
+// ============================================================
+// A small network distilled from the server's ECGFounder model
+// (ml/src/distill_tiny_cnn.py) that runs on the 250Hz window as uploaded:
+//   z-score -> int8 -> 5 x [conv, stride 2, ReLU] -> global average -> linear
+// Weights are int8 per output channel, activations int8 per layer, sums
+// int32, requantized with an integer multiplier and shift exactly like the
+// host reference (ml/src/tiny_ecg_cnn.py reference_int8()).
+//
+// Layers ping-pong between two static buffers of ECG_CNN_BUFFER_BYTES; no
+// heap. The model comes from the generated ecg_cnn_data.h; without it the
+// firmware builds with screening disabled (ecgCnnAvailable() is false).
+// Not thread safe: one caller (the main loop).
+
+struct EcgCnnLayer {
+    uint16_t inChannels;
+    uint16_t outChannels;
+    uint8_t  kernel;            // Odd, zero padding of kernel / 2 on both sides
+    uint8_t  stride;
+    uint16_t inLength;
+    uint16_t outLength;
+    const int8_t*  weights;     // [out][in][kernel]
+    const int32_t* bias;        // [out], at input scale x weight scale
+    const int32_t* mult;        // [out], requantization multiplier (Q31)
+    const uint8_t* shift;       // [out], total right shift
+};
+
+bool ecgCnnAvailable();
+
+// Abnormal-rhythm probability (0-1) of one window of ADC counts around
+// 2048. False without a model, for a window of another length, or a flat
+// signal.
+bool ecgCnnScore(const uint16_t* samples, uint16_t count, float& score);
+
+#endif // ECG_CNN_H
@@ -0,0 +1,224 @@
+#include "ecg_codec.h"
+
+static inline uint32_t zigzag(int32_t e) {
+    return ((uint32_t)e << 1) ^ (uint32_t)(e >> 31);
+}
+
+static inline int32_t unzigzag(uint32_t u) {
+    return (int32_t)(u >> 1) ^ -(int32_t)(u & 1);
+}
+
+// Bits needed to code the block's residuals with parameter k
+static uint32_t riceCost(const uint32_t* u, uint16_t n, uint8_t k) {
+    uint32_t bits = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        uint32_t q = u[i] >> k;
+        bits += (q < ECG_CODEC_ESCAPE_Q) ? q + 1 + k
+                                         : ECG_CODEC_ESCAPE_Q + ECG_CODEC_ESCAPE_BITS;
+    }
+    return bits;
+}
+
+// ============================================================
+//  Encoder
+// ============================================================
+EcgRiceEncoder::EcgRiceEncoder()
+    : _out(nullptr), _cap(0), _bytePos(0), _bitPos(0), _carry(0), _carryPending(false),
+      _x1(0), _x2(0), _samples(0) {}
+
+void EcgRiceEncoder::begin(uint8_t* out, size_t cap) {
+    _out = out;
+    _cap = cap;
+    _bytePos = 0;
+    _bitPos = 0;
+    _carryPending = false;
+    _x1 = 0;
+    _x2 = 0;
+    _samples = 0;
+}
+
+bool EcgRiceEncoder::putBits(uint32_t value, uint8_t bits) {
+    while (bits > 0) {
+        if (_bitPos == 0) {
+            if (_bytePos >= _cap) return false;
+            _out[_bytePos] = 0;
+        }
+        uint8_t avail = 8 - _bitPos;
+        uint8_t take = bits < avail ? bits : avail;
+        uint8_t chunk = (uint8_t)((value >> (bits - take)) & ((1u << take) - 1));
+        _out[_bytePos] |= (uint8_t)(chunk << (avail - take));
+        bits -= take;
+        _bitPos += take;
+        if (_bitPos == 8) {
+            _bitPos = 0;
+            _bytePos++;
+        }
+    }
+    return true;
+}
+
+bool EcgRiceEncoder::encodeBlock(const uint16_t* samples, uint16_t n) {
+    uint32_t u[ECG_CODEC_BLOCK];
+    uint16_t first = (_samples == 0) ? 1 : 0;   // Frame's first sample goes raw
+
+    // Residuals against the running predictor
+    int32_t x1 = _x1, x2 = _x2;
+    uint32_t sum = 0;
+    for (uint16_t i = 0; i < n; i++) {
+        int32_t x = samples[i];
+        uint32_t pos = _samples + i;
+        int32_t pred = (pos == 0) ? 0 : (pos == 1) ? x1 : 2 * x1 - x2;
+        u[i] = zigzag(x - pred);
+        if (i >= first) sum += u[i];
+        x2 = x1;
+        x1 = x;
+    }
+
+    // Estimate k from the block mean, then pick the cheapest neighbour exactly
+    uint16_t coded = n - first;
+    uint8_t k = 0;
+    while (k < ECG_CODEC_MAX_K && ((uint32_t)coded << (k + 1)) <= sum) k++;
+    uint8_t lo = k > 0 ? k - 1 : 0;
+    uint8_t hi = k < ECG_CODEC_MAX_K ? k + 1 : ECG_CODEC_MAX_K;
+    uint32_t best = riceCost(u + first, coded, lo);
+    k = lo;
+    for (uint8_t c = lo + 1; c <= hi; c++) {
+        uint32_t cost = riceCost(u + first, coded, c);
+        if (cost < best) {
+            best = cost;
+            k = c;
+        }
+    }
+
+    if (!putBits(k, 4)) return false;
+    if (first && !putBits(samples[0], 16)) return false;
+    for (uint16_t i = first; i < n; i++) {
+        uint32_t q = u[i] >> k;
+        bool ok;
+        if (q < ECG_CODEC_ESCAPE_Q) {
+            // q ones, a terminating zero and the k low bits in one write (<= 30 bits)
+            uint32_t prefix = ((1u << q) - 1) << 1;
+            ok = putBits((prefix << k) | (u[i] & ((1u << k) - 1)), (uint8_t)(q + 1 + k));
+        } else {
+            ok = putBits((1u << ECG_CODEC_ESCAPE_Q) - 1, ECG_CODEC_ESCAPE_Q)
+              && putBits(u[i], ECG_CODEC_ESCAPE_BITS);
+        }
+        if (!ok) return false;
+    }
+
+    _x1 = x1;
+    _x2 = x2;
+    _samples += n;
+    return true;
+}
+
+void EcgRiceEncoder::restoreCarry() {
+    if (_carryPending) {
+        _out[0] = _carry;
+        _carryPending = false;
+    }
+}
+
+uint16_t EcgRiceEncoder::encode(const uint16_t* samples, uint16_t count) {
+    restoreCarry();
+    uint16_t done = 0;
+    while (done < count) {
+        uint16_t n = count - done;
+        if (n > ECG_CODEC_BLOCK) n = ECG_CODEC_BLOCK;
+
+        // Roll back a block that overflows so the frame stays decodable
+        size_t bytePos = _bytePos;
+        uint8_t bitPos = _bitPos;
+        uint8_t partial = (bitPos != 0) ? _out[bytePos] : 0;
+        if (!encodeBlock(samples + done, n)) {
+            _bytePos = bytePos;
+            _bitPos = bitPos;
+            if (bitPos != 0) _out[bytePos] = partial;
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+size_t EcgRiceEncoder::finish() {
+    restoreCarry();
+    if (_bitPos != 0) {
+        _bitPos = 0;
+        _bytePos++;
+    }
+    return _bytePos;
+}
+
+size_t EcgRiceEncoder::flush() {
+    size_t n = _bytePos;
+    if (_bitPos != 0 && n > 0) {
+        // out[0] still belongs to the caller until the next encode()/finish()
+        _carry = _out[n];
+        _carryPending = true;
+    }
+    _bytePos = 0;
+    return n;
+}
+
+// ============================================================
+//  Decoder
+// ============================================================
+namespace {
+struct BitReader {
+    const uint8_t* in;
+    size_t len;
+    size_t pos;     // Bit position
+
+    bool get(uint8_t bits, uint32_t& value) {
+        if (pos + bits > len * 8) return false;
+        value = 0;
+        for (uint8_t i = 0; i < bits; i++, pos++) {
+            value = (value << 1) | ((in[pos >> 3] >> (7 - (pos & 7))) & 1);
+        }
+        return true;
+    }
+};
+}
+
+bool ecgCodecDecode(const uint8_t* in, size_t inLen, uint16_t* out, uint16_t count) {
+    BitReader br = { in, inLen, 0 };
+    int32_t x1 = 0, x2 = 0;
+
+    for (uint32_t blockStart = 0; blockStart < count; blockStart += ECG_CODEC_BLOCK) {
+        uint32_t k;
+        if (!br.get(4, k)) return false;
+
+        uint32_t end = blockStart + ECG_CODEC_BLOCK;
+        if (end > count) end = count;
+
+        for (uint32_t n = blockStart; n < end; n++) {
+            uint32_t v;
+            int32_t x;
+            if (n == 0) {
+                if (!br.get(16, v)) return false;
+                x = (int32_t)v;
+            } else {
+                uint32_t q = 0, bit;
+                while (q < ECG_CODEC_ESCAPE_Q) {
+                    if (!br.get(1, bit)) return false;
+                    if (!bit) break;
+                    q++;
+                }
+                uint32_t u;
+                if (q == ECG_CODEC_ESCAPE_Q) {
+                    if (!br.get(ECG_CODEC_ESCAPE_BITS, u)) return false;
+                } else {
+                    if (!br.get((uint8_t)k, v)) return false;
+                    u = (q << k) | v;
+                }
+                int32_t pred = (n == 1) ? x1 : 2 * x1 - x2;
+                x = pred + unzigzag(u);
+            }
+            out[n] = (uint16_t)x;
+            x2 = x1;
+            x1 = x;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,65 @@
+#ifndef ECG_CODEC_H
+#define ECG_CODEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================
+//  Lossless ECG codec: 2nd order prediction + block-adaptive Rice coding
+// ============================================================
+// Bitstream (MSB first, zero padded to a byte at the end of a frame), made of
+// blocks of ECG_CODEC_BLOCK samples (the last block of a frame may be short):
+//   k                    4 bits Rice parameter for this block
+//   per sample x[n]      n == 0 (first sample of the frame): 16 bits raw
+//                        otherwise residual e, u = zigzag(e), q = u >> k:
+//                          q < ECG_CODEC_ESCAPE_Q: q ones, one zero, k low bits of u
+//                          else: ECG_CODEC_ESCAPE_Q ones, u in ECG_CODEC_ESCAPE_BITS
+// Residuals: e[1] = x[1] - x[0], e[n] = x[n] - (2*x[n-1] - x[n-2]) for n >= 2.
+// The sample count is carried by the container, not the bitstream.
+// Python decoder: backend/app/services/ecg_codec.py (bit-exact).
+#define ECG_CODEC_BLOCK         32
+#define ECG_CODEC_ESCAPE_Q      16
+#define ECG_CODEC_ESCAPE_BITS   20
+#define ECG_CODEC_MAX_K         14
+
+class EcgRiceEncoder {
+public:
+    EcgRiceEncoder();
+
+    // Start a new frame writing into out[0..cap).
+    void begin(uint8_t* out, size_t cap);
+
+    // Encode up to count samples. Every call except the last one of a frame
+    // must pass a multiple of ECG_CODEC_BLOCK. Returns samples encoded: stops
+    // early at a block boundary (output left intact) when the next block
+    // would not fit in the buffer.
+    uint16_t encode(const uint16_t* samples, uint16_t count);
+
+    // Pad the final byte. Returns the frame bytes held in out.
+    size_t finish();
+
+    // Streaming: returns n complete bytes in out[0..n) for the caller to
+    // consume; the pending partial byte moves to out[0] for the next encode().
+    size_t flush();
+
+    uint32_t samplesEncoded() const { return _samples; }
+
+private:
+    bool putBits(uint32_t value, uint8_t bits);
+    bool encodeBlock(const uint16_t* samples, uint16_t n);
+    void restoreCarry();
+
+    uint8_t* _out;
+    size_t   _cap;
+    size_t   _bytePos;      // Byte currently being filled
+    uint8_t  _bitPos;       // Bits already used in that byte (0-7)
+    uint8_t  _carry;        // Partial byte held back by flush()
+    bool     _carryPending;
+    int32_t  _x1, _x2;      // Previous two samples (predictor state)
+    uint32_t _samples;
+};
+
+// Decode count samples from a frame. Returns false on truncated input.
+bool ecgCodecDecode(const uint8_t* in, size_t inLen, uint16_t* out, uint16_t count);
+
+#endif // ECG_CODEC_H
@@ -1,75 +1,224 @@
 #ifndef ECG_FILTER_H
 #define ECG_FILTER_H
 
-// 2nd order IIR Notch Filter at 50Hz
-// Fs=250Hz, f0=50Hz, Q=25 (BW≈2Hz)
-// Removes powerline interference
-class EcgNotch50 {
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+#include "filter_design.h"
+
+// Coefficients are designed at compile time (filter_design.h) from
+// ECG_SAMPLE_RATE_HZ and the corners in config.h.
+constexpr BiquadCoeffs ecgNotchCoeffs() {
+    return biquadNotch(ECG_MAINS_HZ, ECG_NOTCH_Q, ECG_SAMPLE_RATE_HZ);
+}
+constexpr BiquadCoeffs ecgLowPassCoeffs() {
+    return biquadLowPass(ECG_LPF_HZ, ECG_SAMPLE_RATE_HZ);
+}
+constexpr double ecgDcAlpha() {
+    return dcRemoverAlpha(ECG_HPF_HZ, ECG_SAMPLE_RATE_HZ);
+}
+
+static_assert(ECG_MAINS_HZ * 2 < ECG_SAMPLE_RATE_HZ, "Mains notch must be below Nyquist");
+static_assert(ECG_LPF_HZ * 2 < ECG_SAMPLE_RATE_HZ, "ECG low-pass corner must be below Nyquist");
+static_assert(biquadStable(ecgNotchCoeffs()) && biquadStable(ecgLowPassCoeffs()),
+              "ECG filter design is unstable at ECG_SAMPLE_RATE_HZ");
+
+// Block processing: process(buf, n) filters n samples in place and shares
+// state with step(), so the two can be mixed. Biquads run in Direct Form II
+// with coefficients {b0, b1, b2, a1, a2} and state {w[n-1], w[n-2]}, the
+// layout of esp-dsp's dsps_biquad_f32(). The ESP32 build uses that kernel
+// when the framework ships esp-dsp, anything else the scalar loop below.
+#if defined(ESP32) && defined(__has_include)
+#if __has_include(<dsps_biquad.h>)
+#include <dsps_biquad.h>
+#define ECG_FILTER_ESP_DSP      1
+#endif
+#endif
+#ifndef ECG_FILTER_ESP_DSP
+#define ECG_FILTER_ESP_DSP      0
+#endif
+
+class EcgBiquad {
 public:
-    EcgNotch50() : _x1(0), _x2(0), _y1(0), _y2(0) {}
+    constexpr explicit EcgBiquad(const BiquadCoeffs& k)
+        : _c{(float)k.b0, (float)k.b1, (float)k.b2, (float)k.a1, (float)k.a2}, _w{0, 0} {}
 
     float step(float x) {
-        float y = _b0 * x + _b1 * _x1 + _b2 * _x2 - _a1 * _y1 - _a2 * _y2;
-        _x2 = _x1; _x1 = x;
-        _y2 = _y1; _y1 = y;
+        float d = x - _c[3] * _w[0] - _c[4] * _w[1];
+        float y = _c[0] * d + _c[1] * _w[0] + _c[2] * _w[1];
+        _w[1] = _w[0]; _w[0] = d;
         return y;
     }
 
-    void reset() { _x1 = _x2 = _y1 = _y2 = 0; }
+    void process(float* buf, size_t n) {
+#if ECG_FILTER_ESP_DSP
+        dsps_biquad_f32(buf, buf, (int)n, _c, _w);
+#else
+        // Coefficients and state stay in registers for the whole block
+        float b0 = _c[0], b1 = _c[1], b2 = _c[2], a1 = _c[3], a2 = _c[4];
+        float w0 = _w[0], w1 = _w[1];
+        for (size_t i = 0; i < n; i++) {
+            float d = buf[i] - a1 * w0 - a2 * w1;
+            buf[i] = b0 * d + b1 * w0 + b2 * w1;
+            w1 = w0; w0 = d;
+        }
+        _w[0] = w0; _w[1] = w1;
+#endif
+    }
+
+    void reset() { _w[0] = _w[1] = 0; }
 
 private:
-    float _x1, _x2, _y1, _y2;
-    static constexpr float _b0 =  0.981334f;
-    static constexpr float _b1 = -0.606498f;
-    static constexpr float _b2 =  0.981334f;
-    static constexpr float _a1 = -0.606498f;
-    static constexpr float _a2 =  0.962668f;
+    float _c[5];
+    float _w[2];
+};
+
+// 2nd order IIR Notch Filter at ECG_MAINS_HZ
+// Q=ECG_NOTCH_Q (-3dB bandwidth ECG_MAINS_HZ / ECG_NOTCH_Q)
+// Removes powerline interference
+class EcgNotch : public EcgBiquad {
+public:
+    constexpr EcgNotch() : EcgBiquad(ecgNotchCoeffs()) {}
 };
 
 // 2nd order Butterworth Low-Pass Filter
-// Fs=250Hz, Fc=40Hz
+// Fc=ECG_LPF_HZ
 // Removes high-frequency noise, preserves QRS morphology
-class EcgLowPass {
+class EcgLowPass : public EcgBiquad {
 public:
-    EcgLowPass() : _z1(0), _z2(0) {}
+    constexpr EcgLowPass() : EcgBiquad(ecgLowPassCoeffs()) {}
+};
 
-    float step(float x) {
-        float y = _b0 * x + _z1;
-        _z1 = _b1 * x - _a1 * y + _z2;
-        _z2 = _b2 * x - _a2 * y;
+// DC Baseline Removal (high-pass, Fc=ECG_HPF_HZ)
+// Reuses DCRemover pattern from MAX30100_Filters.h
+// Alpha is dcRemoverAlpha(ECG_HPF_HZ, ECG_SAMPLE_RATE_HZ)
+// dcw = x + alpha * dcw; y = dcw - dcw[-1] is the biquad {1, -1, 0, -alpha, 0}
+// with w[0] = dcw.
+class EcgDCRemover : public EcgBiquad {
+public:
+    constexpr EcgDCRemover(double alpha = ecgDcAlpha())
+        : EcgBiquad(BiquadCoeffs{1.0, -1.0, 0.0, -alpha, 0.0}) {}
+};
+
+// ============================================================
+//  Fixed-point variants (ECG_FILTER_IMPL == ECG_FILTER_FIXED)
+// ============================================================
+// Same filters as above in integer arithmetic only, so the chain needs no
+// FPU (cheaper on the ESP32, usable from an ISR without saving FPU state).
+// Samples are ADC counts in Q16 (16 fractional bits, +/-32768 counts),
+// coefficients are Q2.30. Products accumulate in 64 bits, are rounded and
+// the output saturates to int32. The biquads are Direct Form I, which keeps
+// a single accumulator and has no internal overflow.
+// Output matches the float chain to within 1 count after re-centering
+// (native: program --filter-check).
+#define ECG_Q_SHIFT             16
+#define ECG_Q30(c)              ((int32_t)((c) * 1073741824.0 + ((c) < 0 ? -0.5 : 0.5)))
+
+static inline int32_t ecgToFixed(float counts) {
+    return (int32_t)(counts * (float)(1 << ECG_Q_SHIFT));
+}
+
+// Whole counts, rounded down like the float chain's (int) cast above 0
+static inline int32_t ecgFixedToCounts(int32_t q) {
+    return q >> ECG_Q_SHIFT;
+}
+
+static inline int32_t ecgSat32(int64_t v) {
+    if (v > INT32_MAX) return INT32_MAX;
+    if (v < INT32_MIN) return INT32_MIN;
+    return (int32_t)v;
+}
+
+static inline int32_t ecgQ30Round(int64_t acc) {
+    return ecgSat32((acc + (1 << 29)) >> 30);
+}
+
+// Direct Form I biquad, coefficients as EcgBiquad
+class EcgBiquadFixed {
+public:
+    constexpr explicit EcgBiquadFixed(const BiquadCoeffs& k)
+        : _b0(ECG_Q30(k.b0)), _b1(ECG_Q30(k.b1)), _b2(ECG_Q30(k.b2)),
+          _a1(ECG_Q30(k.a1)), _a2(ECG_Q30(k.a2)),
+          _x1(0), _x2(0), _y1(0), _y2(0) {}
+
+    int32_t step(int32_t x) {
+        int64_t acc = (int64_t)_b0 * x + (int64_t)_b1 * _x1 + (int64_t)_b2 * _x2
+                    - (int64_t)_a1 * _y1 - (int64_t)_a2 * _y2;
+        int32_t y = ecgQ30Round(acc);
+        _x2 = _x1; _x1 = x;
+        _y2 = _y1; _y1 = y;
         return y;
     }
 
-    void reset() { _z1 = _z2 = 0; }
+    void process(int32_t* buf, size_t n) {
+        for (size_t i = 0; i < n; i++) buf[i] = step(buf[i]);
+    }
+
+    void reset() { _x1 = _x2 = _y1 = _y2 = 0; }
 
 private:
-    float _z1, _z2;
-    // Direct Form II Transposed
-    static constexpr float _b0 =  0.145310f;
-    static constexpr float _b1 =  0.290620f;
-    static constexpr float _b2 =  0.145310f;
-    static constexpr float _a1 = -0.670919f;
-    static constexpr float _a2 =  0.252160f;
+    int32_t _b0, _b1, _b2, _a1, _a2;
+    int32_t _x1, _x2, _y1, _y2;
 };
 
-// DC Baseline Removal (high-pass ~0.5Hz)
-// Reuses DCRemover pattern from MAX30100_Filters.h
-// Alpha=0.9875 gives Fc≈0.5Hz at Fs=250Hz
-class EcgDCRemover {
+class EcgNotchFixed : public EcgBiquadFixed {
 public:
-    EcgDCRemover(float alpha = 0.9875f) : _alpha(alpha), _dcw(0) {}
+    constexpr EcgNotchFixed() : EcgBiquadFixed(ecgNotchCoeffs()) {}
+};
 
-    float step(float x) {
-        float oldDcw = _dcw;
-        _dcw = x + _alpha * _dcw;
-        return _dcw - oldDcw;
+class EcgLowPassFixed : public EcgBiquadFixed {
+public:
+    constexpr EcgLowPassFixed() : EcgBiquadFixed(ecgLowPassCoeffs()) {}
+};
+
+// DC removal as EcgDCRemover, rewritten as y = x - x[-1] + alpha * y[-1]
+// (same response and start-up) so no state grows to x / (1 - alpha)
+class EcgDCRemoverFixed {
+public:
+    constexpr EcgDCRemoverFixed(double alpha = ecgDcAlpha()) : _alpha(ECG_Q30(alpha)), _x1(0), _y1(0) {}
+
+    int32_t step(int32_t x) {
+        int64_t acc = (((int64_t)x - _x1) << 30) + (int64_t)_alpha * _y1;
+        _x1 = x;
+        _y1 = ecgQ30Round(acc);
+        return _y1;
+    }
+
+    void process(int32_t* buf, size_t n) {
+        for (size_t i = 0; i < n; i++) buf[i] = step(buf[i]);
+    }
+
+    void reset() { _x1 = _y1 = 0; }
+
+private:
+    int32_t _alpha;
+    int32_t _x1, _y1;
+};
+
+// 4th order Butterworth Low-Pass anti-alias filter for DMA decimation
+// Fs=ECG_DMA_SAMPLE_RATE_HZ (250Hz x 8), Fc=ECG_DMA_LPF_HZ (80Hz),
+// two cascaded sections with unity DC gain
+// Attenuates >30dB above 200Hz before every 8th sample is kept
+static_assert(ECG_DMA_LPF_HZ * 2 < ECG_SAMPLE_RATE_HZ,
+              "Anti-alias corner must be below the decimated Nyquist");
+
+class EcgDecimationLpf {
+public:
+    constexpr EcgDecimationLpf()
+        : _a(biquadLowPass(ECG_DMA_LPF_HZ, ECG_DMA_SAMPLE_RATE_HZ, FD_BUTTERWORTH4_Q1)),
+          _b(biquadLowPass(ECG_DMA_LPF_HZ, ECG_DMA_SAMPLE_RATE_HZ, FD_BUTTERWORTH4_Q2)) {}
+
+    float step(float x) { return _b.step(_a.step(x)); }
+
+    void process(float* buf, size_t n) {
+        _a.process(buf, n);
+        _b.process(buf, n);
     }
 
-    void reset() { _dcw = 0; }
+    void reset() { _a.reset(); _b.reset(); }
 
 private:
-    float _alpha;
-    float _dcw;
+    EcgBiquad _a, _b;
 };
 
 #endif // ECG_FILTER_H
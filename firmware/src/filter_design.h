@@ -0,0 +1,98 @@
+#ifndef FILTER_DESIGN_H
+#define FILTER_DESIGN_H
+
+// ============================================================
+//  Compile-time biquad design
+// ============================================================
+// RBJ Audio EQ Cookbook biquads (bilinear transform with pre-warping),
+// normalized to a0 = 1 and returned as {b0, b1, b2, a1, a2}. Everything
+// is constexpr in C++11 form, so coefficients derived from config.h
+// constants fold to literals and cost nothing at run time.
+//
+// The 2nd order Butterworth response is Q = 1/sqrt(2). A 4th order
+// Butterworth is two sections with Q = 0.5412 and 1.3066.
+
+#define FD_BUTTERWORTH_Q        0.70710678118654752
+#define FD_BUTTERWORTH4_Q1      0.54119610014619698
+#define FD_BUTTERWORTH4_Q2      1.30656296487637653
+
+struct BiquadCoeffs {
+    double b0, b1, b2, a1, a2;
+};
+
+namespace fd {
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Taylor series, exact to double precision for |x| <= pi
+constexpr double sinSeries(double x, double term, int k) {
+    return k > 41 ? 0.0 : term + sinSeries(x, -term * x * x / ((k + 1) * (k + 2)), k + 2);
+}
+
+constexpr double sin(double x) { return sinSeries(x, x, 1); }
+constexpr double cos(double x) { return sinSeries(x, 1.0, 0); }
+
+constexpr double expSeries(double x, double term, int k) {
+    return k > 30 ? 0.0 : term + expSeries(x, term * x / (k + 1), k + 1);
+}
+
+// Small |x| only (filter pole radii)
+constexpr double exp(double x) { return expSeries(x, 1.0, 0); }
+
+constexpr double omega(double f, double fs) { return 2.0 * kPi * f / fs; }
+
+constexpr BiquadCoeffs normalize(double b0, double b1, double b2,
+                                 double a0, double a1, double a2) {
+    return BiquadCoeffs{b0 / a0, b1 / a0, b2 / a0, a1 / a0, a2 / a0};
+}
+
+constexpr BiquadCoeffs notch(double cosW, double alpha) {
+    return normalize(1.0, -2.0 * cosW, 1.0, 1.0 + alpha, -2.0 * cosW, 1.0 - alpha);
+}
+
+constexpr BiquadCoeffs lowPass(double cosW, double alpha) {
+    return normalize((1.0 - cosW) / 2.0, 1.0 - cosW, (1.0 - cosW) / 2.0,
+                     1.0 + alpha, -2.0 * cosW, 1.0 - alpha);
+}
+
+constexpr BiquadCoeffs highPass(double cosW, double alpha) {
+    return normalize((1.0 + cosW) / 2.0, -(1.0 + cosW), (1.0 + cosW) / 2.0,
+                     1.0 + alpha, -2.0 * cosW, 1.0 - alpha);
+}
+
+constexpr BiquadCoeffs bandPass(double cosW, double alpha) {
+    return normalize(alpha, 0.0, -alpha, 1.0 + alpha, -2.0 * cosW, 1.0 - alpha);
+}
+
+} // namespace fd
+
+// Band-stop at f0 with bandwidth f0 / q
+constexpr BiquadCoeffs biquadNotch(double f0, double q, double fs) {
+    return fd::notch(fd::cos(fd::omega(f0, fs)), fd::sin(fd::omega(f0, fs)) / (2.0 * q));
+}
+
+constexpr BiquadCoeffs biquadLowPass(double fc, double fs, double q = FD_BUTTERWORTH_Q) {
+    return fd::lowPass(fd::cos(fd::omega(fc, fs)), fd::sin(fd::omega(fc, fs)) / (2.0 * q));
+}
+
+constexpr BiquadCoeffs biquadHighPass(double fc, double fs, double q = FD_BUTTERWORTH_Q) {
+    return fd::highPass(fd::cos(fd::omega(fc, fs)), fd::sin(fd::omega(fc, fs)) / (2.0 * q));
+}
+
+// Band-pass around f0 with bandwidth f0 / q, 0dB at f0
+constexpr BiquadCoeffs biquadBandPass(double f0, double q, double fs) {
+    return fd::bandPass(fd::cos(fd::omega(f0, fs)), fd::sin(fd::omega(f0, fs)) / (2.0 * q));
+}
+
+// Pole of the one-pole DC remover y = x - x[-1] + alpha * y[-1] for a
+// -3dB corner at fc (fc << fs)
+constexpr double dcRemoverAlpha(double fc, double fs) {
+    return fd::exp(-fd::omega(fc, fs));
+}
+
+// A biquad is stable when both poles lie inside the unit circle
+constexpr bool biquadStable(const BiquadCoeffs& k) {
+    return k.a2 < 1.0 && k.a2 > -1.0 && (k.a1 < 1.0 + k.a2) && (-k.a1 < 1.0 + k.a2);
+}
+
+#endif // FILTER_DESIGN_H
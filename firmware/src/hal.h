@@ -0,0 +1,92 @@
+#ifndef HAL_H
+#define HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Interrupt handlers passed to halAttachFallingIsr() must live in IRAM on the ESP32
+#if defined(ESP32)
+#include <esp_attr.h>
+#define HAL_ISR_ATTR        IRAM_ATTR
+#else
+#define HAL_ISR_ATTR
+#endif
+
+// ============================================================
+//  Hardware abstraction layer
+// ============================================================
+// The platform calls made by the acquisition -> window -> sender pipeline
+// (sensor_manager, ecg_acquisition, window_pool, window_store, data_sender,
+// api_client). hal_esp32.cpp forwards them to Arduino/ESP-IDF/FreeRTOS;
+// native/hal_native.cpp implements them on a virtual clock for [env:native].
+// Everything else (BLE, WiFi association, main.cpp) stays ESP32 only.
+
+// --- Clock ---
+uint32_t halMillis();
+int64_t  halMicros();               // Monotonic since boot (esp_timer_get_time)
+void     halDelay(uint32_t ms);
+
+// Periodic callback in a high-priority task context (esp_timer, not an ISR)
+bool     halTimerStart(void (*callback)(void*), uint32_t periodUs, const char* name);
+
+// Free-running counter for benchmarks (CPU cycles on the ESP32, wall-clock
+// nanoseconds on the host), wraps at 32 bits
+uint32_t halCycleCount();
+uint32_t halCycleHz();
+
+// --- GPIO ---
+enum HalPinMode {
+    HAL_PIN_INPUT,
+    HAL_PIN_OUTPUT
+};
+void     halPinMode(uint8_t pin, HalPinMode mode);
+bool     halDigitalRead(uint8_t pin);
+void     halDigitalWrite(uint8_t pin, bool high);
+// Input with pull-up; isr runs in interrupt context on every falling edge.
+// Keep it to halSignalGiveFromIsr() and declare it HAL_ISR_ATTR.
+bool     halAttachFallingIsr(uint8_t pin, void (*isr)(void*), void* arg);
+
+// --- ADC (12-bit, full 0-3.3V range) ---
+void     halAdcInit(uint8_t pin);
+uint16_t halAdcRead(uint8_t pin);
+
+// --- I2C master ---
+void     halI2cBegin(uint8_t sda, uint8_t scl, uint32_t hz);
+void     halI2cEnd();
+bool     halI2cWrite(uint8_t addr, uint8_t reg, const uint8_t* data, uint8_t len);
+// Register read (repeated start). Returns bytes received.
+uint8_t  halI2cRead(uint8_t addr, uint8_t reg, uint8_t* data, uint8_t len);
+
+// --- Queues (fixed-size items copied in and out, any task) ---
+typedef void* HalQueue;
+#define HAL_WAIT_FOREVER    0xFFFFFFFFUL
+
+HalQueue halQueueCreate(uint16_t depth, uint16_t itemSize);
+bool     halQueueSend(HalQueue queue, const void* item, uint32_t timeoutMs);
+bool     halQueueReceive(HalQueue queue, void* item, uint32_t timeoutMs);
+void     halQueueOverwrite(HalQueue queue, const void* item);   // Depth 1 queues only
+uint16_t halQueueCount(HalQueue queue);
+
+// --- Signals (binary semaphore: an ISR or task gives, one task waits) ---
+typedef void* HalSignal;
+
+HalSignal halSignalCreate();
+void      halSignalGiveFromIsr(HalSignal signal);
+void      halSignalGive(HalSignal signal);                          // Task context
+bool      halSignalTake(HalSignal signal, uint32_t timeoutMs);     // False on timeout
+
+// --- Tasks ---
+bool     halTaskStart(void (*fn)(void*), const char* name, uint32_t stackBytes,
+                      uint8_t priority, int8_t core);
+
+// --- Network transport for api_client.cpp (one TLS connection) ---
+bool     halNetResolve(const char* host);       // DNS lookup, kept for connect
+bool     halNetConnect(const char* host, uint16_t port, uint32_t timeoutMs);
+size_t   halNetWrite(const uint8_t* data, size_t len);
+int      halNetAvailable();
+int      halNetRead();                          // -1 when nothing is buffered
+int      halNetPeek();
+bool     halNetConnected();
+void     halNetClose();
+
+#endif // HAL_H
@@ -0,0 +1,175 @@
+#include "hal.h"
+#include "config.h"
+
+#include <Wire.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+
+#if WIFI_MODE_ENABLED
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#endif
+
+// ============================================================
+//  Clock
+// ============================================================
+uint32_t halMillis()            { return millis(); }
+int64_t  halMicros()            { return esp_timer_get_time(); }
+void     halDelay(uint32_t ms)  { delay(ms); }
+
+uint32_t halCycleCount()        { return ESP.getCycleCount(); }
+uint32_t halCycleHz()           { return getCpuFrequencyMhz() * 1000000UL; }
+
+bool halTimerStart(void (*callback)(void*), uint32_t periodUs, const char* name) {
+    esp_timer_create_args_t args = {};
+    args.callback = callback;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = name;
+
+    esp_timer_handle_t timer = nullptr;
+    if (esp_timer_create(&args, &timer) != ESP_OK) return false;
+    return esp_timer_start_periodic(timer, periodUs) == ESP_OK;
+}
+
+// ============================================================
+//  GPIO / ADC
+// ============================================================
+void halPinMode(uint8_t pin, HalPinMode mode) {
+    pinMode(pin, mode == HAL_PIN_OUTPUT ? OUTPUT : INPUT);
+}
+
+bool halDigitalRead(uint8_t pin)              { return digitalRead(pin) == HIGH; }
+void halDigitalWrite(uint8_t pin, bool high)  { digitalWrite(pin, high ? HIGH : LOW); }
+
+bool halAttachFallingIsr(uint8_t pin, void (*isr)(void*), void* arg) {
+    pinMode(pin, INPUT_PULLUP);
+    attachInterruptArg(digitalPinToInterrupt(pin), isr, arg, FALLING);
+    return true;
+}
+
+void halAdcInit(uint8_t pin) {
+    analogSetPinAttenuation(pin, ADC_11db);
+    analogReadResolution(12);
+}
+
+uint16_t halAdcRead(uint8_t pin) { return analogRead(pin); }
+
+// ============================================================
+//  I2C
+// ============================================================
+void halI2cBegin(uint8_t sda, uint8_t scl, uint32_t hz) {
+    Wire.begin(sda, scl);
+    Wire.setClock(hz);
+}
+
+void halI2cEnd() { Wire.end(); }
+
+bool halI2cWrite(uint8_t addr, uint8_t reg, const uint8_t* data, uint8_t len) {
+    Wire.beginTransmission(addr);
+    Wire.write(reg);
+    Wire.write(data, len);
+    return Wire.endTransmission() == 0;
+}
+
+uint8_t halI2cRead(uint8_t addr, uint8_t reg, uint8_t* data, uint8_t len) {
+    Wire.beginTransmission(addr);
+    Wire.write(reg);
+    if (Wire.endTransmission(false) != 0) return 0;
+
+    uint8_t got = Wire.requestFrom(addr, len);
+    uint8_t n = 0;
+    while (Wire.available() && n < got) data[n++] = Wire.read();
+    return n;
+}
+
+// ============================================================
+//  Queues / Tasks
+// ============================================================
+static TickType_t toTicks(uint32_t ms) {
+    return ms == HAL_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(ms);
+}
+
+HalQueue halQueueCreate(uint16_t depth, uint16_t itemSize) {
+    return xQueueCreate(depth, itemSize);
+}
+
+bool halQueueSend(HalQueue queue, const void* item, uint32_t timeoutMs) {
+    return xQueueSend((QueueHandle_t)queue, item, toTicks(timeoutMs)) == pdTRUE;
+}
+
+bool halQueueReceive(HalQueue queue, void* item, uint32_t timeoutMs) {
+    return xQueueReceive((QueueHandle_t)queue, item, toTicks(timeoutMs)) == pdTRUE;
+}
+
+void halQueueOverwrite(HalQueue queue, const void* item) {
+    xQueueOverwrite((QueueHandle_t)queue, item);
+}
+
+uint16_t halQueueCount(HalQueue queue) {
+    return (uint16_t)uxQueueMessagesWaiting((QueueHandle_t)queue);
+}
+
+HalSignal halSignalCreate() {
+    return xSemaphoreCreateBinary();
+}
+
+void IRAM_ATTR halSignalGiveFromIsr(HalSignal signal) {
+    BaseType_t woken = pdFALSE;
+    xSemaphoreGiveFromISR((SemaphoreHandle_t)signal, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void halSignalGive(HalSignal signal) {
+    xSemaphoreGive((SemaphoreHandle_t)signal);
+}
+
+bool halSignalTake(HalSignal signal, uint32_t timeoutMs) {
+    return xSemaphoreTake((SemaphoreHandle_t)signal, toTicks(timeoutMs)) == pdTRUE;
+}
+
+bool halTaskStart(void (*fn)(void*), const char* name, uint32_t stackBytes,
+                  uint8_t priority, int8_t core) {
+    return xTaskCreatePinnedToCore(fn, name, stackBytes, nullptr, priority,
+                                   nullptr, core) == pdPASS;
+}
+
+// ============================================================
+//  Network
+// ============================================================
+#if WIFI_MODE_ENABLED
+static WiFiClientSecure _client;
+static IPAddress        _hostIp;
+
+bool halNetResolve(const char* host) {
+    return WiFi.hostByName(host, _hostIp) == 1;
+}
+
+bool halNetConnect(const char* host, uint16_t port, uint32_t timeoutMs) {
+    _client.setInsecure();  // Skip TLS cert verification (dev mode)
+    _client.setHandshakeTimeout(timeoutMs / 1000);
+    if (!_client.connect(_hostIp, port, host, nullptr, nullptr, nullptr)) {
+        _client.stop();
+        return false;
+    }
+    return true;
+}
+
+size_t halNetWrite(const uint8_t* data, size_t len) { return _client.write(data, len); }
+int    halNetAvailable()                            { return _client.available(); }
+int    halNetRead()                                 { return _client.read(); }
+int    halNetPeek()                                 { return _client.peek(); }
+bool   halNetConnected()                            { return _client.connected(); }
+void   halNetClose()                                { _client.stop(); }
+#else
+bool   halNetResolve(const char*)                   { return false; }
+bool   halNetConnect(const char*, uint16_t, uint32_t) { return false; }
+size_t halNetWrite(const uint8_t*, size_t)          { return 0; }
+int    halNetAvailable()                            { return 0; }
+int    halNetRead()                                 { return -1; }
+int    halNetPeek()                                 { return -1; }
+bool   halNetConnected()                            { return false; }
+void   halNetClose()                                {}
+#endif
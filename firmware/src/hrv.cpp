@@ -0,0 +1,153 @@
+#include "hrv.h"
+#include <Arduino.h>
+#include <math.h>
+#include <string.h>
+
+static_assert((HRV_RR_RING_SIZE & (HRV_RR_RING_SIZE - 1)) == 0,
+              "HRV_RR_RING_SIZE must be a power of 2");
+static_assert(HRV_RR_RING_SIZE > MAX_BEATS_PER_WINDOW,
+              "HRV ring must hold a window of beats plus the QRS decision delay");
+
+// HR of one interval in milli-bpm, integer so the sums stay exact
+static inline uint64_t hrMilliBpm(uint16_t ms) {
+    return 60000000UL / ms;
+}
+
+static inline uint8_t* putRounded(uint8_t* p, float v) {
+    long x = lroundf(v);
+    uint16_t u = x < 0 ? 0 : x > 0xFFFF ? 0xFFFF : (uint16_t)x;
+    p[0] = (uint8_t)u;
+    p[1] = (uint8_t)(u >> 8);
+    return p + 2;
+}
+
+size_t hrvPack(const HrvFeatures& hrv, uint8_t* out) {
+    uint8_t* p = out;
+    *p++ = hrv.rrCount;
+    p = putRounded(p, hrv.meanRrMs);
+    p = putRounded(p, hrv.sdnnMs * 10.0f);
+    p = putRounded(p, hrv.rmssdMs * 10.0f);
+    p = putRounded(p, hrv.pnn50Percent * 10.0f);
+    p = putRounded(p, hrv.meanHrBpm * 10.0f);
+    p = putRounded(p, hrv.hrStdBpm * 10.0f);
+    p = putRounded(p, hrv.rrRangeMs);
+    return p - out;
+}
+
+HrvAccumulator::HrvAccumulator() {
+    reset();
+}
+
+void HrvAccumulator::reset() {
+    _head = _tail = 0;
+    memset(&_sums, 0, sizeof(_sums));
+    _lastBeat = 0;
+    _hasLastBeat = false;
+}
+
+void HrvAccumulator::add(Sums& s, const Rr& rr, int sign) {
+    uint64_t hr = hrMilliBpm(rr.ms);
+    if (sign > 0) {
+        s.n++;
+        s.rr += rr.ms;
+        s.rr2 += (uint64_t)rr.ms * rr.ms;
+        s.hr += hr;
+        s.hr2 += hr * hr;
+    } else {
+        s.n--;
+        s.rr -= rr.ms;
+        s.rr2 -= (uint64_t)rr.ms * rr.ms;
+        s.hr -= hr;
+        s.hr2 -= hr * hr;
+    }
+}
+
+// Successive difference between two chained intervals
+void HrvAccumulator::addDiff(Sums& s, const Rr& prev, const Rr& rr, int sign) {
+    uint32_t d = rr.ms > prev.ms ? rr.ms - prev.ms : prev.ms - rr.ms;
+    uint32_t nn50 = d > HRV_NN50_MS ? 1 : 0;
+    if (sign > 0) {
+        s.nDiff++;
+        s.nn50 += nn50;
+        s.diff2 += (uint64_t)d * d;
+    } else {
+        s.nDiff--;
+        s.nn50 -= nn50;
+        s.diff2 -= (uint64_t)d * d;
+    }
+}
+
+void HrvAccumulator::dropOldest() {
+    const Rr& oldest = at(_tail);
+    add(_sums, oldest, -1);
+    if (_tail + 1 != _head && at(_tail + 1).chained) addDiff(_sums, oldest, at(_tail + 1), -1);
+    _tail++;
+}
+
+void HrvAccumulator::addBeat(uint32_t seq) {
+    uint32_t samples = seq - _lastBeat;
+    if (_hasLastBeat && samples > 0 && samples <= 0xFFFF) {
+        if (_head - _tail == HRV_RR_RING_SIZE) dropOldest();
+
+        Rr rr;
+        rr.endSeq = seq;
+        rr.samples = (uint16_t)samples;
+        rr.ms = (uint16_t)min<uint32_t>(samples * 1000UL / ECG_SAMPLE_RATE_HZ, 0xFFFF);
+        rr.chained = _head != _tail && at(_head - 1).endSeq == _lastBeat;
+        if (rr.ms > 0) {
+            add(_sums, rr, +1);
+            if (rr.chained) addDiff(_sums, at(_head - 1), rr, +1);
+            _ring[_head & (HRV_RR_RING_SIZE - 1)] = rr;
+            _head++;
+        }
+    }
+    _lastBeat = seq;
+    _hasLastBeat = true;
+}
+
+void HrvAccumulator::breakRhythm() {
+    _hasLastBeat = false;
+}
+
+void HrvAccumulator::window(uint32_t fromSeq, uint32_t toSeq, HrvFeatures& out) {
+    // Intervals that start before the window are gone for good
+    while (_tail != _head) {
+        const Rr& rr = at(_tail);
+        if ((int32_t)(rr.endSeq - rr.samples - fromSeq) >= 0) break;
+        dropOldest();
+    }
+
+    // Intervals ending at or after toSeq (beats decided during the QRS
+    // hold) stay in the ring for the next window
+    Sums s = _sums;
+    uint32_t end = _head;
+    while (end != _tail && (int32_t)(at(end - 1).endSeq - toSeq) >= 0) {
+        end--;
+        add(s, at(end), -1);
+        if (at(end).chained && end != _tail) addDiff(s, at(end - 1), at(end), -1);
+    }
+
+    memset(&out, 0, sizeof(out));
+    out.rrCount = (uint8_t)min<uint32_t>(s.n, 0xFF);
+    if (s.n == 0) return;
+
+    uint16_t lo = 0xFFFF, hi = 0;
+    for (uint32_t i = _tail; i != end; i++) {
+        lo = min(lo, at(i).ms);
+        hi = max(hi, at(i).ms);
+    }
+
+    // Integer variance numerators: n * sum(x^2) - sum(x)^2 >= 0
+    float n = (float)s.n;
+    out.meanRrMs = (float)s.rr / n;
+    out.meanHrBpm = (float)s.hr / n / 1000.0f;
+    out.hrStdBpm = sqrtf((float)(s.n * s.hr2 - s.hr * s.hr)) / n / 1000.0f;
+    out.rrRangeMs = (float)(hi - lo);
+    if (s.n >= 2) {
+        out.sdnnMs = sqrtf((float)(s.n * s.rr2 - s.rr * s.rr) / (n * (n - 1.0f)));
+    }
+    if (s.nDiff > 0) {
+        out.rmssdMs = sqrtf((float)s.diff2 / (float)s.nDiff);
+        out.pnn50Percent = 100.0f * (float)s.nn50 / (float)s.nDiff;
+    }
+}
@@ -0,0 +1,84 @@
+#ifndef HRV_H
+#define HRV_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================
+//  Incremental HRV time-domain features
+// ============================================================
+// The RR-interval statistics of the backend's feature_extractor.py
+// (ml/src), computed on the device from the QRS detector's R peaks:
+//   mean_rr, sdnn (sample std), rmssd, pnn50, mean_hr_ecg, hr_std
+//   (population std of 60000 / RR), rr_range
+// over the RR intervals with both beats inside a window.
+//
+// RR intervals live in a fixed ring with integer running sums (RR, RR^2,
+// HR, HR^2, successive differences^2, NN50), updated as beats arrive and
+// expire, so a window costs a few divisions and square roots plus a scan
+// of its own intervals for the range. The sums are exact and never drift.
+#define HRV_RR_RING_SIZE        64      // RR intervals kept, power of 2
+#define HRV_NN50_MS             50
+
+struct HrvFeatures {
+    uint8_t  rrCount;       // RR intervals in the window (features need >= 2)
+    float    meanRrMs;
+    float    sdnnMs;
+    float    rmssdMs;
+    float    pnn50Percent;
+    float    meanHrBpm;
+    float    hrStdBpm;
+    float    rrRangeMs;
+};
+
+// Wire form shared by the binary upload and BLE (little-endian):
+//   u8 rr_count, u16 mean_rr_ms, u16 sdnn_ms x10, u16 rmssd_ms x10,
+//   u16 pnn50 % x10, u16 mean_hr_bpm x10, u16 hr_std_bpm x10, u16 rr_range_ms
+#define HRV_PACKED_SIZE         15
+
+size_t hrvPack(const HrvFeatures& hrv, uint8_t* out);
+
+class HrvAccumulator {
+public:
+    HrvAccumulator();
+
+    void reset();
+
+    // R peak at an ECG sequence number (increasing)
+    void addBeat(uint32_t seq);
+
+    // Signal gap (lead-off): the next beat starts a new RR series
+    void breakRhythm();
+
+    // Features of the intervals inside [fromSeq, toSeq). Intervals that
+    // start before fromSeq are dropped for good, later windows must not
+    // start earlier.
+    void window(uint32_t fromSeq, uint32_t toSeq, HrvFeatures& out);
+
+private:
+    struct Rr {
+        uint32_t endSeq;    // Second beat of the interval
+        uint16_t samples;
+        uint16_t ms;
+        bool     chained;   // Follows the previous interval without a gap
+    };
+
+    struct Sums {
+        uint32_t n, nDiff, nn50;
+        uint64_t rr, rr2, hr, hr2, diff2;
+    };
+
+    const Rr& at(uint32_t i) const { return _ring[i & (HRV_RR_RING_SIZE - 1)]; }
+    static void add(Sums& s, const Rr& rr, int sign);
+    static void addDiff(Sums& s, const Rr& prev, const Rr& rr, int sign);
+    void dropOldest();
+
+    Rr       _ring[HRV_RR_RING_SIZE];
+    uint32_t _head, _tail;              // Running indices, _tail <= _head
+    Sums     _sums;
+    uint32_t _lastBeat;
+    bool     _hasLastBeat;
+};
+
+#endif // HRV_H
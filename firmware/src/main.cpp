@@ -28,6 +28,8 @@
  *   't' / 'T' -> Text mode (human-readable, default)
  *   'p' / 'P' -> Plotter mode (Arduino Serial Plotter CSV)
  *   'b' / 'B' -> Enter BLE provisioning mode
+ *   'm' / 'M' -> Run the DSP microbenchmarks (JSON, ~1s; pauses sampling
+ *                when SENSOR_TASK is 0)
  */
 
 #include <Arduino.h>
@@ -36,6 +38,10 @@
 #include "wifi_manager.h"
 #include "data_sender.h"
 #include "ble_provisioner.h"
+#include "window_pool.h"
+#include "risk_model.h"
+#include "ecg_cnn.h"
+#include "dsp_bench.h"
 
 // --- Output mode ---
 static bool plotterMode = false;
@@ -44,7 +50,7 @@ static bool plotterMode = false;
 static uint32_t _lastBleNotify = 0;
 
 // --- BLE ECG streaming ---
-static uint16_t _bleEcgSentIndex = 0;
+static uint32_t _bleEcgSentSeq = 0;
 static uint32_t _lastBleEcgNotify = 0;
 
 // --- Provisioning LED blink ---
@@ -65,6 +71,9 @@ static void checkSerialCommands() {
             bleClearCredentials();
             wifiReconnect();
             bleEnterProvisioning();
+        } else if (cmd == 'm' || cmd == 'M') {
+            Serial.println("[BENCH] Running DSP microbenchmarks...");
+            dspBenchRun(Serial, DSP_BENCH_SAMPLES);
         }
         while (Serial.available()) Serial.read();
     }
@@ -128,39 +137,98 @@ static void printWifiStatus() {
     }
 }
 
+// CNN screen: uploaded with the window so the server can skip ECGFounder
+// on low scores
+static void screenWindow(SensorWindow& window) {
+    if (!ecgCnnAvailable() || window.ecgLeadOff) return;
+
+    uint32_t start = micros();
+    float score;
+    if (!ecgCnnScore(window.ecgSamples, window.ecgSampleCount, score)) return;
+    window.screenScore = score;
+    if (!plotterMode) {
+        Serial.printf("[CNN] screen=%.3f (%luus)\n", score, (unsigned long)(micros() - start));
+    }
+}
+
+// Local score: shown right away, replaced by the server's ensemble result
+// when one arrives (checkSendResult)
+static void scoreWindowLocally(const SensorWindow& window) {
+    bool cnn = window.screenScore >= 0.0f;
+    if (!riskModelAvailable() && !cnn) return;
+
+    float score = window.screenScore;
+    if (riskModelAvailable()) {
+        float features[RF_COUNT];
+        uint32_t start = micros();
+        riskModelFeatures(window, features);
+        uint32_t featureUs = micros() - start;
+        float xgb = riskModelScore(features);
+        uint32_t totalUs = micros() - start;
+        if (!plotterMode) {
+            Serial.printf("[RISK] local XGBoost %.3f (features=%luus, trees=%luus)\n",
+                xgb, (unsigned long)featureUs, (unsigned long)(totalUs - featureUs));
+        }
+        score = cnn ? LOCAL_RISK_CNN_WEIGHT * window.screenScore + LOCAL_RISK_XGB_WEIGHT * xgb : xgb;
+    }
+
+    const char* label = riskModelLabel(score);
+    if (!plotterMode) Serial.printf("[RISK] local %s (score=%.3f)\n", label, score);
+#if WIFI_MODE_ENABLED
+    if (wifiIsReady()) return;      // Server result follows
+#endif
+    bleNotifyRisk(score, label);
+}
+
 // --- Handle completed 10s data window (non-blocking) ---
 static void handleDataWindow() {
     if (!sensorIsWindowReady()) return;
 
-    SensorWindow window;
-    if (!sensorGetWindow(window)) return;
+    // Pool buffer owned by us until handed to the sender (or released)
+    SensorWindow* window = sensorTakeWindow();
+    if (!window) return;
 
-    _bleEcgSentIndex = 0;  // Reset BLE ECG tracking for new window
+    // HRV goes out over BLE whether or not the window is uploaded
+    bleNotifyHrv(window->hrv);
+    screenWindow(*window);
+    scoreWindowLocally(*window);
 
 #if !WIFI_MODE_ENABLED
-    Serial.printf("[WINDOW] %u samples, %u beats, HR=%.1f, SpO2=%u, LeadOff=%d\n",
-        window.ecgSampleCount, window.beatCount,
-        window.heartRateBpm, window.spo2Percent, window.ecgLeadOff);
+    Serial.printf("[WINDOW] %u samples, %u beats, HR=%.1f, SpO2=%u, SDNN=%.1f, RMSSD=%.1f, LeadOff=%d, Dropped=%u, Jitter=%uus\n",
+        window->ecgSampleCount, window->beatCount,
+        window->heartRateBpm, window->spo2Percent, window->hrv.sdnnMs, window->hrv.rmssdMs, window->ecgLeadOff,
+        window->ecgDroppedSamples, window->ecgMaxJitterUs);
+    windowPoolRelease(window);
     return;
 #else
-    if (!wifiIsReady()) {
-        Serial.println("[WINDOW] WiFi not ready, data discarded.");
-        return;
-    }
-
+    // Offline or unsynced (timestamp 0) windows are stored by the sender
     time_t timestamp = wifiGetTimestamp();
-    if (timestamp == 0) {
-        Serial.println("[WINDOW] NTP not synced, data discarded.");
-        return;
-    }
+
+    // Window belongs to the sender task after enqueue; log from locals
+    uint16_t sampleCount = window->ecgSampleCount;
+    uint16_t dropped = window->ecgDroppedSamples;
+    uint16_t jitterUs = window->ecgMaxJitterUs;
 
     // Enqueue for background task on Core 0 (non-blocking)
     if (dataSenderEnqueue(window, wifiGetDeviceId(), timestamp)) {
-        Serial.printf("[WINDOW] Queued %u samples for send\n", window.ecgSampleCount);
+        Serial.printf("[WINDOW] Queued %u samples for send (dropped=%u, jitter=%uus)\n",
+            sampleCount, dropped, jitterUs);
     }
 #endif
 }
 
+// --- Sample latency reports from the acquisition side ---
+static void checkLatencyReport() {
+    SensorLatencyReport lat;
+    while (sensorPollLatencyReport(lat)) {
+        if (plotterMode) continue;
+        Serial.printf("[LATENCY] %lu samples: p50 %luus, p99 %luus, p99.9 %luus, max %luus, %lu over %luus\n",
+            (unsigned long)lat.samples, (unsigned long)lat.p50Us, (unsigned long)lat.p99Us,
+            (unsigned long)lat.p999Us, (unsigned long)lat.maxUs, (unsigned long)lat.overBudget,
+            (unsigned long)SENSOR_LATENCY_BUDGET_US);
+    }
+}
+
 // --- Check for results from background send task ---
 static void checkSendResult() {
     DataSendResult res;
@@ -236,7 +304,7 @@ void setup() {
 #endif
 
     Serial.println("\nPlace finger on MAX30100. Attach ECG electrodes.");
-    Serial.println("Send 'p'=Plotter, 't'=Text, 'b'=BLE Provisioning");
+    Serial.println("Send 'p'=Plotter, 't'=Text, 'b'=BLE Provisioning, 'm'=DSP benchmark");
     Serial.println("--------------------------------------------\n");
 }
 
@@ -244,7 +312,8 @@ void setup() {
 //  LOOP
 // ============================================================
 void loop() {
-    // CRITICAL: Sensor update must be called as frequently as possible
+    // Acquisition + DSP when SENSOR_TASK is 0 (then as frequently as
+    // possible); otherwise the sensor task runs them and this returns
     sensorUpdate();
 
     // Serial output (always active)
@@ -298,6 +367,7 @@ void loop() {
     // Handle completed 10s data window
     handleDataWindow();
     checkSendResult();
+    checkLatencyReport();
 
     // BLE vitals notifications (every 1 second, only if client connected)
     if (bleIsClientConnected() && millis() - _lastBleNotify >= BLE_VITALS_NOTIFY_MS) {
@@ -317,12 +387,18 @@ void loop() {
     // BLE ECG streaming (every ECG_BLE_NOTIFY_MS, only if client connected)
     if (bleIsClientConnected() && millis() - _lastBleEcgNotify >= ECG_BLE_NOTIFY_MS) {
         _lastBleEcgNotify = millis();
-        uint16_t currentIndex = sensorGetEcgIndex();
-        if (currentIndex > _bleEcgSentIndex) {
-            uint16_t count = currentIndex - _bleEcgSentIndex;
-            if (count > ECG_BLE_BATCH_MAX) count = ECG_BLE_BATCH_MAX;
-            bleNotifyEcgBatch(sensorGetEcgBuffer() + _bleEcgSentIndex, (uint8_t)count);
-            _bleEcgSentIndex += count;
+        uint32_t currentSeq = sensorGetEcgSeq();
+        uint8_t batchMax = bleEcgBatchMax();
+        // More than 1s behind (new client or stalled link): skip to live data
+        if (currentSeq - _bleEcgSentSeq > ECG_SAMPLE_RATE_HZ) {
+            _bleEcgSentSeq = currentSeq - batchMax;
+        }
+        if (currentSeq != _bleEcgSentSeq) {
+            uint16_t count = min(currentSeq - _bleEcgSentSeq, (uint32_t)batchMax);
+            static_assert(ECG_BLE_RICE_BATCH_MAX >= ECG_BLE_BATCH_MAX, "batch must fit either format");
+            uint16_t batch[ECG_BLE_RICE_BATCH_MAX];
+            count = sensorCopyEcg(_bleEcgSentSeq, batch, count);
+            _bleEcgSentSeq += bleNotifyEcgBatch(batch, (uint8_t)count);
         }
     }
 
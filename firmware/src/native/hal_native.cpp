@@ -0,0 +1,569 @@
+#include "hal_native.h"
+#include "config.h"
+#include "MAX30100_Registers.h"
+
+#include <Arduino.h>
+#include <Wire.h>
+#include <LittleFS.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if ECG_ACQ_MODE == ECG_ACQ_DMA
+#error "ECG_ACQ_DMA uses the ESP32 I2S peripheral and has no host implementation"
+#endif
+
+HardwareSerial Serial;
+TwoWire        Wire;
+LittleFSFS     LittleFS;
+
+// ============================================================
+//  Virtual clock
+// ============================================================
+struct NativeTimer {
+    void   (*callback)(void*);
+    int64_t periodUs;
+    int64_t nextUs;
+};
+
+static std::atomic<int64_t> _nowUs(0);
+static std::vector<NativeTimer> _timers;
+static std::thread::id _driverThread = std::this_thread::get_id();
+
+static bool isDriverThread() {
+    return std::this_thread::get_id() == _driverThread;
+}
+
+// One step of waiting for something another thread (or the clock) does
+static void idleTick() {
+    if (isDriverThread()) {
+        halNativeAdvance(1000);
+    } else {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+void halNativeAdvance(uint32_t us) {
+    int64_t target = _nowUs.load() + us;
+    while (true) {
+        NativeTimer* due = nullptr;
+        for (NativeTimer& t : _timers) {
+            if (t.nextUs <= target && (!due || t.nextUs < due->nextUs)) due = &t;
+        }
+        if (!due) break;
+
+        _nowUs.store(due->nextUs);
+        due->nextUs += due->periodUs;
+        due->callback(nullptr);
+    }
+    _nowUs.store(target);
+}
+
+uint32_t halMillis() { return (uint32_t)(_nowUs.load() / 1000); }
+int64_t  halMicros() { return _nowUs.load(); }
+
+void halDelay(uint32_t ms) {
+    if (isDriverThread()) {
+        halNativeAdvance(ms * 1000);
+        return;
+    }
+    int64_t until = _nowUs.load() + (int64_t)ms * 1000;
+    while (_nowUs.load() < until) idleTick();
+}
+
+// Real time, not the virtual clock: benchmarks measure the host CPU
+uint32_t halCycleCount() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+uint32_t halCycleHz() { return 1000000000UL; }
+
+bool halTimerStart(void (*callback)(void*), uint32_t periodUs, const char* name) {
+    (void)name;
+    _timers.push_back({ callback, periodUs, _nowUs.load() + periodUs });
+    return true;
+}
+
+// ============================================================
+//  GPIO / ADC
+// ============================================================
+static bool _pins[64];
+static HalNativeAdcSource _adcSource = nullptr;
+
+struct NativeIsr {
+    void (*isr)(void*);
+    void* arg;
+};
+static NativeIsr _isrs[64];
+
+void halPinMode(uint8_t pin, HalPinMode mode) { (void)pin; (void)mode; }
+bool halDigitalRead(uint8_t pin)              { return pin < 64 && _pins[pin]; }
+
+// Falling edges run the attached handler on the calling thread
+void halDigitalWrite(uint8_t pin, bool high) {
+    if (pin >= 64) return;
+    bool fell = _pins[pin] && !high;
+    _pins[pin] = high;
+    if (fell && _isrs[pin].isr) _isrs[pin].isr(_isrs[pin].arg);
+}
+
+void halNativeSetPin(uint8_t pin, bool high)  { halDigitalWrite(pin, high); }
+
+bool halAttachFallingIsr(uint8_t pin, void (*isr)(void*), void* arg) {
+    if (pin >= 64) return false;
+    _pins[pin] = true;                  // Pull-up
+    _isrs[pin].isr = isr;
+    _isrs[pin].arg = arg;
+    return true;
+}
+
+void halAdcInit(uint8_t pin) { (void)pin; }
+
+uint16_t halAdcRead(uint8_t pin) {
+    return _adcSource ? _adcSource(pin, _nowUs.load()) : 2048;
+}
+
+void halNativeSetAdcSource(HalNativeAdcSource source) { _adcSource = source; }
+
+// ============================================================
+//  I2C: fake MAX30100
+// ============================================================
+// The FIFO fills at 100Hz from the time of the last pointer reset. At most
+// FIFO_DEPTH - 1 samples are held so the pointers never read as empty when
+// full; older ones are counted as overflows instead.
+//
+// Interrupts: a 1ms timer raises SPO2_RDY/HR_RDY for each new sample and
+// A_FULL at FIFO_DEPTH - 1 held, and pulls PIN_MAX30100_INT low while an
+// enabled one is set. Reading the status register clears it and releases
+// the pin.
+#define FAKE_PART_ID            0x11
+#define FAKE_SAMPLE_PERIOD_US   10000
+
+static uint8_t  _regs[256];
+static int64_t  _fifoStartUs = 0;
+static uint32_t _fifoRead = 0;          // Samples taken out since the reset
+static HalNativePpgSource _ppgSource = nullptr;
+
+static void fifoSync() {
+    uint32_t produced = (uint32_t)((_nowUs.load() - _fifoStartUs) / FAKE_SAMPLE_PERIOD_US);
+    if (produced - _fifoRead > MAX30100_FIFO_DEPTH - 1) {
+        uint32_t lost = produced - _fifoRead - (MAX30100_FIFO_DEPTH - 1);
+        _regs[MAX30100_REG_FIFO_OVERFLOW_COUNTER] =
+            (uint8_t)min<uint32_t>(_regs[MAX30100_REG_FIFO_OVERFLOW_COUNTER] + lost, 0x0F);
+        _fifoRead += lost;
+    }
+    _regs[MAX30100_REG_FIFO_WRITE_POINTER] = produced & (MAX30100_FIFO_DEPTH - 1);
+    _regs[MAX30100_REG_FIFO_READ_POINTER] = _fifoRead & (MAX30100_FIFO_DEPTH - 1);
+}
+
+static uint32_t _intProduced = 0;       // Samples already flagged as ready
+
+static void fakeIntTick(void* arg) {
+    (void)arg;
+    uint8_t enabled = _regs[MAX30100_REG_INTERRUPT_ENABLE];
+    if (!enabled) return;
+
+    fifoSync();
+    uint32_t produced = (uint32_t)((_nowUs.load() - _fifoStartUs) / FAKE_SAMPLE_PERIOD_US);
+    uint8_t& status = _regs[MAX30100_REG_INTERRUPT_STATUS];
+    if (produced != _intProduced) {
+        _intProduced = produced;
+        status |= MAX30100_IS_SPO2_RDY | MAX30100_IS_HR_RDY;
+    }
+    if (produced - _fifoRead >= MAX30100_FIFO_DEPTH - 1) status |= MAX30100_IS_A_FULL;
+    halDigitalWrite(PIN_MAX30100_INT, !(status & enabled));
+}
+
+void halI2cBegin(uint8_t sda, uint8_t scl, uint32_t hz) { (void)sda; (void)scl; (void)hz; }
+void halI2cEnd() {}
+
+bool halI2cWrite(uint8_t addr, uint8_t reg, const uint8_t* data, uint8_t len) {
+    if (addr != MAX30100_I2C_ADDRESS || len == 0) return false;
+    uint8_t value = data[0];
+
+    switch (reg) {
+        case MAX30100_REG_FIFO_WRITE_POINTER:
+        case MAX30100_REG_FIFO_READ_POINTER:
+            _fifoStartUs = _nowUs.load();
+            _fifoRead = 0;
+            break;
+        case MAX30100_REG_MODE_CONFIGURATION:
+            // Reset and temperature conversions complete immediately
+            value &= ~(MAX30100_MC_RESET | MAX30100_MC_TEMP_EN);
+            break;
+        default:
+            break;
+    }
+    _regs[reg] = value;
+    return true;
+}
+
+uint8_t halI2cRead(uint8_t addr, uint8_t reg, uint8_t* data, uint8_t len) {
+    if (addr != MAX30100_I2C_ADDRESS) return 0;
+    fifoSync();
+
+    if (reg != MAX30100_REG_FIFO_DATA) {
+        for (uint8_t i = 0; i < len; i++) data[i] = _regs[(uint8_t)(reg + i)];
+        if (reg == MAX30100_REG_INTERRUPT_STATUS) {
+            _regs[MAX30100_REG_INTERRUPT_STATUS] = 0;
+            halDigitalWrite(PIN_MAX30100_INT, true);
+        }
+        return len;
+    }
+
+    // FIFO_DATA does not auto-increment: every 4 bytes pop one sample
+    uint8_t n = 0;
+    while (n + 4 <= len) {
+        uint16_t ir = 0, red = 0;
+        if (_ppgSource) _ppgSource(_fifoStartUs + (int64_t)_fifoRead * FAKE_SAMPLE_PERIOD_US, &ir, &red);
+        if (_regs[MAX30100_REG_FIFO_WRITE_POINTER] != _regs[MAX30100_REG_FIFO_READ_POINTER]) {
+            _fifoRead++;
+            _regs[MAX30100_REG_FIFO_OVERFLOW_COUNTER] = 0;      // Restarts on every pop
+            fifoSync();
+        }
+        data[n++] = ir >> 8;
+        data[n++] = ir & 0xFF;
+        data[n++] = red >> 8;
+        data[n++] = red & 0xFF;
+    }
+    return n;
+}
+
+void halNativeSetPpgSource(HalNativePpgSource source) { _ppgSource = source; }
+
+static struct FakeMax30100Init {
+    FakeMax30100Init() {
+        _regs[MAX30100_REG_PART_ID] = FAKE_PART_ID;
+        _regs[MAX30100_REG_TEMPERATURE_DATA_INT] = 30;
+        halTimerStart(fakeIntTick, 1000, "max30100-int");
+    }
+} _fakeMax30100Init;
+
+// ============================================================
+//  Queues / Tasks
+// ============================================================
+// Timeouts are in virtual milliseconds, like halDelay()
+struct NativeQueue {
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t> > items;
+    uint16_t depth;
+    uint16_t itemSize;
+};
+
+// Wait until ready() holds (called with the lock held). False on timeout.
+template<typename Ready>
+static bool queueWait(NativeQueue* q, std::unique_lock<std::mutex>& lock,
+                      uint32_t timeoutMs, Ready ready) {
+    if (ready()) return true;
+    if (timeoutMs == 0) return false;
+
+    int64_t until = _nowUs.load() + (int64_t)timeoutMs * 1000;
+    while (!ready()) {
+        if (timeoutMs != HAL_WAIT_FOREVER && _nowUs.load() >= until) return false;
+        if (isDriverThread()) {
+            lock.unlock();
+            idleTick();
+            lock.lock();
+        } else {
+            q->changed.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    return true;
+}
+
+HalQueue halQueueCreate(uint16_t depth, uint16_t itemSize) {
+    NativeQueue* q = new NativeQueue();
+    q->depth = depth;
+    q->itemSize = itemSize;
+    return q;
+}
+
+bool halQueueSend(HalQueue queue, const void* item, uint32_t timeoutMs) {
+    NativeQueue* q = (NativeQueue*)queue;
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!queueWait(q, lock, timeoutMs, [q] { return q->items.size() < q->depth; })) return false;
+
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.push_back(std::vector<uint8_t>(p, p + q->itemSize));
+    q->changed.notify_all();
+    return true;
+}
+
+bool halQueueReceive(HalQueue queue, void* item, uint32_t timeoutMs) {
+    NativeQueue* q = (NativeQueue*)queue;
+    std::unique_lock<std::mutex> lock(q->mutex);
+    if (!queueWait(q, lock, timeoutMs, [q] { return !q->items.empty(); })) return false;
+
+    memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    q->changed.notify_all();
+    return true;
+}
+
+void halQueueOverwrite(HalQueue queue, const void* item) {
+    NativeQueue* q = (NativeQueue*)queue;
+    std::lock_guard<std::mutex> lock(q->mutex);
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.clear();
+    q->items.push_back(std::vector<uint8_t>(p, p + q->itemSize));
+    q->changed.notify_all();
+}
+
+uint16_t halQueueCount(HalQueue queue) {
+    NativeQueue* q = (NativeQueue*)queue;
+    std::lock_guard<std::mutex> lock(q->mutex);
+    return (uint16_t)q->items.size();
+}
+
+// A give on the driver thread (a fake device interrupt) waits until the
+// woken task blocks in halSignalTake() again, so the task's work happens at
+// the virtual time of the interrupt and runs stay repeatable. The wait is
+// bounded in real time in case the task is itself waiting on the clock.
+struct NativeSignal {
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool given = false;
+    bool waiting = false;       // A task is blocked in halSignalTake()
+};
+
+HalSignal halSignalCreate() {
+    return new NativeSignal();
+}
+
+void halSignalGiveFromIsr(HalSignal signal) {
+    NativeSignal* s = (NativeSignal*)signal;
+    std::unique_lock<std::mutex> lock(s->mutex);
+    s->given = true;
+    s->changed.notify_all();
+    if (isDriverThread()) {
+        s->changed.wait_for(lock, std::chrono::milliseconds(50),
+                            [s] { return s->waiting && !s->given; });
+    }
+}
+
+// The driver thread stands in for the ESP32 timer task: same lockstep
+void halSignalGive(HalSignal signal) {
+    halSignalGiveFromIsr(signal);
+}
+
+bool halSignalTake(HalSignal signal, uint32_t timeoutMs) {
+    NativeSignal* s = (NativeSignal*)signal;
+    std::unique_lock<std::mutex> lock(s->mutex);
+    s->waiting = true;
+    s->changed.notify_all();
+
+    int64_t until = _nowUs.load() + (int64_t)timeoutMs * 1000;
+    while (!s->given) {
+        if (timeoutMs != HAL_WAIT_FOREVER && _nowUs.load() >= until) {
+            s->waiting = false;
+            return false;
+        }
+        if (isDriverThread()) {
+            lock.unlock();
+            idleTick();
+            lock.lock();
+        } else {
+            s->changed.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    s->given = false;
+    s->waiting = false;
+    return true;
+}
+
+bool halTaskStart(void (*fn)(void*), const char* name, uint32_t stackBytes,
+                  uint8_t priority, int8_t core) {
+    (void)name; (void)stackBytes; (void)priority; (void)core;
+    std::thread(fn, nullptr).detach();
+    return true;
+}
+
+// ============================================================
+//  Network: in-process HTTP/1.1 server
+// ============================================================
+// Requests are parsed as they are written; the response is ready as soon as
+// the last body byte arrives. The driver may flip the link or read the
+// stats while the DataSender thread is mid-request, hence the lock.
+static std::mutex  _netMutex;
+static bool        _netUp = true;
+static bool        _netConnected = false;
+static std::string _netIn;              // Bytes written, not yet a full request
+static std::string _netOut;             // Response bytes not yet read
+static size_t      _netOutPos = 0;
+static HalNativeNetStats _netStats = {};
+static HalNativeHttpHandler _httpHandler = nullptr;
+
+// Batch bodies ("CB", version, count, ...) get one stored result per record
+static int defaultHttpHandler(const HalNativeHttpRequest& req, char* response, size_t size) {
+    const char* batchPath = "/batch";
+    size_t pathLen = strlen(req.path);
+    if (pathLen >= strlen(batchPath) && !strcmp(req.path + pathLen - strlen(batchPath), batchPath)) {
+        uint8_t count = req.length >= 4 ? req.body[3] : 0;
+        size_t n = snprintf(response, size, "{\"results\":[");
+        for (uint8_t i = 0; i < count && n < size; i++) {
+            n += snprintf(response + n, size - n, "%s{\"id\":\"%u\"}", i ? "," : "", i);
+        }
+        if (n < size) snprintf(response + n, size - n, "],\"inserted\":%u}", count);
+        return 200;
+    }
+    snprintf(response, size,
+             "{\"prediction\":{\"risk_score\":0.12,\"risk_label\":\"low\",\"confidence\":0.9}}");
+    return 200;
+}
+
+static void netReset() {
+    _netConnected = false;
+    _netIn.clear();
+    _netOut.clear();
+    _netOutPos = 0;
+}
+
+static std::string headerValue(const std::string& head, const char* name) {
+    std::string key = std::string("\r\n") + name + ":";
+    size_t pos = 0;
+    while ((pos = head.find("\r\n", pos)) != std::string::npos) {
+        if (strncasecmp(head.c_str() + pos, key.c_str(), key.size()) == 0) {
+            size_t start = head.find_first_not_of(' ', pos + key.size());
+            return head.substr(start, head.find("\r\n", start) - start);
+        }
+        pos += 2;
+    }
+    return "";
+}
+
+// Serve every complete request in _netIn
+static void serveRequests() {
+    while (true) {
+        size_t headEnd = _netIn.find("\r\n\r\n");
+        if (headEnd == std::string::npos) return;
+        std::string head = _netIn.substr(0, headEnd + 2);
+        size_t length = strtoul(headerValue(head, "Content-Length").c_str(), nullptr, 10);
+        if (_netIn.size() < headEnd + 4 + length) return;
+
+        char method[8] = {0}, path[128] = {0};
+        sscanf(head.c_str(), "%7s %127s", method, path);
+        std::string contentType = headerValue(head, "Content-Type");
+
+        HalNativeHttpRequest req;
+        req.path = path;
+        req.contentType = contentType.c_str();
+        req.body = (const uint8_t*)_netIn.data() + headEnd + 4;
+        req.length = length;
+
+        static char body[1024];
+        HalNativeHttpHandler handler = _httpHandler ? _httpHandler : defaultHttpHandler;
+        body[0] = '\0';
+        int status = handler(req, body, sizeof(body));
+
+        char responseHead[160];
+        snprintf(responseHead, sizeof(responseHead),
+                 "HTTP/1.1 %d %s\r\n"
+                 "Content-Type: application/json\r\n"
+                 "Content-Length: %u\r\n"
+                 "Connection: keep-alive\r\n"
+                 "\r\n",
+                 status, status < 300 ? "OK" : "Error", (unsigned)strlen(body));
+        _netOut.append(responseHead).append(body);
+
+        _netStats.requests++;
+        _netStats.bodyBytes += length;
+        _netIn.erase(0, headEnd + 4 + length);
+    }
+}
+
+bool halNetResolve(const char* host) {
+    (void)host;
+    std::lock_guard<std::mutex> lock(_netMutex);
+    return _netUp;
+}
+
+bool halNetConnect(const char* host, uint16_t port, uint32_t timeoutMs) {
+    (void)host; (void)port; (void)timeoutMs;
+    std::lock_guard<std::mutex> lock(_netMutex);
+    if (!_netUp) return false;
+    netReset();
+    _netConnected = true;
+    _netStats.connects++;
+    return true;
+}
+
+size_t halNetWrite(const uint8_t* data, size_t len) {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    if (!_netConnected) return 0;
+    _netIn.append((const char*)data, len);
+    serveRequests();
+    return len;
+}
+
+int halNetAvailable() {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    return (int)(_netOut.size() - _netOutPos);
+}
+
+int halNetRead() {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    if (_netOutPos >= _netOut.size()) return -1;
+    return (uint8_t)_netOut[_netOutPos++];
+}
+
+int halNetPeek() {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    return _netOutPos < _netOut.size() ? (uint8_t)_netOut[_netOutPos] : -1;
+}
+
+bool halNetConnected() {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    return _netConnected;
+}
+
+void halNetClose() {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    netReset();
+}
+
+void halNativeSetHttpHandler(HalNativeHttpHandler handler) {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    _httpHandler = handler;
+}
+
+void halNativeSetNetUp(bool up) {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    _netUp = up;
+    if (!up) netReset();
+}
+
+HalNativeNetStats halNativeGetNetStats() {
+    std::lock_guard<std::mutex> lock(_netMutex);
+    return _netStats;
+}
+
+// ============================================================
+//  Arduino Stream timeouts
+// ============================================================
+int Stream::timedRead() {
+    auto start = std::chrono::steady_clock::now();
+    do {
+        int c = read();
+        if (c >= 0) return c;
+        std::this_thread::yield();
+    } while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(_timeout));
+    return -1;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    size_t count = 0;
+    while (count < length) {
+        int c = timedRead();
+        if (c < 0) break;
+        buffer[count++] = (char)c;
+    }
+    return count;
+}
@@ -0,0 +1,56 @@
+#ifndef HAL_NATIVE_H
+#define HAL_NATIVE_H
+
+#include "hal.h"
+
+// ============================================================
+//  Host controls for the native HAL ([env:native] only)
+// ============================================================
+// Time is virtual: it only moves when the driver (main_native.cpp) calls
+// halNativeAdvance(), which also fires halTimerStart() callbacks at their
+// due times on the driver thread. halDelay() on the driver thread advances
+// the clock; on other threads it waits for the driver to get there.
+//
+// Devices behind the HAL are fakes fed by the driver:
+//   - ADC pins read from an AdcSource (e.g. a recorded ECG)
+//   - a MAX30100 at its I2C address, FIFO filled at 100Hz from a PpgSource,
+//     interrupts on PIN_MAX30100_INT
+//   - the TLS connection is an in-process HTTP/1.1 server calling HttpHandler
+
+// ADC counts (12-bit) on pin at time us
+typedef uint16_t (*HalNativeAdcSource)(uint8_t pin, int64_t us);
+
+// MAX30100 IR/RED readout (16-bit) for the FIFO sample taken at time us
+typedef void     (*HalNativePpgSource)(int64_t us, uint16_t* ir, uint16_t* red);
+
+struct HalNativeHttpRequest {
+    const char*    path;
+    const char*    contentType;
+    const uint8_t* body;
+    size_t         length;
+};
+
+// Fill response (NUL-terminated JSON) and return the HTTP status
+typedef int      (*HalNativeHttpHandler)(const HalNativeHttpRequest& req,
+                                         char* response, size_t responseSize);
+
+struct HalNativeNetStats {
+    uint32_t connects;
+    uint32_t requests;
+    uint64_t bodyBytes;         // Request bodies received
+};
+
+void     halNativeAdvance(uint32_t us);
+
+void     halNativeSetAdcSource(HalNativeAdcSource source);
+void     halNativeSetPin(uint8_t pin, bool high);
+void     halNativeSetPpgSource(HalNativePpgSource source);
+
+// nullptr restores the default handler (200 with a fixed low-risk prediction,
+// or every record stored for a batch)
+void     halNativeSetHttpHandler(HalNativeHttpHandler handler);
+// Network down: DNS fails and open connections drop (store-and-forward runs)
+void     halNativeSetNetUp(bool up);
+HalNativeNetStats halNativeGetNetStats();
+
+#endif // HAL_NATIVE_H
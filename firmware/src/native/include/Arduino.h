@@ -0,0 +1,106 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// ============================================================
+//  Host stand-in for the Arduino core ([env:native] only)
+// ============================================================
+// Just the part of the API used by the pipeline modules and the MAX30100
+// library. Time comes from the HAL virtual clock, Serial is stdout.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+
+#include "hal.h"
+
+using std::min;
+using std::max;
+
+#define HIGH    0x1
+#define LOW     0x0
+#define INPUT   0x01
+#define OUTPUT  0x03
+
+#define DEC     10
+#define HEX     16
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+inline uint32_t millis()            { return halMillis(); }
+inline uint32_t micros()            { return (uint32_t)halMicros(); }
+inline void     delay(uint32_t ms)  { halDelay(ms); }
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size) {
+        size_t n = 0;
+        while (size--) n += write(*buffer++);
+        return n;
+    }
+    size_t write(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buf[256];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        if (n <= 0) return 0;
+        return write((const uint8_t*)buf, (size_t)n < sizeof(buf) ? n : sizeof(buf) - 1);
+    }
+
+    size_t print(const char* s)                 { return write(s); }
+    size_t print(char c)                        { return write((uint8_t)c); }
+    size_t print(int v, int base = DEC)         { return printf(base == HEX ? "%X" : "%d", v); }
+    size_t print(unsigned v, int base = DEC)    { return printf(base == HEX ? "%X" : "%u", v); }
+    size_t print(long v, int base = DEC)        { return printf(base == HEX ? "%lX" : "%ld", v); }
+    size_t print(unsigned long v, int base = DEC) { return printf(base == HEX ? "%lX" : "%lu", v); }
+    size_t print(double v, int digits = 2)      { return printf("%.*f", digits, v); }
+
+    size_t println()                            { return write("\r\n"); }
+    template<typename T> size_t println(T v)    { size_t n = print(v); return n + println(); }
+    template<typename T> size_t println(T v, int f) { size_t n = print(v, f); return n + println(); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeoutMs) { _timeout = timeoutMs; }
+
+    // Waits on the host's real clock: the virtual clock may not move while
+    // another thread is blocked here
+    virtual size_t readBytes(char* buffer, size_t length);
+    size_t readBytes(uint8_t* buffer, size_t length) { return readBytes((char*)buffer, length); }
+
+protected:
+    int timedRead();
+    unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) override { return fputc(c, stdout) == EOF ? 0 : 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { return fwrite(buffer, 1, size, stdout); }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    using Print::write;
+};
+
+extern HardwareSerial Serial;
+
+#endif // NATIVE_ARDUINO_H
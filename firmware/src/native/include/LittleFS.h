@@ -0,0 +1,122 @@
+#ifndef NATIVE_LITTLEFS_H
+#define NATIVE_LITTLEFS_H
+
+// Host stand-in for the ESP32 LittleFS API ([env:native] only).
+// Paths are mapped under a directory on the host (setRoot(), default
+// "native_fs" in the working directory), so the store survives between runs
+// just like flash survives a reboot.
+
+#include <Arduino.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <memory>
+#include <string>
+
+#define FILE_READ       "r"
+#define FILE_WRITE      "w"
+#define FILE_APPEND     "a"
+
+class File : public Stream {
+public:
+    File() {}
+    File(FILE* f, const std::string& name)
+        : _f(f, fclose), _name(name) {}
+    File(DIR* d, const std::string& name, const std::string& path)
+        : _dir(d, closedir), _name(name), _path(path) {}
+
+    operator bool() const { return _f || _dir; }
+
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* buffer, size_t size) override {
+        return _f ? fwrite(buffer, 1, size, _f.get()) : 0;
+    }
+    using Print::write;
+
+    int available() override {
+        if (!_f) return 0;
+        long pos = ftell(_f.get());
+        return (int)(size() - pos);
+    }
+    int read() override { return _f ? fgetc(_f.get()) : -1; }
+    int peek() override {
+        if (!_f) return -1;
+        int c = fgetc(_f.get());
+        if (c != EOF) ungetc(c, _f.get());
+        return c;
+    }
+    size_t read(uint8_t* buffer, size_t size) {
+        return _f ? fread(buffer, 1, size, _f.get()) : 0;
+    }
+
+    bool seek(uint32_t pos) { return _f && fseek(_f.get(), pos, SEEK_SET) == 0; }
+    size_t size() {
+        struct stat st;
+        if (!_f) return 0;
+        fflush(_f.get());
+        return fstat(fileno(_f.get()), &st) == 0 ? (size_t)st.st_size : 0;
+    }
+    const char* name() const { return _name.c_str(); }
+    bool isDirectory() const { return (bool)_dir; }
+
+    void close() {
+        _f.reset();
+        _dir.reset();
+    }
+
+    File openNextFile() {
+        struct dirent* e;
+        while (_dir && (e = readdir(_dir.get()))) {
+            if (e->d_name[0] == '.') continue;
+            std::string full = _path + "/" + e->d_name;
+            FILE* f = fopen(full.c_str(), "rb");
+            if (f) return File(f, e->d_name);
+        }
+        return File();
+    }
+
+private:
+    std::shared_ptr<FILE> _f;
+    std::shared_ptr<DIR> _dir;
+    std::string _name;
+    std::string _path;
+};
+
+class LittleFSFS {
+public:
+    void setRoot(const char* root) { _root = root; }
+
+    bool begin(bool formatOnFail = false) {
+        (void)formatOnFail;
+        struct stat st;
+        if (stat(_root.c_str(), &st) == 0) return S_ISDIR(st.st_mode);
+        return ::mkdir(_root.c_str(), 0755) == 0;
+    }
+    bool exists(const char* path) {
+        struct stat st;
+        return stat(full(path).c_str(), &st) == 0;
+    }
+    bool mkdir(const char* path)  { return ::mkdir(full(path).c_str(), 0755) == 0; }
+    bool remove(const char* path) { return ::unlink(full(path).c_str()) == 0; }
+
+    File open(const char* path, const char* mode = FILE_READ) {
+        std::string p = full(path);
+        struct stat st;
+        if (mode[0] == 'r' && stat(p.c_str(), &st) == 0 && S_ISDIR(st.st_mode)) {
+            DIR* d = opendir(p.c_str());
+            return d ? File(d, path, p) : File();
+        }
+        const char* m = mode[0] == 'a' ? "ab" : mode[0] == 'w' ? "wb" : "rb";
+        FILE* f = fopen(p.c_str(), m);
+        return f ? File(f, path) : File();
+    }
+
+private:
+    std::string full(const char* path) const { return _root + path; }
+
+    std::string _root = "native_fs";
+};
+
+extern LittleFSFS LittleFS;
+
+#endif // NATIVE_LITTLEFS_H
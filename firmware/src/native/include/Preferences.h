@@ -0,0 +1,51 @@
+#ifndef NATIVE_PREFERENCES_H
+#define NATIVE_PREFERENCES_H
+
+// Host stand-in for the ESP32 NVS Preferences API ([env:native] only).
+// Values live in memory for the life of the process.
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        (void)readOnly;
+        _ns = name;
+        return true;
+    }
+    void end() {}
+
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0) {
+        return get(key, defaultValue);
+    }
+    size_t putUInt(const char* key, uint32_t value) {
+        store()[_ns + "/" + key] = value;
+        return sizeof(value);
+    }
+    int64_t getLong64(const char* key, int64_t defaultValue = 0) {
+        return get(key, defaultValue);
+    }
+    size_t putLong64(const char* key, int64_t value) {
+        store()[_ns + "/" + key] = value;
+        return sizeof(value);
+    }
+    bool remove(const char* key) {
+        return store().erase(_ns + "/" + key) > 0;
+    }
+
+private:
+    static std::map<std::string, int64_t>& store() {
+        static std::map<std::string, int64_t> values;
+        return values;
+    }
+    int64_t get(const char* key, int64_t defaultValue) {
+        auto it = store().find(_ns + "/" + key);
+        return it == store().end() ? defaultValue : it->second;
+    }
+
+    std::string _ns;
+};
+
+#endif // NATIVE_PREFERENCES_H
@@ -0,0 +1,59 @@
+#ifndef NATIVE_WIRE_H
+#define NATIVE_WIRE_H
+
+// Host stand-in for the Arduino TwoWire master ([env:native] only).
+// Register transactions are forwarded to halI2cWrite()/halI2cRead().
+
+#include <Arduino.h>
+
+class TwoWire {
+public:
+    bool begin(int sda, int scl, uint32_t hz = 100000) { halI2cBegin(sda, scl, hz); return true; }
+    void end() { halI2cEnd(); }
+    void setClock(uint32_t) {}
+
+    void beginTransmission(uint8_t addr) {
+        _addr = addr;
+        _txLen = 0;
+    }
+    size_t write(uint8_t c) {
+        if (_txLen >= sizeof(_tx)) return 0;
+        _tx[_txLen++] = c;
+        return 1;
+    }
+    size_t write(const uint8_t* data, size_t len) {
+        size_t n = 0;
+        while (n < len && write(data[n])) n++;
+        return n;
+    }
+    // A lone register byte only sets the read pointer for requestFrom()
+    uint8_t endTransmission(bool stop = true) {
+        (void)stop;
+        if (_txLen == 0) return 0;
+        _reg = _tx[0];
+        if (_txLen == 1) return 0;
+        return halI2cWrite(_addr, _tx[0], _tx + 1, _txLen - 1) ? 0 : 4;
+    }
+    uint8_t requestFrom(uint8_t addr, uint8_t len) {
+        if (len > sizeof(_rx)) len = sizeof(_rx);
+        _rxLen = halI2cRead(addr, _reg, _rx, len);
+        _rxPos = 0;
+        return _rxLen;
+    }
+    uint8_t requestFrom(int addr, int len) { return requestFrom((uint8_t)addr, (uint8_t)len); }
+    int available() { return _rxLen - _rxPos; }
+    int read() { return _rxPos < _rxLen ? _rx[_rxPos++] : -1; }
+
+private:
+    uint8_t _addr = 0;
+    uint8_t _reg = 0;
+    uint8_t _tx[32];
+    uint8_t _txLen = 0;
+    uint8_t _rx[64];
+    uint8_t _rxLen = 0;
+    uint8_t _rxPos = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // NATIVE_WIRE_H
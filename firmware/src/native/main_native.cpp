@@ -0,0 +1,430 @@
+/*
+ * ESP32 Cardiac Monitor - host replay ([env:native])
+ *
+ * Runs the firmware pipeline (sensor_manager -> window_pool -> data_sender
+ * -> window_store / api_client) as a Linux program on the HAL virtual clock.
+ * Sources are described in replay_source.h:
+ *   - AD8232 output: WFDB records (PTB-XL, MIT-BIH), a text file of ADC
+ *     counts or a synthetic PQRST train
+ *   - MAX30100: synthetic PPG following the ECG beats
+ *   - backend: the in-process HTTP server of hal_native.cpp
+ *
+ * The sensor path depends only on virtual time, so --out is identical
+ * between runs of the same input (regression baseline).
+ *
+ * Usage:
+ *   program [--record PATH]... [--lead II] [--gain VV] [--ecg FILE]...
+ *           [--hr BPM] [--ppg-noise RMS] [--seconds N] [--offline FROM:TO]
+ *           [--loop-load MS:EVERY] [--http-status CODE:FROM:TO]
+ *           [--out FILE.csv] [--fs DIR]
+ *   program --bench [SAMPLES]
+ *   program [--record PATH]... [--ecg FILE]... [--seconds N] --filter-check
+ *   program [--record PATH]... [--seconds N] --qrs-check
+ *
+ *   --record PATH      WFDB record without extension (repeat to concatenate;
+ *                      --lead and --gain apply to the records after them)
+ *   --seconds N        simulated time (default: loaded length, or 60)
+ *   --offline FROM:TO  network down between FROM and TO seconds (the
+ *                      windows go through the flash store and the batch path)
+ *   --loop-load MS:EVERY  loop() blocked for MS ms every EVERY ms, as by a
+ *                      TLS handshake or a BLE notification burst; the
+ *                      [LATENCY] reports show whether acquisition kept up
+ *   --http-status CODE:FROM:TO  the backend answers every request with HTTP
+ *                      CODE between FROM and TO seconds (401 expired key,
+ *                      429 rate limit, 404 no batch endpoint, 422 ...)
+ *   --out FILE.csv     one line per window
+ *   --fs DIR           directory standing in for LittleFS (default native_fs)
+ *   --bench [SAMPLES]  print the DSP microbenchmarks (dsp_bench.h) as JSON
+ *                      and exit
+ *   --filter-check     run the float and fixed-point ECG filter chains over
+ *                      the loaded ECG and compare them (exit 1 above 1 count)
+ *   --qrs-check        run the ECG chain and the QRS detector over the loaded
+ *                      records and score the R peaks against the reference
+ *                      (.atr annotations when present), 150 ms tolerance
+ */
+
+#include <Arduino.h>
+#include <LittleFS.h>
+#include "config.h"
+#include "sensor_manager.h"
+#include "wifi_manager.h"
+#include "data_sender.h"
+#include "window_pool.h"
+#include "window_store.h"
+#include "dsp_bench.h"
+#include "ecg_filter.h"
+#include "qrs_detector.h"
+#include "ecg_cnn.h"
+#include "hal_native.h"
+#include "replay_source.h"
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+static const char* USAGE =
+    "Usage: %s [--record PATH]... [--lead II] [--gain VV] [--ecg FILE]...\n"
+    "          [--hr BPM] [--ppg-noise RMS] [--seconds N] [--offline FROM:TO]\n"
+    "          [--loop-load MS:EVERY] [--http-status CODE:FROM:TO]\n"
+    "          [--out FILE.csv] [--fs DIR]\n"
+    "       %s --bench [SAMPLES]\n"
+    "       %s [--record PATH]... [--ecg FILE]... [--seconds N] --filter-check\n"
+    "       %s [--record PATH]... [--seconds N] --qrs-check\n";
+
+// FNV-1a over the window samples: changes whenever the filtered ECG does
+static uint32_t ecgHash(const SensorWindow& w) {
+    uint32_t h = 2166136261u;
+    for (uint16_t i = 0; i < w.ecgSampleCount; i++) {
+        h = (h ^ (w.ecgSamples[i] & 0xFF)) * 16777619u;
+        h = (h ^ (w.ecgSamples[i] >> 8)) * 16777619u;
+    }
+    return h;
+}
+
+// Keeps the virtual clock in step with the benchmark's PPG samples
+static void benchTick(uint32_t us) {
+    halNativeAdvance(us);
+}
+
+// Float and fixed-point ECG chains side by side, as processEcgSample()
+// runs them. Returns the largest difference of the output in counts.
+static int filterCheck(uint32_t seconds) {
+    EcgNotch notch;
+    EcgLowPass lpf;
+    EcgDCRemover dc;
+    EcgNotchFixed notchQ;
+    EcgLowPassFixed lpfQ;
+    EcgDCRemoverFixed dcQ;
+
+    uint32_t samples = seconds * ECG_SAMPLE_RATE_HZ, compared = 0, differ = 0;
+    int maxDiff = 0;
+    double maxErr = 0, sumSq = 0;
+    for (uint32_t i = 0; i < samples; i++) {
+        int64_t us = (int64_t)i * ECG_SAMPLE_PERIOD_US;
+        if (replayLeadOff(us)) {
+            notch.reset(); lpf.reset(); dc.reset();
+            notchQ.reset(); lpfQ.reset(); dcQ.reset();
+            continue;
+        }
+        float x = replayEcgAdc(PIN_ECG_OUTPUT, us);
+        float centered = dc.step(lpf.step(notch.step(x)));
+        int32_t centeredQ = dcQ.step(lpfQ.step(notchQ.step(ecgToFixed(x))));
+
+        double err = fabs((double)centeredQ / (1 << ECG_Q_SHIFT) - centered);
+        sumSq += err * err;
+        if (err > maxErr) maxErr = err;
+
+        int d = abs(constrain((int)(centered + 2048.0f), 0, 4095) -
+                    constrain(ecgFixedToCounts(centeredQ) + 2048, 0, 4095));
+        if (d) differ++;
+        if (d > maxDiff) maxDiff = d;
+        compared++;
+    }
+
+    Serial.printf("Filter check: %u samples, %u differ (max %d counts)\n",
+                  compared, differ, maxDiff);
+    Serial.printf("  Before rounding: max %.5f, RMS %.5f counts\n",
+                  maxErr, compared ? sqrt(sumSq / compared) : 0.0);
+    return maxDiff;
+}
+
+// Detected R peaks against the reference, as in the MIT-BIH evaluations
+// (ANSI/AAMI EC57): a detection within QRS_MATCH_MS of a reference beat is
+// a true positive. Beats in the first QRS_LEARN_MS after the start or a
+// lead-off are not scored, the detector is training there, nor the ones in
+// the last QRS_LATENCY_MS before a lead-off, which it never gets to decide.
+#define QRS_MATCH_MS    150
+
+static void qrsCheck(uint32_t seconds) {
+    const uint32_t* ref;
+    bool annotated;
+    size_t refCount = replayReferencePeaks(&ref, &annotated);
+    uint32_t samples = min(seconds * ECG_SAMPLE_RATE_HZ,
+                           (uint32_t)((uint64_t)replayDurationMs() * ECG_SAMPLE_RATE_HZ / 1000));
+
+    EcgNotch notch;
+    EcgLowPass lpf;
+    EcgDCRemover dc;
+    QrsDetector qrs;
+    std::vector<uint32_t> found;
+    std::vector<bool> scored(samples, true);
+    uint32_t learnUntil = QRS_LEARN_MS * ECG_SAMPLE_RATE_HZ / 1000;
+    const uint32_t latency = QRS_LATENCY_MS * ECG_SAMPLE_RATE_HZ / 1000;
+    for (uint32_t i = 0; i < samples; i++) {
+        int64_t us = (int64_t)i * ECG_SAMPLE_PERIOD_US;
+        if (replayLeadOff(us)) {
+            notch.reset(); lpf.reset(); dc.reset();
+            qrs.reset();
+            learnUntil = i + 1 + QRS_LEARN_MS * ECG_SAMPLE_RATE_HZ / 1000;
+            for (uint32_t j = i > latency ? i - latency : 0; j <= i; j++) scored[j] = false;
+            continue;
+        }
+        scored[i] = i >= learnUntil;
+        float centered = dc.step(lpf.step(notch.step(replayEcgAdc(PIN_ECG_OUTPUT, us))));
+        int value = constrain((int)(centered + 2048.0f), 0, 4095);
+        uint32_t ago;
+        if (qrs.step(value - 2048, ago)) found.push_back(i - ago);
+    }
+
+    const uint32_t tol = QRS_MATCH_MS * ECG_SAMPLE_RATE_HZ / 1000;
+    uint32_t tp = 0, fn = 0, fp = 0;
+    double errSum = 0;
+    size_t d = 0;
+    for (size_t r = 0; r < refCount && ref[r] < samples; r++) {
+        // Detections before this beat's window matched nothing
+        while (d < found.size() && found[d] + tol < ref[r]) {
+            if (scored[found[d]]) fp++;
+            d++;
+        }
+        bool hit = d < found.size() && found[d] <= ref[r] + tol;
+        if (!scored[ref[r]]) {
+            if (hit) d++;
+            continue;
+        }
+        if (hit) {
+            tp++;
+            errSum += fabs((double)found[d] - ref[r]);
+            d++;
+        } else {
+            fn++;
+        }
+    }
+    for (; d < found.size(); d++) {
+        if (scored[found[d]]) fp++;
+    }
+
+    Serial.printf("QRS check: %u s, %u reference beats (%s)\n", samples / ECG_SAMPLE_RATE_HZ,
+                  tp + fn, annotated ? "annotations" : "located at load time");
+    Serial.printf("  TP %u  FN %u  FP %u  Se %.2f%%  +P %.2f%%  mean |error| %.1f ms\n",
+                  tp, fn, fp, tp + fn ? 100.0 * tp / (tp + fn) : 0.0,
+                  tp + fp ? 100.0 * tp / (tp + fp) : 0.0,
+                  tp ? errSum / tp * 1000.0 / ECG_SAMPLE_RATE_HZ : 0.0);
+}
+
+// ============================================================
+//  Replay
+// ============================================================
+// --http-status: every request fails with this code
+static int _httpStatus = 0;
+
+static int errorHttpHandler(const HalNativeHttpRequest& req, char* response, size_t size) {
+    (void)req;
+    snprintf(response, size, "{\"detail\":\"simulated HTTP %d\"}", _httpStatus);
+    return _httpStatus;
+}
+
+static bool senderIdle() {
+    return windowPoolAvailable() == WINDOW_POOL_SIZE && !dataSenderIsBusy();
+}
+
+int main(int argc, char** argv) {
+    uint32_t seconds = 0;
+    uint32_t offlineFrom = 0, offlineTo = 0;
+    uint32_t loadMs = 0, loadEvery = 0;
+    uint32_t httpFrom = 0, httpTo = 0;
+    const char* lead = nullptr;
+    float gain = REPLAY_AD8232_GAIN;
+    FILE* out = nullptr;
+    bool checkFilters = false;
+    bool checkQrs = false;
+
+    for (int i = 1; i < argc; i++) {
+        bool more = i + 1 < argc;
+        bool ok = true;
+        if (!strcmp(argv[i], "--bench")) {
+            uint32_t samples = more ? strtoul(argv[i + 1], nullptr, 10) : 0;
+            dspBenchRun(Serial, samples ? samples : DSP_BENCH_SAMPLES, benchTick);
+            fflush(stdout);
+            _exit(0);
+        } else if (!strcmp(argv[i], "--filter-check")) {
+            checkFilters = true;
+        } else if (!strcmp(argv[i], "--qrs-check")) {
+            checkQrs = true;
+        } else if (!strcmp(argv[i], "--record") && more) {
+            ok = replayLoadWfdb(argv[++i], lead, gain);
+        } else if (!strcmp(argv[i], "--lead") && more) {
+            lead = argv[++i];
+        } else if (!strcmp(argv[i], "--gain") && more) {
+            gain = strtof(argv[++i], nullptr);
+        } else if (!strcmp(argv[i], "--ecg") && more) {
+            ok = replayLoadText(argv[++i]);
+            if (!ok) fprintf(stderr, "Cannot read ECG samples from %s\n", argv[i]);
+        } else if (!strcmp(argv[i], "--hr") && more) {
+            replaySetSynthetic(strtof(argv[++i], nullptr));
+        } else if (!strcmp(argv[i], "--ppg-noise") && more) {
+            replaySetPpgNoise(strtof(argv[++i], nullptr));
+        } else if (!strcmp(argv[i], "--seconds") && more) {
+            seconds = strtoul(argv[++i], nullptr, 10);
+        } else if (!strcmp(argv[i], "--offline") && more) {
+            ok = sscanf(argv[++i], "%u:%u", &offlineFrom, &offlineTo) == 2;
+        } else if (!strcmp(argv[i], "--loop-load") && more) {
+            ok = sscanf(argv[++i], "%u:%u", &loadMs, &loadEvery) == 2 && loadEvery > 0;
+        } else if (!strcmp(argv[i], "--http-status") && more) {
+            ok = sscanf(argv[++i], "%d:%u:%u", &_httpStatus, &httpFrom, &httpTo) == 3;
+        } else if (!strcmp(argv[i], "--out") && more) {
+            out = fopen(argv[++i], "w");
+            ok = out != nullptr;
+        } else if (!strcmp(argv[i], "--fs") && more) {
+            LittleFS.setRoot(argv[++i]);
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            fprintf(stderr, USAGE, argv[0], argv[0], argv[0], argv[0]);
+            return 1;
+        }
+    }
+    if (seconds == 0) {
+        seconds = replayDurationMs() ? (replayDurationMs() + 999) / 1000 : 60;
+    }
+    if (checkFilters) {
+        int maxDiff = filterCheck(seconds);
+        fflush(stdout);
+        _exit(maxDiff > 1 ? 1 : 0);
+    }
+    if (checkQrs) {
+        if (!replayDurationMs()) {
+            fprintf(stderr, "--qrs-check needs a --record\n");
+            return 1;
+        }
+        qrsCheck(seconds);
+        fflush(stdout);
+        _exit(0);
+    }
+
+    halNativeSetAdcSource(replayEcgAdc);
+    halNativeSetPpgSource(replayPpg);
+
+    if (!sensorInit()) {
+        Serial.println("FATAL: MAX30100 init failed");
+        return 1;
+    }
+    wifiInit();
+    dataSenderInit();
+    dataSenderStartTask();
+
+    if (out) {
+        fprintf(out, "window,start_ms,samples,beats,r_peaks,hr_bpm,spo2,sdnn_ms,rmssd_ms,pnn50,lead_off,dropped,max_jitter_us,ecg_hash\n");
+    }
+
+    uint32_t windows = 0, queued = 0, results = 0, failed = 0;
+    uint64_t updateNs = 0, updateMaxNs = 0;
+    uint32_t busyUntil = 0;
+    SensorLatencyReport worst = {0, 0, 0, 0, 0, 0};
+    int64_t startUs = halMicros();
+    auto wallStart = std::chrono::steady_clock::now();
+
+    for (uint32_t ms = 0; ms < seconds * 1000; ms++) {
+        uint32_t sec = ms / 1000;
+        if (ms % 1000 == 0) {
+            halNativeSetNetUp(!(sec >= offlineFrom && sec < offlineTo));
+            halNativeSetHttpHandler(sec >= httpFrom && sec < httpTo ? errorHttpHandler : nullptr);
+        }
+
+        halNativeAdvance(1000);
+        bool leadOff = replayLeadOff(halMicros() - startUs);
+        halNativeSetPin(PIN_ECG_LO_PLUS, leadOff);
+        halNativeSetPin(PIN_ECG_LO_MINUS, leadOff);
+
+        // Blocked loop(): the clock and the tasks run on, nothing below does
+        if (loadMs && ms % loadEvery == 0) busyUntil = ms + loadMs;
+        if (ms < busyUntil) continue;
+
+        auto t0 = std::chrono::steady_clock::now();
+        sensorUpdate();
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+        updateNs += ns;
+        if (ns > updateMaxNs) updateMaxNs = ns;
+
+        if (sensorIsWindowReady()) {
+            SensorWindow* window = sensorTakeWindow();
+            if (window) {
+                // CNN screen as main.cpp does, uploaded with the window
+                if (!window->ecgLeadOff) {
+                    ecgCnnScore(window->ecgSamples, window->ecgSampleCount, window->screenScore);
+                }
+                Serial.printf("[WINDOW] %u samples, %u beats, %u R peaks, HR=%.1f, SpO2=%u, Dropped=%u\n",
+                              window->ecgSampleCount, window->beatCount, window->rPeakCount,
+                              window->heartRateBpm, window->spo2Percent,
+                              window->ecgDroppedSamples);
+                if (out) {
+                    fprintf(out, "%u,%lu,%u,%u,%u,%.1f,%u,%.1f,%.1f,%.1f,%d,%u,%u,%08x\n",
+                            windows, (unsigned long)window->windowStartMs,
+                            window->ecgSampleCount, window->beatCount, window->rPeakCount,
+                            window->heartRateBpm, window->spo2Percent,
+                            window->hrv.sdnnMs, window->hrv.rmssdMs, window->hrv.pnn50Percent,
+                            window->ecgLeadOff,
+                            window->ecgDroppedSamples, window->ecgMaxJitterUs,
+                            ecgHash(*window));
+                }
+                windows++;
+                if (dataSenderEnqueue(window, wifiGetDeviceId(), wifiGetTimestamp())) queued++;
+            }
+        }
+
+        DataSendResult res;
+        if (dataSenderPollResult(res)) {
+            if (res.result == SEND_OK) results++;
+            else failed++;
+        }
+
+        SensorLatencyReport lat;
+        while (sensorPollLatencyReport(lat)) {
+            Serial.printf("[LATENCY] %u samples: p50 %uus, p99 %uus, p99.9 %uus, max %uus, %u over %luus\n",
+                          lat.samples, lat.p50Us, lat.p99Us, lat.p999Us, lat.maxUs, lat.overBudget,
+                          (unsigned long)SENSOR_LATENCY_BUDGET_US);
+            worst.samples += lat.samples;
+            worst.p50Us = max(worst.p50Us, lat.p50Us);
+            worst.p99Us = max(worst.p99Us, lat.p99Us);
+            worst.p999Us = max(worst.p999Us, lat.p999Us);
+            worst.maxUs = max(worst.maxUs, lat.maxUs);
+            worst.overBudget += lat.overBudget;
+        }
+
+        // Uploads are instant in virtual time: let the sender catch up
+        if (!senderIdle()) std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    if (out) fclose(out);
+
+    // Let the sender finish the last window and the stored backlog
+    halNativeSetNetUp(true);
+    for (uint32_t ms = 0; ms < 60000 && !(senderIdle() && storeIsEmpty()); ms++) {
+        halNativeAdvance(1000);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    double wallSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    HalNativeNetStats net = halNativeGetNetStats();
+
+    Serial.println("--------------------------------------------");
+    Serial.printf("  Simulated:  %u s in %.2f s (%.0fx real time)\n",
+                  seconds, wallSec, wallSec > 0 ? seconds / wallSec : 0.0);
+#if !SENSOR_TASK
+    uint32_t ticks = seconds * 1000;
+    Serial.printf("  sensorUpdate: %.0f ns avg, %llu ns max per 1 ms tick\n",
+                  ticks ? (double)updateNs / ticks : 0.0, (unsigned long long)updateMaxNs);
+#endif
+    Serial.printf("  Latency:    %u samples, worst period p50 %uus, p99 %uus, p99.9 %uus, max %uus, %u over budget (%s)\n",
+                  worst.samples, worst.p50Us, worst.p99Us, worst.p999Us, worst.maxUs, worst.overBudget,
+                  SENSOR_TASK ? "sensor task" : "loop()");
+    Serial.printf("  Windows:    %u taken, %u queued, %u live OK, %u live failed\n",
+                  windows, queued, results, failed);
+    Serial.printf("  Backend:    %u requests, %llu body bytes, %u connections\n",
+                  net.requests, (unsigned long long)net.bodyBytes, net.connects);
+    Serial.printf("  Store:      %u pending\n", (unsigned)storePendingCount());
+    Serial.printf("  Beats:      %u detected (PPG), %u in the reference (HR %.1f, SpO2 %u)\n",
+                  sensorGetBeatCount(), replayReferenceBeats((int64_t)seconds * 1000000),
+                  sensorGetHeartRate(), sensorGetSpO2());
+    Serial.printf("  R peaks:    %u detected (ECG QRS)\n", sensorGetRPeakCount());
+    SensorBusStats bus = sensorGetBusStats();
+    Serial.printf("  I2C:        %s %lukHz, %.1f transactions/s, %.0f bytes/s, %u errors\n",
+                  bus.burst ? "burst" : "per-sample", (unsigned long)(bus.clockHz / 1000),
+                  seconds ? (double)bus.transactions / seconds : 0.0,
+                  seconds ? (double)bus.bytes / seconds : 0.0, (unsigned)bus.errors);
+    fflush(stdout);
+
+    // The DataSender thread never returns; skip static destructors under it
+    _exit(0);
+}
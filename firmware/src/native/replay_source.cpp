@@ -0,0 +1,424 @@
+#include "replay_source.h"
+#include "config.h"
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+// ECG at ECG_SAMPLE_RATE_HZ in ADC counts, NaN = no valid sample
+static std::vector<float>    _ecg;
+static std::vector<uint32_t> _beats;        // Reference R peaks (sample index)
+static bool _beatsAnnotated = true;         // Every record had a .atr file
+static float _syntheticBpm = 72.0f;
+static float _ppgNoise = 0.0f;
+
+#define ADC_MID_COUNTS      2048.0f
+#define ADC_COUNTS_PER_V    (4096.0f / 3.3f)
+
+// ============================================================
+//  Reference R peaks
+// ============================================================
+// Slope energy over a per-record threshold, then the largest excursion
+// from the record mean within 100ms, with a 250ms refractory period.
+// Only needs to be good enough to time the synthetic PPG.
+static void findBeats(size_t from) {
+    size_t n = _ecg.size();
+    if (n < from + 3) return;
+
+    double mean = 0;
+    size_t valid = 0;
+    float peakEnergy = 0;
+    for (size_t i = from + 1; i + 1 < n; i++) {
+        if (isnan(_ecg[i])) continue;
+        mean += _ecg[i];
+        valid++;
+        float d = _ecg[i + 1] - _ecg[i - 1];
+        if (d * d > peakEnergy) peakEnergy = d * d;
+    }
+    if (valid == 0 || peakEnergy == 0) return;
+    mean /= valid;
+
+    const size_t search = ECG_SAMPLE_RATE_HZ / 10;
+    const size_t refractory = ECG_SAMPLE_RATE_HZ / 4;
+    float threshold = 0.3f * peakEnergy;
+    size_t i = from + 1;
+    while (i + 1 < n) {
+        float d = _ecg[i + 1] - _ecg[i - 1];
+        if (isnan(d) || d * d < threshold) {
+            i++;
+            continue;
+        }
+        size_t best = i;
+        for (size_t j = i; j < i + search && j < n; j++) {
+            if (fabsf(_ecg[j] - (float)mean) > fabsf(_ecg[best] - (float)mean)) best = j;
+        }
+        if (_beats.empty() || best - _beats.back() >= refractory) _beats.push_back(best);
+        i = best + refractory;
+    }
+}
+
+// ============================================================
+//  WFDB records
+// ============================================================
+struct WfdbSignal {
+    std::string file;
+    int    format;
+    float  gain;        // ADC units per mV
+    int    baseline;
+    std::string description;
+};
+
+static bool readHeader(const std::string& path, float& fs, long& frames,
+                       std::vector<WfdbSignal>& signals) {
+    FILE* f = fopen((path + ".hea").c_str(), "r");
+    if (!f) return false;
+
+    char line[512];
+    int nsig = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') continue;
+        if (nsig < 0) {
+            char name[128];
+            fs = 250.0f;
+            frames = 0;
+            if (sscanf(line, "%127s %d %f %ld", name, &nsig, &fs, &frames) < 2) break;
+            if (strchr(name, '/')) {
+                Serial.println("[REPLAY] Multi-segment WFDB records are not supported");
+                break;
+            }
+            continue;
+        }
+
+        char file[128], gainSpec[64] = "", desc[128] = "";
+        int format = 0, adcRes = 0, adcZero = 0, initValue = 0, checksum = 0, blockSize = 0;
+        int fields = sscanf(line, "%127s %d %63s %d %d %d %d %d %127[^\r\n]",
+                            file, &format, gainSpec, &adcRes, &adcZero,
+                            &initValue, &checksum, &blockSize, desc);
+        if (fields < 2) break;
+
+        WfdbSignal s;
+        s.file = file;
+        s.format = format;
+        s.gain = 200.0f;
+        s.baseline = adcZero;
+        // gain[(baseline)][/units]
+        float gain = 0;
+        if (sscanf(gainSpec, "%f", &gain) == 1 && gain > 0) s.gain = gain;
+        const char* paren = strchr(gainSpec, '(');
+        if (paren) s.baseline = atoi(paren + 1);
+        else if (fields < 5) s.baseline = 0;
+        const char* units = strchr(gainSpec, '/');
+        if (units && strncmp(units + 1, "uV", 2) == 0) s.gain /= 1000.0f;
+        s.description = desc;
+        signals.push_back(s);
+        if ((int)signals.size() == nsig) break;
+    }
+    fclose(f);
+    return nsig > 0 && (int)signals.size() == nsig;
+}
+
+// Decode every frame of one signal from its .dat file (raw ADC units,
+// INT32_MIN where the record marks the sample invalid)
+static bool readSamples(const std::string& dir, const std::vector<WfdbSignal>& signals,
+                        size_t index, std::vector<int32_t>& out) {
+    const WfdbSignal& sig = signals[index];
+    size_t column = 0, columns = 0;
+    for (size_t i = 0; i < signals.size(); i++) {
+        if (signals[i].file != sig.file) continue;
+        if (signals[i].format != sig.format) return false;
+        if (i == index) column = columns;
+        columns++;
+    }
+    if (sig.format != 16 && sig.format != 212) {
+        Serial.printf("[REPLAY] WFDB format %d is not supported (16 and 212 are)\n", sig.format);
+        return false;
+    }
+
+    FILE* f = fopen((dir + sig.file).c_str(), "rb");
+    if (!f) return false;
+    std::vector<uint8_t> raw;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) raw.insert(raw.end(), buf, buf + n);
+    fclose(f);
+
+    if (sig.format == 16) {
+        size_t count = raw.size() / 2;
+        for (size_t i = column; i < count; i += columns) {
+            int16_t v = (int16_t)(raw[2 * i] | (raw[2 * i + 1] << 8));
+            out.push_back(v == -32768 ? INT32_MIN : v);
+        }
+    } else {
+        // Two 12-bit samples in three bytes, in stream order across signals
+        size_t k = 0;
+        for (size_t b = 0; b + 2 < raw.size(); b += 3) {
+            int32_t s0 = raw[b] | ((raw[b + 1] & 0x0F) << 8);
+            int32_t s1 = raw[b + 2] | ((raw[b + 1] & 0xF0) << 4);
+            int32_t pair[2] = { s0, s1 };
+            for (int p = 0; p < 2; p++, k++) {
+                int32_t v = pair[p] >= 2048 ? pair[p] - 4096 : pair[p];
+                if (k % columns == column) out.push_back(v == -2048 ? INT32_MIN : v);
+            }
+        }
+    }
+    return !out.empty();
+}
+
+// Beat annotations of a MIT format .atr file, mapped from frames at fs to
+// samples at ECG_SAMPLE_RATE_HZ after offset. False when there is no file.
+//   16-bit words, little-endian: code (6 bits) << 10 | interval (10 bits)
+//   SKIP (59): 32-bit interval follows, high word first
+//   AUX (63): interval = byte length, padded to even
+//   NUM, SUB, CHN (60-62): no time step
+static bool readAnnotations(const std::string& path, float fs, size_t offset) {
+    FILE* f = fopen((path + ".atr").c_str(), "rb");
+    if (!f) return false;
+
+    // Beat codes of the MIT-BIH annotation set (ecgcodes.h)
+    static const uint8_t BEAT_CODES[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13,
+                                          25, 30, 34, 35, 38, 41 };
+    double step = (double)fs / ECG_SAMPLE_RATE_HZ;
+    int64_t frame = 0;
+    uint8_t w[4];
+    while (fread(w, 1, 2, f) == 2) {
+        int code = w[1] >> 2;
+        int interval = ((w[1] & 0x03) << 8) | w[0];
+        if (code == 0 && interval == 0) break;
+        if (code == 59) {
+            if (fread(w, 1, 4, f) != 4) break;
+            frame += (int32_t)((uint32_t)(w[0] | (w[1] << 8)) << 16 | (w[2] | (w[3] << 8)));
+        } else if (code == 63) {
+            fseek(f, (interval + 1) & ~1, SEEK_CUR);
+        } else if (code < 59) {
+            frame += interval;
+            for (uint8_t beat : BEAT_CODES) {
+                if (beat != code) continue;
+                size_t sample = offset + (size_t)(frame / step);
+                if (sample < _ecg.size()) _beats.push_back((uint32_t)sample);
+            }
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+static size_t findLead(const std::vector<WfdbSignal>& signals, const char* name) {
+    for (size_t i = 0; i < signals.size(); i++) {
+        if (strcasecmp(signals[i].description.c_str(), name) == 0) return i;
+    }
+    return signals.size();
+}
+
+// Default: lead II (PTB-XL), modified lead II (MIT-BIH), else signal 0
+static size_t pickLead(const std::vector<WfdbSignal>& signals, const char* lead) {
+    if (!lead) {
+        size_t i = findLead(signals, "II");
+        if (i == signals.size()) i = findLead(signals, "MLII");
+        return i < signals.size() ? i : 0;
+    }
+    size_t i = findLead(signals, lead);
+    if (i == signals.size() && lead[0] >= '0' && lead[0] <= '9') {
+        i = strtoul(lead, nullptr, 10);
+    }
+    return i < signals.size() ? i : signals.size();
+}
+
+bool replayLoadWfdb(const char* record, const char* lead, float gainVV) {
+    std::string path = record;
+    size_t slash = path.find_last_of('/');
+    std::string dir = slash == std::string::npos ? "" : path.substr(0, slash + 1);
+
+    float fs;
+    long frames;
+    std::vector<WfdbSignal> signals;
+    if (!readHeader(path, fs, frames, signals)) {
+        Serial.printf("[REPLAY] Cannot read WFDB header %s.hea\n", record);
+        return false;
+    }
+    size_t index = pickLead(signals, lead);
+    if (index >= signals.size()) {
+        Serial.printf("[REPLAY] %s has no lead %s\n", record, lead);
+        return false;
+    }
+
+    std::vector<int32_t> adu;
+    if (!readSamples(dir, signals, index, adu)) {
+        Serial.printf("[REPLAY] Cannot read samples of %s\n", record);
+        return false;
+    }
+
+    // mV -> AD8232 output -> ESP32 ADC counts, boxcar-resampled to the
+    // firmware rate (averaging doubles as the anti-alias filter)
+    const WfdbSignal& sig = signals[index];
+    float countsPerAdu = gainVV * ADC_COUNTS_PER_V / (sig.gain * 1000.0f);
+    double step = (double)fs / ECG_SAMPLE_RATE_HZ;
+    size_t from = _ecg.size();
+    size_t outCount = (size_t)(adu.size() / step + 1e-6);
+    for (size_t k = 0; k < outCount; k++) {
+        size_t a = (size_t)(k * step + 1e-6);
+        size_t b = max(a + 1, (size_t)((k + 1) * step + 1e-6));
+        double sum = 0;
+        bool valid = true;
+        for (size_t i = a; i < b && i < adu.size(); i++) {
+            if (adu[i] == INT32_MIN) valid = false;
+            else sum += adu[i] - sig.baseline;
+        }
+        float counts = ADC_MID_COUNTS + (float)(sum / (b - a)) * countsPerAdu;
+        _ecg.push_back(valid ? constrain(counts, 0.0f, 4095.0f) : NAN);
+    }
+    size_t beatsFrom = _beats.size();
+    bool annotated = readAnnotations(path, fs, from);
+    if (!annotated) findBeats(from);
+    _beatsAnnotated = _beatsAnnotated && annotated;
+
+    Serial.printf("[REPLAY] %s lead %s: %ld samples @ %.0f Hz -> %u @ %d Hz, %u beats%s\n",
+                  record, sig.description.c_str(), (long)adu.size(), fs,
+                  (unsigned)(_ecg.size() - from), ECG_SAMPLE_RATE_HZ,
+                  (unsigned)(_beats.size() - beatsFrom), annotated ? " (annotated)" : "");
+    return true;
+}
+
+bool replayLoadText(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    size_t from = _ecg.size();
+    int value;
+    while (fscanf(f, "%d", &value) == 1) {
+        _ecg.push_back((float)constrain(value, 0, 4095));
+    }
+    fclose(f);
+    findBeats(from);
+    _beatsAnnotated = false;
+    return _ecg.size() > from;
+}
+
+void replaySetSynthetic(float heartRateBpm) { _syntheticBpm = heartRateBpm; }
+void replaySetPpgNoise(float rmsCounts)     { _ppgNoise = rmsCounts; }
+
+uint32_t replayDurationMs() {
+    return (uint32_t)(_ecg.size() * 1000ULL / ECG_SAMPLE_RATE_HZ);
+}
+
+// ============================================================
+//  Sources
+// ============================================================
+static float gauss(float x, float mu, float sigma) {
+    float d = (x - mu) / sigma;
+    return expf(-0.5f * d * d);
+}
+
+static int64_t syntheticBeatUs() {
+    return (int64_t)(60.0e6f / _syntheticBpm);
+}
+
+uint16_t replayEcgAdc(uint8_t pin, int64_t us) {
+    if (pin != PIN_ECG_OUTPUT) return 0;
+    if (!_ecg.empty()) {
+        float v = _ecg[(size_t)(us / ECG_SAMPLE_PERIOD_US) % _ecg.size()];
+        return isnan(v) ? 0 : (uint16_t)lroundf(v);
+    }
+
+    // P, Q, R, S, T waves, R peak at 0.25 of the beat
+    float p = (float)(us % syntheticBeatUs()) / syntheticBeatUs();
+    float mv = 0.15f * gauss(p, 0.16f, 0.025f)
+             - 0.10f * gauss(p, 0.235f, 0.008f)
+             + 1.00f * gauss(p, 0.25f, 0.010f)
+             - 0.20f * gauss(p, 0.265f, 0.010f)
+             + 0.30f * gauss(p, 0.50f, 0.050f);
+    return (uint16_t)constrain((int)(1900.0f + 600.0f * mv), 0, 4095);
+}
+
+bool replayLeadOff(int64_t us) {
+    if (_ecg.empty()) return false;
+    return isnan(_ecg[(size_t)(us / ECG_SAMPLE_PERIOD_US) % _ecg.size()]);
+}
+
+// Last reference beat at or before us and the RR interval that follows it
+static bool beatAt(int64_t us, int64_t& beatUs, int64_t& rrUs) {
+    if (_ecg.empty()) {
+        int64_t period = syntheticBeatUs();
+        int64_t first = period / 4;
+        int64_t k = (us - first) >= 0 ? (us - first) / period : -1;
+        beatUs = first + k * period;
+        rrUs = period;
+        return true;
+    }
+    if (_beats.size() < 2) return false;
+
+    int64_t loopUs = (int64_t)_ecg.size() * ECG_SAMPLE_PERIOD_US;
+    int64_t loops = us >= 0 ? us / loopUs : -1;
+    int64_t local = us - loops * loopUs;
+    int64_t localSample = local / ECG_SAMPLE_PERIOD_US;
+
+    // Last beat <= local (the one before the first belongs to the previous loop)
+    size_t lo = 0, hi = _beats.size();
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if ((int64_t)_beats[mid] <= localSample) lo = mid + 1;
+        else hi = mid;
+    }
+    int64_t beatSample, nextSample;
+    if (lo == 0) {
+        beatSample = (int64_t)_beats.back() - (int64_t)_ecg.size();
+        nextSample = _beats[0];
+    } else {
+        beatSample = _beats[lo - 1];
+        nextSample = lo < _beats.size() ? (int64_t)_beats[lo]
+                                        : (int64_t)_beats[0] + (int64_t)_ecg.size();
+    }
+    beatUs = loops * loopUs + beatSample * ECG_SAMPLE_PERIOD_US;
+    rrUs = (nextSample - beatSample) * ECG_SAMPLE_PERIOD_US;
+    return true;
+}
+
+// Deterministic unit-variance noise for a FIFO sample time
+static float noiseAt(int64_t us, uint32_t salt) {
+    uint32_t x = (uint32_t)(us / 1000) * 2654435761u ^ salt;
+    float sum = 0;
+    for (int i = 0; i < 4; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        sum += (x & 0xFFFF) / 65535.0f - 0.5f;
+    }
+    return sum * 1.732f;    // 4 uniforms: variance 1/3 -> 1
+}
+
+void replayPpg(int64_t us, uint16_t* ir, uint16_t* red) {
+    float pulse = 0;
+    int64_t beatUs, rrUs;
+    if (beatAt(us - REPLAY_PTT_MS * 1000LL, beatUs, rrUs) && rrUs > 0) {
+        // Systolic peak and dicrotic wave, scaled to the RR interval
+        float p = (float)(us - REPLAY_PTT_MS * 1000LL - beatUs) / rrUs;
+        pulse = gauss(p, 0.15f, 0.06f) + 0.4f * gauss(p, 0.45f, 0.10f);
+    }
+
+    // Blood absorbs: intensity dips with each pulse. Red AC/DC below IR
+    // AC/DC, as at normal saturation.
+    float irCounts  = 40000.0f - 400.0f * pulse;
+    float redCounts = 30000.0f - 150.0f * pulse;
+    if (_ppgNoise > 0) {
+        irCounts  += _ppgNoise * noiseAt(us, 0x1234);
+        redCounts += _ppgNoise * noiseAt(us, 0x5678);
+    }
+    *ir  = (uint16_t)constrain(irCounts, 0.0f, 65535.0f);
+    *red = (uint16_t)constrain(redCounts, 0.0f, 65535.0f);
+}
+
+uint32_t replayReferenceBeats(int64_t us) {
+    if (_ecg.empty()) {
+        int64_t period = syntheticBeatUs();
+        return us > period / 4 ? (uint32_t)((us - period / 4 - 1) / period + 1) : 0;
+    }
+    int64_t loopUs = (int64_t)_ecg.size() * ECG_SAMPLE_PERIOD_US;
+    uint32_t count = (uint32_t)(us / loopUs) * _beats.size();
+    int64_t localSample = (us % loopUs + ECG_SAMPLE_PERIOD_US - 1) / ECG_SAMPLE_PERIOD_US;
+    for (uint32_t b : _beats) {
+        if ((int64_t)b < localSample) count++;
+    }
+    return count;
+}
+
+size_t replayReferencePeaks(const uint32_t** peaks, bool* annotated) {
+    *peaks = _beats.data();
+    *annotated = !_ecg.empty() && _beatsAnnotated;
+    return _beats.size();
+}
@@ -0,0 +1,58 @@
+#ifndef REPLAY_SOURCE_H
+#define REPLAY_SOURCE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================
+//  Signal sources for the host replay ([env:native] only)
+// ============================================================
+// ECG is held at ECG_SAMPLE_RATE_HZ in AD8232 ADC counts and looped. It is
+// either a recording or a synthetic PQRST train. Recordings can be:
+//   - WFDB records (.hea + format 16/212 .dat), as used for PTB-XL and
+//     MIT-BIH by ml/src/data_loader.py. One lead is converted from mV to
+//     counts through the AD8232 gain and resampled. Several records play
+//     back to back.
+//   - text files of ADC counts, one per line, already at ECG_SAMPLE_RATE_HZ
+//
+// Reference R peaks come from the record's MIT annotation file (.atr) when
+// it has one, otherwise they are located once at load time. The PPG source
+// pulses a pulse transit time after each one, so the MAX30100 path sees the
+// heart rhythm of the record. Every output depends only on the virtual
+// time, so runs are reproducible.
+
+#define REPLAY_AD8232_GAIN      1100.0f     // V/V, AD8232 module front end
+#define REPLAY_PTT_MS           200         // R peak -> PPG systolic upstroke
+
+// Append a WFDB record (path without extension). lead = signal description
+// ("II") or index ("1"), nullptr picks lead II if present.
+bool     replayLoadWfdb(const char* record, const char* lead, float gainVV);
+
+// Append ADC counts, one per line at ECG_SAMPLE_RATE_HZ
+bool     replayLoadText(const char* path);
+
+// Used while nothing is loaded
+void     replaySetSynthetic(float heartRateBpm);
+
+// Gaussian-like PPG noise (counts RMS), from a hash of the FIFO sample index
+void     replaySetPpgNoise(float rmsCounts);
+
+// HalNativeAdcSource / HalNativePpgSource
+uint16_t replayEcgAdc(uint8_t pin, int64_t us);
+void     replayPpg(int64_t us, uint16_t* ir, uint16_t* red);
+
+// True where the record has no valid sample (drives the lead-off pins)
+bool     replayLeadOff(int64_t us);
+
+// Loaded length, 0 when synthetic
+uint32_t replayDurationMs();
+
+// Reference beats in [0, us) (looped recording or synthetic rate)
+uint32_t replayReferenceBeats(int64_t us);
+
+// Reference R peaks of the loaded ECG (sample index at ECG_SAMPLE_RATE_HZ,
+// one pass). Returns the count; annotated is set when every record had a
+// .atr file.
+size_t   replayReferencePeaks(const uint32_t** peaks, bool* annotated);
+
+#endif // REPLAY_SOURCE_H
@@ -0,0 +1,28 @@
+#include "wifi_manager.h"
+#include "config.h"
+#include "hal.h"
+
+// ============================================================
+//  Host WiFi manager ([env:native] only)
+// ============================================================
+// Always associated and synced; the wall clock is a fixed epoch plus the
+// HAL virtual clock. Link failures are simulated at the transport instead
+// (halNativeSetNetUp()).
+
+#define NATIVE_EPOCH_SEC    1700000000UL
+
+static char _deviceId[20] = "ESP32_NATIVE";
+
+void        wifiInit()              { Serial.printf("[WIFI] Device ID: %s\n", _deviceId); }
+WifiState   wifiUpdate()            { return WIFI_STATE_READY; }
+WifiState   wifiGetState()          { return WIFI_STATE_READY; }
+bool        wifiIsReady()           { return true; }
+const char* wifiGetDeviceId()       { return _deviceId; }
+time_t      wifiGetTimestamp()      { return (time_t)(NATIVE_EPOCH_SEC + halMillis() / 1000); }
+int         wifiGetRSSI()           { return -50; }
+void        wifiReconnect()         {}
+
+void        wifiSetCredentials(const char*, const char*) {}
+bool        wifiHasCredentials()    { return true; }
+uint8_t     wifiGetBootFailCount()  { return 0; }
+void        wifiResetBootFailCount() {}
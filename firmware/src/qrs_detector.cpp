@@ -0,0 +1,156 @@
+#include "qrs_detector.h"
+#include <string.h>
+
+#define QRS_SAMPLES(ms)         ((uint32_t)(ms) * ECG_SAMPLE_RATE_HZ / 1000)
+#define QRS_RING_MASK           (QRS_RING_SIZE - 1)
+#define QRS_SLOPE_MAX           8191    // Derivative clamp: squares stay below 2^26
+
+static_assert((QRS_RING_SIZE & QRS_RING_MASK) == 0, "QRS_RING_SIZE must be a power of 2");
+static_assert(QRS_MWI_SAMPLES >= 4 && QRS_MWI_SAMPLES < QRS_RING_SIZE,
+              "QRS_RING_SIZE must cover the integration window");
+static_assert(QRS_MWI_MS + QRS_REFRACTORY_MS < QRS_LATENCY_MS,
+              "QRS_LATENCY_MS must cover the integration window and the peak grouping");
+
+QrsDetector::QrsDetector()
+    : _band(biquadBandPass(QRS_BAND_HZ, QRS_BAND_Q, ECG_SAMPLE_RATE_HZ)) {
+    reset();
+}
+
+void QrsDetector::reset() {
+    _band.reset();
+    memset(_bp, 0, sizeof(_bp));
+    memset(_x, 0, sizeof(_x));
+    memset(_sq, 0, sizeof(_sq));
+    _mwiSum = 0;
+    _mwi1 = _mwi2 = 0;
+    _n = 0;
+    _learnMax = 0;
+    _learnSum = 0;
+    _hasPending = false;
+    _hasSearchBack = false;
+    _hasLastQrs = false;
+    _spki = _npki = 0;
+    _rrCount = 0;
+    _rrSum = 0;
+}
+
+uint32_t QrsDetector::thresholdI1() const {
+    return _spki > _npki ? _npki + (_spki - _npki) / 4 : _npki;
+}
+
+void QrsDetector::acceptQrs(const Peak& p) {
+    if (_hasLastQrs) {
+        uint32_t rr = p.r - _lastQrs.r;
+        uint8_t slot = _rrCount % QRS_RR_HISTORY;
+        if (_rrCount >= QRS_RR_HISTORY) _rrSum -= _rr[slot];
+        _rr[slot] = rr;
+        _rrSum += rr;
+        _rrCount++;
+        // Keep the ring index meaningful without overflowing the count
+        if (_rrCount == 2 * QRS_RR_HISTORY) _rrCount = QRS_RR_HISTORY;
+    }
+    _lastQrs = p;
+    _hasLastQrs = true;
+    _hasSearchBack = false;
+}
+
+// Regular decision for a peak group, QRS_REFRACTORY_MS after its maximum
+bool QrsDetector::classify(const Peak& p, uint32_t& r) {
+    uint32_t i1 = thresholdI1();
+    if (p.energy > i1) {
+        // Soon after a QRS, a peak with less than half its slope is a T wave
+        bool tWave = _hasLastQrs && p.at - _lastQrs.at < QRS_SAMPLES(QRS_TWAVE_MS)
+                     && p.slope < _lastQrs.slope / 4;
+        if (!tWave) {
+            _spki = p.energy / 8 + _spki - _spki / 8;
+            acceptQrs(p);
+            r = p.r;
+            return true;
+        }
+    } else if (p.energy > i1 / 2 && (!_hasSearchBack || p.energy > _searchBack.energy)) {
+        _searchBack = p;
+        _hasSearchBack = true;
+    }
+    _npki = p.energy / 8 + _npki - _npki / 8;
+    return false;
+}
+
+// Missed beat: no QRS for QRS_SEARCHBACK_PCT of the average RR, take the
+// largest peak above the second threshold since the last one
+bool QrsDetector::searchBack(uint32_t& r) {
+    if (!_hasLastQrs || !_hasSearchBack || _rrCount == 0) return false;
+    uint8_t count = _rrCount < QRS_RR_HISTORY ? _rrCount : QRS_RR_HISTORY;
+    uint32_t limit = _rrSum / count * QRS_SEARCHBACK_PCT / 100;
+    if (_n - 1 - _lastQrs.at < limit) return false;
+
+    _spki = _searchBack.energy / 4 + _spki - _spki / 4;
+    Peak p = _searchBack;
+    acceptQrs(p);
+    r = p.r;
+    return true;
+}
+
+bool QrsDetector::step(int32_t x, uint32_t& peakAgo) {
+    uint32_t n = _n++;
+    _x[n & QRS_RING_MASK] = x;
+
+    // Band-pass, then the 5-point derivative 2x[n] + x[n-1] - x[n-3] - 2x[n-4]
+    int32_t bp = ecgFixedToCounts(_band.step(x * (1 << ECG_Q_SHIFT)));
+    int32_t d = 2 * bp + _bp[0] - _bp[2] - 2 * _bp[3];
+    _bp[3] = _bp[2]; _bp[2] = _bp[1]; _bp[1] = _bp[0]; _bp[0] = bp;
+    if (d > QRS_SLOPE_MAX) d = QRS_SLOPE_MAX;
+    if (d < -QRS_SLOPE_MAX) d = -QRS_SLOPE_MAX;
+
+    // Square and integrate over the last QRS_MWI_SAMPLES
+    uint32_t sq = (uint32_t)(d * d);
+    _mwiSum += sq;
+    _mwiSum -= _sq[(n - QRS_MWI_SAMPLES) & QRS_RING_MASK];
+    _sq[n & QRS_RING_MASK] = sq;
+    uint32_t mwi = (uint32_t)(_mwiSum / QRS_MWI_SAMPLES);
+
+    bool found = false;
+    uint32_t r = 0;
+
+    if (n < QRS_SAMPLES(QRS_LEARN_MS)) {
+        // Training: signal level from the largest, noise from the mean
+        if (mwi > _learnMax) _learnMax = mwi;
+        _learnSum += mwi;
+        if (n + 1 == QRS_SAMPLES(QRS_LEARN_MS)) {
+            _spki = _learnMax / 3;
+            _npki = (uint32_t)(_learnSum / QRS_SAMPLES(QRS_LEARN_MS) / 2);
+        }
+    } else {
+        if (_hasPending && n - _pending.at >= QRS_SAMPLES(QRS_REFRACTORY_MS)) {
+            _hasPending = false;
+            found = classify(_pending, r);
+        }
+        if (!found) found = searchBack(r);
+
+        // Integrator maximum at n - 1: keep the largest within the refractory period
+        if (_mwi1 > _mwi2 && _mwi1 >= mwi && (!_hasPending || _mwi1 > _pending.energy)) {
+            Peak p;
+            p.energy = _mwi1;
+            p.at = n - 1;
+            p.slope = 0;
+            p.r = p.at;
+            int32_t best = -1;
+            for (uint32_t k = 0; k < QRS_MWI_SAMPLES; k++) {
+                uint32_t i = p.at - k;
+                if (_sq[i & QRS_RING_MASK] > p.slope) p.slope = _sq[i & QRS_RING_MASK];
+                int32_t a = _x[i & QRS_RING_MASK] < 0 ? -_x[i & QRS_RING_MASK] : _x[i & QRS_RING_MASK];
+                if (a > best) {
+                    best = a;
+                    p.r = i;
+                }
+            }
+            _pending = p;
+            _hasPending = true;
+        }
+    }
+
+    _mwi2 = _mwi1;
+    _mwi1 = mwi;
+
+    if (found) peakAgo = n - r;
+    return found;
+}
@@ -0,0 +1,86 @@
+#ifndef QRS_DETECTOR_H
+#define QRS_DETECTOR_H
+
+#include <stdint.h>
+#include "config.h"
+#include "ecg_filter.h"
+
+// ============================================================
+//  Streaming Pan-Tompkins QRS detector
+// ============================================================
+// Pan & Tompkins, "A Real-Time QRS Detection Algorithm" (IEEE TBME, 1985),
+// run on the filtered ECG at ECG_SAMPLE_RATE_HZ:
+//   5-15Hz band-pass -> 5-point derivative -> square -> QRS_MWI_MS moving
+//   window integration -> integrator peaks (at least QRS_REFRACTORY_MS
+//   apart) classified against adaptive signal/noise levels, with T-wave
+//   rejection and search-back for missed beats.
+// Integer arithmetic only, about 20 operations per sample plus a short scan
+// per integrator peak.
+//
+// The R peak is the largest deflection of the input in the integration
+// window ending at the integrator peak, so positions are sample-accurate.
+// A beat is decided at most QRS_LATENCY_MS after its R peak, except the ones
+// found by search-back.
+#define QRS_BAND_HZ             10      // Band-pass center
+#define QRS_BAND_Q              1.0     // 10Hz wide: 5-15Hz
+#define QRS_MWI_MS              150     // Moving window integration width
+#define QRS_REFRACTORY_MS       200     // Minimum QRS spacing
+#define QRS_TWAVE_MS            360     // Closer than this needs half the last QRS slope
+#define QRS_LEARN_MS            2000    // Threshold training after reset()
+#define QRS_SEARCHBACK_PCT      166     // Search back after this % of the average RR
+#define QRS_LATENCY_MS          400     // Decision delay bound for regular beats
+#define QRS_RR_HISTORY          8       // RR intervals in the average
+#define QRS_RING_SIZE           128     // Input/energy history, power of 2
+
+#define QRS_MWI_SAMPLES         (QRS_MWI_MS * ECG_SAMPLE_RATE_HZ / 1000)
+
+class QrsDetector {
+public:
+    QrsDetector();
+
+    // Forget all state and thresholds (lead-off). The next QRS_LEARN_MS of
+    // samples train the thresholds and yield no beats.
+    void reset();
+
+    // One filtered sample, in counts around 0. Returns true when a QRS was
+    // decided; its R peak was peakAgo samples before this one.
+    bool step(int32_t x, uint32_t& peakAgo);
+
+private:
+    struct Peak {
+        uint32_t energy;    // Integrator peak value
+        uint32_t slope;     // Largest squared derivative before it
+        uint32_t at;        // Sample index of the integrator peak
+        uint32_t r;         // Sample index of the R peak
+    };
+
+    bool classify(const Peak& p, uint32_t& r);
+    bool searchBack(uint32_t& r);
+    void acceptQrs(const Peak& p);
+    uint32_t thresholdI1() const;
+
+    EcgBiquadFixed _band;
+    int32_t  _bp[4];                        // Previous band-passed samples
+    int32_t  _x[QRS_RING_SIZE];             // Input history (R peak search)
+    uint32_t _sq[QRS_RING_SIZE];            // Squared derivative history
+    uint64_t _mwiSum;
+    uint32_t _mwi1, _mwi2;                  // Previous integrator outputs
+    uint32_t _n;                            // Samples since reset()
+
+    uint32_t _learnMax;
+    uint64_t _learnSum;
+
+    Peak     _pending;                      // Largest peak of the current group
+    bool     _hasPending;
+    Peak     _searchBack;                   // Largest noise peak since the last QRS
+    bool     _hasSearchBack;
+
+    uint32_t _spki, _npki;                  // Signal and noise peak levels
+    Peak     _lastQrs;
+    bool     _hasLastQrs;
+    uint32_t _rr[QRS_RR_HISTORY];
+    uint8_t  _rrCount;
+    uint32_t _rrSum;
+};
+
+#endif // QRS_DETECTOR_H
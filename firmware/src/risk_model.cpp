@@ -0,0 +1,232 @@
+#include "risk_model.h"
+#include "sensor_manager.h"
+#include <math.h>
+
+#if defined(__has_include)
+#if __has_include("risk_model_data.h")
+#include "risk_model_data.h"
+#define RISK_MODEL_AVAILABLE    1
+#endif
+#endif
+
+#ifndef RISK_MODEL_AVAILABLE
+#define RISK_MODEL_AVAILABLE    0
+#endif
+
+#if RISK_MODEL_AVAILABLE
+static_assert(RISK_MODEL_FEATURE_COUNT == RF_COUNT,
+              "risk_model_data.h was exported for a different feature set");
+#endif
+
+// feature_extractor.py defaults
+#define RISK_DEFAULT_QRS_MS         100.0f
+#define RISK_DEFAULT_QT_MS          400.0f
+#define RISK_DEFAULT_QTC_MS         440.0f
+#define RISK_DEFAULT_P_WAVE_RATIO   0.1f
+#define RISK_DEFAULT_ENTROPY        0.5f
+#define RISK_DEFAULT_SNR_DB         10.0f
+#define RISK_DEFAULT_SPO2           97.0f
+
+#define RISK_ST_OFFSET_SAMPLES      (ECG_SAMPLE_RATE_HZ * 40 / 1000)    // J point, R + 40ms
+#define RISK_T_FROM_SAMPLES         (ECG_SAMPLE_RATE_HZ * 100 / 1000)   // T wave search after R
+#define RISK_T_TO_SAMPLES           (ECG_SAMPLE_RATE_HZ * 400 / 1000)
+
+bool riskModelAvailable() {
+    return RISK_MODEL_AVAILABLE;
+}
+
+float riskModelScore(const float features[RF_COUNT]) {
+#if RISK_MODEL_AVAILABLE
+    float margin = RISK_MODEL_BASE_MARGIN;
+    for (uint32_t t = 0; t < RISK_MODEL_TREE_COUNT; t++) {
+        const RiskNode* tree = RISK_MODEL_NODES + RISK_MODEL_ROOTS[t];
+        const RiskNode* node = tree;
+        while (node->feature != RISK_NODE_LEAF) {
+            float x = features[node->feature];
+            bool left = isnan(x) ? (node->flags & RISK_NODE_DEFAULT_LEFT) : x < node->value;
+            node = tree + node->child + (left ? 0 : 1);
+        }
+        margin += node->value;
+    }
+    return 1.0f / (1.0f + expf(-margin));
+#else
+    (void)features;
+    return 0.0f;
+#endif
+}
+
+// _fallback_features(): fewer than 3 R peaks
+static void fallbackFeatures(const SensorWindow& w, float* f) {
+    f[RF_MEAN_RR] = 800.0f;
+    f[RF_SDNN] = 50.0f;
+    f[RF_RMSSD] = 30.0f;
+    f[RF_PNN50] = 10.0f;
+    f[RF_MEAN_HR_ECG] = 75.0f;
+    f[RF_HR_STD] = 5.0f;
+    f[RF_RR_RANGE] = 200.0f;
+    f[RF_QRS_DURATION] = RISK_DEFAULT_QRS_MS;
+    f[RF_R_AMPLITUDE] = 1.0f;
+    f[RF_R_AMPLITUDE_STD] = 0.1f;
+    f[RF_QT_INTERVAL] = RISK_DEFAULT_QT_MS;
+    f[RF_QTC] = RISK_DEFAULT_QTC_MS;
+    f[RF_ST_LEVEL] = 0.0f;
+    f[RF_T_AMPLITUDE] = 0.3f;
+    f[RF_P_WAVE_RATIO] = RISK_DEFAULT_P_WAVE_RATIO;
+    f[RF_ENTROPY] = RISK_DEFAULT_ENTROPY;
+    f[RF_ZERO_CROSSING_RATE] = 0.1f;
+    f[RF_KURTOSIS] = 0.0f;
+    f[RF_SKEWNESS] = 0.0f;
+    f[RF_SNR] = RISK_DEFAULT_SNR_DB;
+    f[RF_HEART_RATE_SENSOR] = w.heartRateBpm > 0.0f ? w.heartRateBpm : 75.0f;
+    f[RF_SPO2] = w.spo2Percent > 0 ? (float)w.spo2Percent : RISK_DEFAULT_SPO2;
+    f[RF_HR_SENSOR_ECG_DIFF] = 0.0f;
+    f[RF_ECG_QUALITY] = 0.5f;
+
+    // RMS of the uploaded samples as they are (not re-centered)
+    float sum2 = 0.0f;
+    for (uint16_t i = 0; i < w.ecgSampleCount; i++) {
+        float x = (float)w.ecgSamples[i];
+        sum2 += x * x;
+    }
+    f[RF_RMS] = w.ecgSampleCount > 0 ? sqrtf(sum2 / w.ecgSampleCount) : 0.5f;
+}
+
+// RR statistics from the R peaks, when the HRV accumulator has fewer than
+// two chained intervals in the window (gap or restart)
+static void peakHrv(const SensorWindow& w, float* f) {
+    uint8_t n = w.rPeakCount - 1;
+    float rr[MAX_BEATS_PER_WINDOW];
+    float sum = 0.0f, hrSum = 0.0f, lo = 1e9f, hi = 0.0f;
+    for (uint8_t i = 0; i < n; i++) {
+        rr[i] = (float)(w.rPeakSamples[i + 1] - w.rPeakSamples[i]) * 1000.0f / ECG_SAMPLE_RATE_HZ;
+        sum += rr[i];
+        hrSum += 60000.0f / rr[i];
+        if (rr[i] < lo) lo = rr[i];
+        if (rr[i] > hi) hi = rr[i];
+    }
+    float mean = sum / n, hrMean = hrSum / n;
+    float var = 0.0f, hrVar = 0.0f, diff2 = 0.0f;
+    uint8_t nn50 = 0;
+    for (uint8_t i = 0; i < n; i++) {
+        float hr = 60000.0f / rr[i];
+        var += (rr[i] - mean) * (rr[i] - mean);
+        hrVar += (hr - hrMean) * (hr - hrMean);
+        if (i > 0) {
+            float d = rr[i] - rr[i - 1];
+            diff2 += d * d;
+            if (fabsf(d) > HRV_NN50_MS) nn50++;
+        }
+    }
+    f[RF_MEAN_RR] = mean;
+    f[RF_SDNN] = n > 1 ? sqrtf(var / (n - 1)) : 0.0f;
+    f[RF_RMSSD] = n > 1 ? sqrtf(diff2 / (n - 1)) : 0.0f;
+    f[RF_PNN50] = n > 1 ? 100.0f * nn50 / (n - 1) : 0.0f;
+    f[RF_MEAN_HR_ECG] = hrMean;
+    f[RF_HR_STD] = sqrtf(hrVar / n);
+    f[RF_RR_RANGE] = hi - lo;
+}
+
+void riskModelFeatures(const SensorWindow& w, float features[RF_COUNT]) {
+    float* f = features;
+    uint16_t count = w.ecgSampleCount;
+    if (w.rPeakCount < 3 || count == 0) {
+        fallbackFeatures(w, f);
+        return;
+    }
+
+    // --- HRV time domain: the device's accumulator, as the backend uses it ---
+    if (w.hrv.rrCount >= 2) {
+        f[RF_MEAN_RR] = w.hrv.meanRrMs;
+        f[RF_SDNN] = w.hrv.sdnnMs;
+        f[RF_RMSSD] = w.hrv.rmssdMs;
+        f[RF_PNN50] = w.hrv.pnn50Percent;
+        f[RF_MEAN_HR_ECG] = w.hrv.meanHrBpm;
+        f[RF_HR_STD] = w.hrv.hrStdBpm;
+        f[RF_RR_RANGE] = w.hrv.rrRangeMs;
+    } else {
+        peakHrv(w, f);
+    }
+
+    // --- Morphology at the R peaks (filtered samples, re-centered at 0) ---
+    float rSum = 0.0f, rSum2 = 0.0f, stSum = 0.0f, tSum = 0.0f;
+    uint8_t stCount = 0, tCount = 0;
+    for (uint8_t b = 0; b < w.rPeakCount; b++) {
+        uint32_t r = w.rPeakSamples[b];
+        float a = (float)w.ecgSamples[r] - 2048.0f;
+        rSum += a;
+        rSum2 += a * a;
+        if (r + RISK_ST_OFFSET_SAMPLES < count) {
+            stSum += (float)w.ecgSamples[r + RISK_ST_OFFSET_SAMPLES] - 2048.0f;
+            stCount++;
+        }
+        // T peak: largest sample 100-400ms after R, before the next beat
+        uint32_t to = r + RISK_T_TO_SAMPLES;
+        if (b + 1 < w.rPeakCount && to > w.rPeakSamples[b + 1]) to = w.rPeakSamples[b + 1];
+        if (to > count) to = count;
+        if (r + RISK_T_FROM_SAMPLES < to) {
+            uint16_t t = 0;
+            for (uint32_t i = r + RISK_T_FROM_SAMPLES; i < to; i++) {
+                if (w.ecgSamples[i] > t) t = w.ecgSamples[i];
+            }
+            tSum += (float)t - 2048.0f;
+            tCount++;
+        }
+    }
+    float rMean = rSum / w.rPeakCount;
+    f[RF_R_AMPLITUDE] = rMean;
+    f[RF_R_AMPLITUDE_STD] = sqrtf(fmaxf(rSum2 / w.rPeakCount - rMean * rMean, 0.0f));
+    f[RF_ST_LEVEL] = stCount ? stSum / stCount : 0.0f;
+    f[RF_T_AMPLITUDE] = tCount ? tSum / tCount : 0.0f;
+    f[RF_QRS_DURATION] = RISK_DEFAULT_QRS_MS;
+    f[RF_QT_INTERVAL] = RISK_DEFAULT_QT_MS;
+    f[RF_QTC] = RISK_DEFAULT_QTC_MS;
+    f[RF_P_WAVE_RATIO] = RISK_DEFAULT_P_WAVE_RATIO;
+
+    // --- Signal statistics: integer mean, then float central moments ---
+    int32_t sum = 0;
+    for (uint16_t i = 0; i < count; i++) sum += (int32_t)w.ecgSamples[i] - 2048;
+    float mean = (float)sum / count;
+    float m2 = 0.0f, m3 = 0.0f, m4 = 0.0f, sq = 0.0f;
+    uint16_t crossings = 0;
+    int8_t lastSign = 0;
+    for (uint16_t i = 0; i < count; i++) {
+        float x = (float)w.ecgSamples[i] - 2048.0f;
+        float d = x - mean;
+        float d2 = d * d;
+        sq += x * x;
+        m2 += d2;
+        m3 += d2 * d;
+        m4 += d2 * d2;
+        int8_t sign = d > 0.0f ? 1 : d < 0.0f ? -1 : 0;
+        if (i > 0 && sign != lastSign) crossings++;
+        lastSign = sign;
+    }
+    m2 /= count;
+    m3 /= count;
+    m4 /= count;
+    f[RF_RMS] = sqrtf(sq / count);
+    f[RF_ZERO_CROSSING_RATE] = (float)crossings / count;
+    // scipy.stats kurtosis (Fisher) and skew, biased
+    f[RF_KURTOSIS] = m2 > 0.0f ? m4 / (m2 * m2) - 3.0f : 0.0f;
+    f[RF_SKEWNESS] = m2 > 0.0f ? m3 / (m2 * sqrtf(m2)) : 0.0f;
+    f[RF_ENTROPY] = RISK_DEFAULT_ENTROPY;
+    f[RF_SNR] = RISK_DEFAULT_SNR_DB;
+
+    // --- Device sensor features ---
+    f[RF_HEART_RATE_SENSOR] = w.heartRateBpm > 0.0f ? w.heartRateBpm : f[RF_MEAN_HR_ECG];
+    f[RF_SPO2] = w.spo2Percent > 0 ? (float)w.spo2Percent : RISK_DEFAULT_SPO2;
+    f[RF_HR_SENSOR_ECG_DIFF] = fabsf(f[RF_HEART_RATE_SENSOR] - f[RF_MEAN_HR_ECG]);
+
+    // Peak regularity: 1 - coefficient of variation (population std)
+    uint8_t n = w.hrv.rrCount >= 2 ? w.hrv.rrCount : w.rPeakCount - 1;
+    float popStd = f[RF_SDNN] * sqrtf((float)(n - 1) / n);
+    f[RF_ECG_QUALITY] = n > 1 && f[RF_MEAN_RR] > 0.0f ? fmaxf(0.0f, 1.0f - popStd / f[RF_MEAN_RR]) : 0.5f;
+}
+
+const char* riskModelLabel(float score) {
+    if (score < 0.2f) return "normal";
+    if (score < 0.4f) return "low";
+    if (score < 0.6f) return "moderate";
+    if (score < 0.8f) return "elevated";
+    return "high";
+}
@@ -0,0 +1,59 @@
+#ifndef RISK_MODEL_H
+#define RISK_MODEL_H
+
+#include <stdint.h>
+
+struct SensorWindow;
+
+// ============================================================
+//  On-device XGBoost risk model
+// ============================================================
+// The backend's XGBoost classifier (backend/ml_models/xgboost_cardiac.joblib)
+// compiled to a flat node array by ml/src/export_xgboost_c.py into
+// risk_model_data.h, so a risk score is available without the round trip to
+// ml_service.predict() (offline, or before the server answers).
+//
+// Each tree is a contiguous, breadth-first run of 8-byte nodes in flash; the
+// two children of a split are adjacent, so a step is one compare and one
+// index computation. About 100 trees of depth 6 take tens of microseconds.
+//
+// Without a generated risk_model_data.h the firmware builds with the model
+// disabled (riskModelAvailable() is false).
+
+#define RISK_NODE_LEAF          0xFF    // feature of a leaf node
+#define RISK_NODE_DEFAULT_LEFT  0x01    // flags: missing value (NaN) goes left
+
+struct RiskNode {
+    float    value;     // Split threshold (go left if x < value), or leaf value
+    uint8_t  feature;   // Feature index, or RISK_NODE_LEAF
+    uint8_t  flags;
+    uint16_t child;     // Left child, from the tree root; right is child + 1
+};
+
+// Model inputs, in feature_extractor.FEATURE_NAMES order
+enum RiskFeature {
+    RF_MEAN_RR, RF_SDNN, RF_RMSSD, RF_PNN50, RF_MEAN_HR_ECG, RF_HR_STD, RF_RR_RANGE,
+    RF_QRS_DURATION, RF_R_AMPLITUDE, RF_R_AMPLITUDE_STD, RF_QT_INTERVAL, RF_QTC,
+    RF_ST_LEVEL, RF_T_AMPLITUDE, RF_P_WAVE_RATIO,
+    RF_RMS, RF_ENTROPY, RF_ZERO_CROSSING_RATE, RF_KURTOSIS, RF_SKEWNESS, RF_SNR,
+    RF_HEART_RATE_SENSOR, RF_SPO2, RF_HR_SENSOR_ECG_DIFF, RF_ECG_QUALITY,
+    RF_COUNT
+};
+
+// True when the firmware was built with a generated model
+bool riskModelAvailable();
+
+// Probability of the positive class for one feature vector (NaN = missing),
+// as XGBClassifier.predict_proba()[:, 1]. 0 without a model.
+float riskModelScore(const float features[RF_COUNT]);
+
+// Model inputs for a window, the way feature_extractor.extract_ecg_features()
+// computes them from the uploaded window and the device's R peaks. Features
+// that need wave delineation or a second filter pass (QRS/QT duration, P wave,
+// sample entropy, SNR) take the extractor's defaults.
+void riskModelFeatures(const SensorWindow& window, float features[RF_COUNT]);
+
+// Label for a score, as ml_service.get_risk_label()
+const char* riskModelLabel(float score);
+
+#endif // RISK_MODEL_H
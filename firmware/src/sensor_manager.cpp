@@ -1,58 +1,146 @@
 #include "sensor_manager.h"
-#include <Wire.h>
+#include "hal.h"
 #include "MAX30100_PulseOximeter.h"
 #include "ecg_filter.h"
+#include "qrs_detector.h"
+#include "hrv.h"
+#include "ecg_acquisition.h"
+#include "window_pool.h"
+#include "spsc_ring.h"
+
+#include <atomic>
 
 // --- ECG digital filters ---
-static EcgNotch50   _ecgNotch;
+#if ECG_FILTER_IMPL == ECG_FILTER_FIXED
+typedef int32_t EcgFilterSample;
+static EcgNotchFixed   _ecgNotch;
+static EcgLowPassFixed   _ecgLpf;
+static EcgDCRemoverFixed _ecgDcRemover;
+#else
+typedef float EcgFilterSample;
+static EcgNotch   _ecgNotch;
 static EcgLowPass   _ecgLpf;
 static EcgDCRemover _ecgDcRemover;
+#endif
+
+// --- ECG QRS detection (R peaks and HRV for the windows) ---
+static QrsDetector _qrs;
+static HrvAccumulator _hrv;
+
+#if SENSOR_TASK && ECG_ACQ_MODE == ECG_ACQ_POLL
+#error "SENSOR_TASK needs a sample clock that wakes it: ECG_ACQ_TIMER or ECG_ACQ_DMA"
+#endif
+
+// Windows are handed off once the detector has decided on their last beats
+#define WINDOW_QRS_HOLD_SAMPLES (QRS_LATENCY_MS * ECG_SAMPLE_RATE_HZ / 1000)
+
+// INT sources for each FIFO servicing mode
+#if MAX30100_IRQ_MODE == MAX30100_IRQ_SAMPLE
+#define PPG_IRQ_SOURCES         MAX30100_IE_ENB_SPO2_RDY
+#elif MAX30100_IRQ_MODE == MAX30100_IRQ_FIFO_FULL
+#define PPG_IRQ_SOURCES         MAX30100_IE_ENB_A_FULL
+#else
+#define PPG_IRQ_SOURCES         0
+#endif
+
+// --- Lock-free hand-off to loop() (sensor side pushes, loop() pops) ---
+// Holds every pool buffer, so a filled window always fits
+#define WINDOW_QUEUE_SIZE       4
+static_assert(WINDOW_QUEUE_SIZE >= WINDOW_POOL_SIZE, "Window queue must hold the whole pool");
+static SpscRing<SensorWindow*, WINDOW_QUEUE_SIZE> _windowQueue;
+static SpscRing<SensorLatencyReport, 4> _latencyQueue;
 
 // --- Internal state ---
+// The ECG side (acquisition ring, filters, QRS, windows) runs in the sensor
+// task unless SENSOR_TASK is 0. The PPG side (pox, beat callback, HR/SpO2)
+// runs in the PPG task unless MAX30100_IRQ_MODE is MAX30100_IRQ_POLL, then
+// with the ECG side. Values read across are atomic.
 static PulseOximeter pox;
-static bool _sensorOk = true;
-
-// ECG buffer (linear fill per 10s window)
-static uint16_t _ecgBuffer[ECG_SAMPLES_PER_WINDOW];
-static uint16_t _ecgIndex = 0;
-
-// Beat timestamps within current window
-static uint16_t _beatTimestamps[MAX_BEATS_PER_WINDOW];
-static uint8_t  _beatIndex = 0;
+static std::atomic<bool> _sensorOk(true);
+static std::atomic<bool> _i2cBurst(MAX30100_I2C_BURST);    // Cleared for good on fallback
+
+static_assert((ECG_RING_SIZE & (ECG_RING_SIZE - 1)) == 0, "ECG_RING_SIZE must be a power of 2");
+static_assert(ECG_RING_SIZE >= ECG_SAMPLES_PER_WINDOW + WINDOW_QRS_HOLD_SAMPLES + ECG_SAMPLE_RATE_HZ,
+              "ECG ring must hold a full window, the QRS decision delay and 1s of hand-off slack");
+static_assert(ECG_WINDOW_OVERLAP_SAMPLES < ECG_SAMPLES_PER_WINDOW,
+              "Window overlap must be shorter than the window");
+static_assert((BEAT_RING_SIZE & (BEAT_RING_SIZE - 1)) == 0, "BEAT_RING_SIZE must be a power of 2");
+
+// ECG ring (continuous, never paused). Samples are addressed by a running
+// sequence number; ring slot = seq & (ECG_RING_SIZE - 1).
+static uint16_t _ecgRing[ECG_RING_SIZE];
+static std::atomic<uint32_t> _ecgSeq(0);    // Samples written since boot
+
+// Readers on another task (BLE streaming) stay this far from the writer:
+// one filter block can land while a copy is in progress
+#define ECG_COPY_GUARD_SAMPLES  ECG_FILTER_BLOCK
+static uint32_t _nextWindowStartSeq = 0;    // Start of the window being collected
+static EcgWindowView _readyWindow = {0, 0};
+static uint32_t _readyWindowStartMs = 0;
+
+// Beat positions as ECG sequence numbers (mapped into windows on hand-off)
+static uint32_t _beatSeqRing[BEAT_RING_SIZE];
+static std::atomic<uint32_t> _beatSeqCount(0);
+
+// R peaks from the QRS detector, same scheme
+static uint32_t _rPeakSeqRing[BEAT_RING_SIZE];
+static std::atomic<uint32_t> _rPeakSeqCount(0);
 
 // Timing
-static uint32_t _windowStartMs = 0;
-static uint32_t _tsLastEcgSample = 0;
 static uint32_t _tsLastReport = 0;
 static uint32_t _tsLastBeatChange = 0;
+static uint32_t _tsLastBusStats = 0;
+static MAX30100BusStats _lastBusStats = {0, 0, 0, 0};
 
 // Beat detection
-static uint32_t _beatCountTotal = 0;
+static std::atomic<uint32_t> _beatCountTotal(0);
 static uint32_t _lastBeatCountForStall = 0;
 
 // Latest readings
-static float   _lastHR = 0.0f;
-static uint8_t _lastSpO2 = 0;
-static int     _lastEcgValue = 0;
-static bool    _ecgLeadOff = false;
-static bool    _windowReady = false;
+static std::atomic<float>   _lastHR(0.0f);
+static std::atomic<uint8_t> _lastSpO2(0);
+static std::atomic<int>  _lastEcgValue(0);
+static std::atomic<bool> _ecgLeadOff(false);
+static bool    _windowReady = false;        // Completed, not yet handed off
 
 // Text printing counter
 static uint8_t _ecgTextCounter = 0;
-static bool    _shouldPrintText = false;
+static std::atomic<bool> _shouldPrintText(false);
+
+// Sample latency (scheduled time -> filtered and in the ring). Log-linear
+// buckets: exact below 8us, then 8 per power of two.
+#define LATENCY_BUCKETS         240
+static uint32_t _latencyBuckets[LATENCY_BUCKETS];
+static uint32_t _latencyCount = 0;
+static uint32_t _latencyMaxUs = 0;
+static uint32_t _latencyOverBudget = 0;
+static uint32_t _tsLastLatencyReport = 0;
 
 // --- Beat callback (called by MAX30100 library) ---
 static void onBeatDetected() {
     _beatCountTotal++;
-    digitalWrite(PIN_BEAT_LED, HIGH);
+    halDigitalWrite(PIN_BEAT_LED, true);
+
+    // Record beat against the ECG sample clock; windows pick their beats later
+    uint32_t seq = _ecgSeq;
+#if PPG_SAMPLE_CLOCK
+    // Back-date by the PPG samples drained with it but taken after it
+    seq -= (uint32_t)pox.getQueuedSamples() * ECG_SAMPLE_RATE_HZ / SAMPLING_FREQUENCY;
+#endif
+    _beatSeqRing[_beatSeqCount & (BEAT_RING_SIZE - 1)] = seq;
+    _beatSeqCount++;
+}
 
-    // Record beat timestamp relative to current window start
-    if (_beatIndex < MAX_BEATS_PER_WINDOW && _windowStartMs > 0) {
-        uint32_t relativeMs = millis() - _windowStartMs;
-        if (relativeMs <= ECG_WINDOW_MS) {
-            _beatTimestamps[_beatIndex++] = (uint16_t)relativeMs;
-        }
-    }
+// --- I2C clock for the current FIFO readout mode ---
+static uint32_t i2cClockHz() {
+    return _i2cBurst ? I2C_BUS_SPEED : I2C_FALLBACK_BUS_SPEED;
+}
+
+static void i2cFallback() {
+    _i2cBurst = false;
+    pox.setBurstReadEnabled(false);
+    halI2cBegin(PIN_I2C_SDA, PIN_I2C_SCL, i2cClockHz());
+    Serial.println("[I2C] Burst reads failing. Back to per-sample reads at 100kHz.");
 }
 
 // --- MAX30100 initialization with retries ---
@@ -60,116 +148,45 @@ static bool initializeMax30100() {
     for (int attempt = 1; attempt <= MAX_INIT_RETRIES; attempt++) {
         Serial.printf("[SENSOR] MAX30100 init attempt %d/%d...\n", attempt, MAX_INIT_RETRIES);
 
-        Wire.end();
-        delay(50);
-        Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
-        Wire.setClock(100000);
+        halI2cEnd();
+        halDelay(50);
+        halI2cBegin(PIN_I2C_SDA, PIN_I2C_SCL, i2cClockHz());
 
         if (pox.begin()) {
-            Wire.setClock(100000);
-            Serial.println("[SENSOR] MAX30100 initialized (I2C 100kHz).");
+            Serial.printf("[SENSOR] MAX30100 initialized (I2C %lukHz, %s reads).\n",
+                          (unsigned long)(i2cClockHz() / 1000), _i2cBurst ? "burst" : "per-sample");
+            pox.setBurstReadEnabled(_i2cBurst);
+            pox.setSampleClockEnabled(PPG_SAMPLE_CLOCK);
+            pox.setInterruptsEnabled(PPG_IRQ_SOURCES);
+            pox.getInterruptStatus();       // Clear PWR_RDY so INT goes high
             pox.setIRLedCurrent(IR_LED_CURRENT);
             pox.setOnBeatDetectedCallback(onBeatDetected);
-            _tsLastBeatChange = millis();
+            _tsLastBeatChange = halMillis();
             _lastBeatCountForStall = _beatCountTotal;
             _sensorOk = true;
             return true;
         }
 
         Serial.println("[SENSOR] MAX30100 init FAILED. Check wiring/pull-ups.");
+        if (_i2cBurst) i2cFallback();
         if (attempt < MAX_INIT_RETRIES) {
-            delay(INIT_RETRY_DELAY_MS);
+            halDelay(INIT_RETRY_DELAY_MS);
         }
     }
     return false;
 }
 
-// --- Public: Initialize ---
-bool sensorInit() {
-    pinMode(PIN_BEAT_LED, OUTPUT);
-    digitalWrite(PIN_BEAT_LED, LOW);
-    pinMode(PIN_ECG_LO_PLUS, INPUT);
-    pinMode(PIN_ECG_LO_MINUS, INPUT);
-    analogSetPinAttenuation(PIN_ECG_OUTPUT, ADC_11db);
-    analogReadResolution(12);
-
-    Wire.begin(PIN_I2C_SDA, PIN_I2C_SCL);
-    Wire.setClock(100000);
-
-    bool ok = initializeMax30100();
-    if (ok) {
-        _windowStartMs = millis();
-        _ecgIndex = 0;
-        _beatIndex = 0;
-        _windowReady = false;
-    }
-
-    Serial.println("[SENSOR] AD8232 ECG ready on GPIO34.");
-    return ok;
-}
-
-// --- Public: Update (call from loop as fast as possible) ---
-void sensorUpdate() {
-    // CRITICAL: MAX30100 needs frequent polling
+// --- PPG: FIFO readout, stall recovery, HR/SpO2 and bus reports ---
+// Runs from sensorUpdate() in poll mode, else from the PPG task.
+static void ppgService() {
     pox.update();
 
-    uint32_t now = millis();
-
-    // --- ECG sampling at 250Hz ---
-    if (now - _tsLastEcgSample >= ECG_SAMPLE_PERIOD_MS) {
-        _tsLastEcgSample = now;
-
-        _ecgLeadOff = (digitalRead(PIN_ECG_LO_PLUS) == HIGH)
-                    || (digitalRead(PIN_ECG_LO_MINUS) == HIGH);
-
-        if (_ecgLeadOff) {
-            _lastEcgValue = 0;
-            _ecgNotch.reset();
-            _ecgLpf.reset();
-            _ecgDcRemover.reset();
-        } else {
-            // 4x ADC oversampling for ~6dB noise reduction
-            uint32_t sum = 0;
-            for (int i = 0; i < ECG_OVERSAMPLE_COUNT; i++) {
-                sum += analogRead(PIN_ECG_OUTPUT);
-            }
-            float raw = (float)sum / ECG_OVERSAMPLE_COUNT;
-
-            // Filter chain: 50Hz notch -> 40Hz LPF -> DC removal
-            float notched  = _ecgNotch.step(raw);
-            float smoothed = _ecgLpf.step(notched);
-            float centered = _ecgDcRemover.step(smoothed);
-
-            // Re-center at 2048 (mid-range for 12-bit ADC) and clamp
-            _lastEcgValue = constrain((int)(centered + 2048.0f), 0, 4095);
-        }
-
-        // Fill buffer if window is still collecting
-        if (!_windowReady && _ecgIndex < ECG_SAMPLES_PER_WINDOW) {
-            _ecgBuffer[_ecgIndex++] = (uint16_t)_lastEcgValue;
-
-            if (_ecgIndex >= ECG_SAMPLES_PER_WINDOW) {
-                _windowReady = true;
-            }
-        }
-
-        // Text mode printing counter
-        _ecgTextCounter++;
-        if (_ecgTextCounter >= ECG_TEXT_DIVISOR) {
-            _ecgTextCounter = 0;
-            _shouldPrintText = true;
-        }
+    // The driver gave up on burst reads: slow the bus down to match
+    if (_i2cBurst && !pox.isBurstReadEnabled()) {
+        i2cFallback();
     }
 
-    // --- Non-blocking LED off after 50ms blink ---
-    static uint32_t ledOnTime = 0;
-    if (digitalRead(PIN_BEAT_LED) == HIGH) {
-        if (ledOnTime == 0) ledOnTime = now;
-        else if (now - ledOnTime > 50) {
-            digitalWrite(PIN_BEAT_LED, LOW);
-            ledOnTime = 0;
-        }
-    }
+    uint32_t now = halMillis();
 
     // --- Stall detection ---
     if (_beatCountTotal != _lastBeatCountForStall) {
@@ -195,38 +212,356 @@ void sensorUpdate() {
         _lastSpO2 = pox.getSpO2();
         _tsLastReport = now;
     }
+
+    // --- Periodic bus usage (rates over the last period) ---
+    if (now - _tsLastBusStats >= I2C_STATS_PERIOD_MS) {
+        const MAX30100BusStats& stats = pox.getBusStats();
+        float seconds = (now - _tsLastBusStats) / 1000.0f;
+        uint32_t bytes = stats.bytes - _lastBusStats.bytes;
+        // 9 clocks per byte (8 bits + ACK), ignoring start/stop conditions
+        float busMsPerSec = bytes * 9 * 1000.0f / i2cClockHz() / seconds;
+        Serial.printf("[I2C] %s %lukHz: %.0f transactions/s, %.0f bytes/s, %.1f ms/s bus, %u errors\n",
+                      _i2cBurst ? "burst" : "per-sample", (unsigned long)(i2cClockHz() / 1000),
+                      (stats.transactions - _lastBusStats.transactions) / seconds, bytes / seconds,
+                      busMsPerSec, (unsigned)(stats.errors - _lastBusStats.errors));
+        _lastBusStats = stats;
+        _tsLastBusStats = now;
+    }
 }
 
-// --- Public: Window ready check ---
-bool sensorIsWindowReady() {
-    return _windowReady;
+#if MAX30100_IRQ_MODE != MAX30100_IRQ_POLL
+// --- PPG task: woken by the MAX30100 INT line, touches I2C only then ---
+static HalSignal _ppgSignal = nullptr;
+
+static void HAL_ISR_ATTR onMax30100Int(void* arg) {
+    halSignalGiveFromIsr(_ppgSignal);
+}
+
+static void ppgTaskFn(void* param) {
+    bool warned = false;
+    while (true) {
+        // A missed edge leaves INT low until the status read below; the
+        // timeout also keeps stall detection running without interrupts
+        if (!halSignalTake(_ppgSignal, PPG_IRQ_TIMEOUT_MS) && !warned) {
+            Serial.printf("[SENSOR] No MAX30100 interrupt. Check the INT wire (GPIO%d).\n", PIN_MAX30100_INT);
+            warned = true;
+        }
+        pox.getInterruptStatus();   // Releases INT for the next event
+        ppgService();
+    }
+}
+#endif
+
+// --- Store one filtered sample (0 while the leads are off) ---
+static void storeEcgSample(int value) {
+    _lastEcgValue = value;
+
+    // Append to the ring; a window completes every ECG_WINDOW_HOP_SAMPLES
+    _ecgRing[_ecgSeq & (ECG_RING_SIZE - 1)] = (uint16_t)_lastEcgValue;
+    _ecgSeq++;
+
+    if (_ecgSeq - _nextWindowStartSeq >= ECG_SAMPLES_PER_WINDOW + WINDOW_QRS_HOLD_SAMPLES) {
+        // If the previous window never got a pool buffer, the newer one replaces it
+        if (_windowReady) {
+            Serial.println("[SENSOR] No free window buffer in time, replaced by newer one");
+        }
+        _readyWindow.startSeq = _nextWindowStartSeq;
+        _readyWindow.length = ECG_SAMPLES_PER_WINDOW;
+        _readyWindowStartMs = halMillis() - ECG_WINDOW_MS - QRS_LATENCY_MS;
+        _windowReady = true;
+        _nextWindowStartSeq += ECG_WINDOW_HOP_SAMPLES;
+    }
+
+    // Text mode printing counter
+    _ecgTextCounter++;
+    if (_ecgTextCounter >= ECG_TEXT_DIVISOR) {
+        _ecgTextCounter = 0;
+        _shouldPrintText = true;
+    }
+}
+
+// --- Sample latency ---
+static uint8_t latencyBucket(uint32_t us) {
+    if (us < 8) return (uint8_t)us;
+    uint8_t msb = 31 - __builtin_clz(us);
+    return (uint8_t)((msb - 2) * 8 + ((us >> (msb - 3)) & 7));
+}
+
+// Largest value that falls in bucket
+static uint32_t latencyBucketMax(uint8_t bucket) {
+    if (bucket < 8) return bucket;
+    uint8_t shift = bucket / 8 - 1;
+    return ((uint32_t)(9 + bucket % 8) << shift) - 1;
 }
 
-// --- Public: Get completed window and reset ---
-bool sensorGetWindow(SensorWindow& window) {
-    if (!_windowReady) return false;
+// A block is filtered and stored at once: one timestamp for all of it
+static void recordLatency(const uint32_t* ticks, size_t n) {
+    uint32_t now = (uint32_t)halMicros();
+    for (size_t i = 0; i < n; i++) {
+        int32_t late = (int32_t)(now - ticks[i]);
+        uint32_t us = late > 0 ? (uint32_t)late : 0;
+        _latencyBuckets[latencyBucket(us)]++;
+        if (us > _latencyMaxUs) _latencyMaxUs = us;
+        if (us > SENSOR_LATENCY_BUDGET_US) _latencyOverBudget++;
+    }
+    _latencyCount += n;
+}
 
-    memcpy(window.ecgSamples, _ecgBuffer, ECG_SAMPLES_PER_WINDOW * sizeof(uint16_t));
-    window.ecgSampleCount = _ecgIndex;
+static uint32_t latencyPercentile(uint32_t perMille) {
+    uint32_t rank = (uint32_t)(((uint64_t)_latencyCount * perMille + 999) / 1000);
+    uint32_t seen = 0;
+    for (uint16_t b = 0; b < LATENCY_BUCKETS; b++) {
+        seen += _latencyBuckets[b];
+        if (seen >= rank) return min(latencyBucketMax((uint8_t)b), _latencyMaxUs);
+    }
+    return _latencyMaxUs;
+}
 
-    memcpy(window.beatTimestampsMs, _beatTimestamps, _beatIndex * sizeof(uint16_t));
-    window.beatCount = _beatIndex;
+// --- Queue the period's percentiles for loop() and start a new period ---
+static void reportLatency(uint32_t now) {
+    if (now - _tsLastLatencyReport < SENSOR_LATENCY_REPORT_MS) return;
+    _tsLastLatencyReport = now;
+    if (_latencyCount == 0) return;
+
+    SensorLatencyReport report;
+    report.samples = _latencyCount;
+    report.p50Us = latencyPercentile(500);
+    report.p99Us = latencyPercentile(990);
+    report.p999Us = latencyPercentile(999);
+    report.maxUs = _latencyMaxUs;
+    report.overBudget = _latencyOverBudget;
+    _latencyQueue.push(report);     // Dropped while loop() is 4 reports behind
+
+    memset(_latencyBuckets, 0, sizeof(_latencyBuckets));
+    _latencyCount = 0;
+    _latencyMaxUs = 0;
+    _latencyOverBudget = 0;
+}
+
+// --- Filter a block of connected-lead samples in place and store them ---
+static void filterEcgBlock(EcgFilterSample* block, const uint32_t* ticks, size_t n) {
+    if (n == 0) return;
+    _ecgLeadOff = false;
+
+    // Filter chain: mains notch -> 40Hz LPF -> DC removal
+    _ecgNotch.process(block, n);
+    _ecgLpf.process(block, n);
+    _ecgDcRemover.process(block, n);
+
+    // Re-center at 2048 (mid-range for 12-bit ADC) and clamp
+    for (size_t i = 0; i < n; i++) {
+#if ECG_FILTER_IMPL == ECG_FILTER_FIXED
+        int value = constrain(ecgFixedToCounts(block[i]) + 2048, 0, 4095);
+#else
+        int value = constrain((int)(block[i] + 2048.0f), 0, 4095);
+#endif
+        storeEcgSample(value);
+
+        // R peak positions are sample-accurate on the stored signal
+        uint32_t peakAgo;
+        if (_qrs.step(value - 2048, peakAgo)) {
+            uint32_t seq = _ecgSeq - 1 - peakAgo;
+            _rPeakSeqRing[_rPeakSeqCount & (BEAT_RING_SIZE - 1)] = seq;
+            _rPeakSeqCount++;
+            _hrv.addBeat(seq);
+        }
+    }
+    recordLatency(ticks, n);
+}
+
+// --- Filter and store the samples waiting in the acquisition ring ---
+// Runs of connected-lead samples go through the filters ECG_FILTER_BLOCK
+// at a time; a lead-off sample ends the run and resets the filters.
+static void processEcgSamples() {
+    EcgFilterSample block[ECG_FILTER_BLOCK];
+    uint32_t ticks[ECG_FILTER_BLOCK];
+    size_t n = 0;
+    EcgRawSample raw[ECG_FILTER_BLOCK];
+    uint16_t count;
+
+    while ((count = ecgAcqRead(raw, ECG_FILTER_BLOCK)) > 0) {
+        for (uint16_t i = 0; i < count; i++) {
+            const EcgRawSample& sample = raw[i];
+            if (sample.leadOff) {
+                filterEcgBlock(block, ticks, n);
+                n = 0;
+                _ecgLeadOff = true;
+                _ecgNotch.reset();
+                _ecgLpf.reset();
+                _ecgDcRemover.reset();
+                _qrs.reset();
+                _hrv.breakRhythm();
+                storeEcgSample(0);
+                recordLatency(&sample.tickUs, 1);
+                continue;
+            }
+
+            ticks[n] = sample.tickUs;
+#if ECG_FILTER_IMPL == ECG_FILTER_FIXED
+            block[n++] = ecgToFixed(sample.value);
+#else
+            block[n++] = sample.value;
+#endif
+            if (n == ECG_FILTER_BLOCK) {
+                filterEcgBlock(block, ticks, n);
+                n = 0;
+            }
+        }
+    }
+    filterEcgBlock(block, ticks, n);
+}
+
+// --- Copy the completed window out of the ring and queue it for loop() ---
+static void handOffWindow() {
+    if (!_windowReady) return;
+
+    // Pool exhausted: leave the window ready and retry on the next pass
+    SensorWindow* slot = windowPoolAcquire();
+    if (!slot) return;
+    SensorWindow& window = *slot;
+
+    window.ecgSampleCount = sensorCopyEcg(_readyWindow.startSeq,
+                                          window.ecgSamples, _readyWindow.length);
+
+    // Beats that fall inside [startSeq, startSeq + length), as ms from window start
+    window.beatCount = 0;
+    uint32_t oldest = _beatSeqCount > BEAT_RING_SIZE ? _beatSeqCount - BEAT_RING_SIZE : 0;
+    for (uint32_t i = oldest; i < _beatSeqCount; i++) {
+        uint32_t offset = _beatSeqRing[i & (BEAT_RING_SIZE - 1)] - _readyWindow.startSeq;
+        if (offset >= _readyWindow.length) continue;   // Also rejects beats before start (wraps)
+        if (window.beatCount >= MAX_BEATS_PER_WINDOW) break;
+        window.beatTimestampsMs[window.beatCount++] =
+            (uint16_t)(offset * 1000UL / ECG_SAMPLE_RATE_HZ);
+    }
+
+    // R peaks inside the window, as sample offsets
+    window.rPeakCount = 0;
+    oldest = _rPeakSeqCount > BEAT_RING_SIZE ? _rPeakSeqCount - BEAT_RING_SIZE : 0;
+    for (uint32_t i = oldest; i < _rPeakSeqCount; i++) {
+        uint32_t offset = _rPeakSeqRing[i & (BEAT_RING_SIZE - 1)] - _readyWindow.startSeq;
+        if (offset >= _readyWindow.length) continue;
+        if (window.rPeakCount >= MAX_BEATS_PER_WINDOW) break;
+        window.rPeakSamples[window.rPeakCount++] = (uint16_t)offset;
+    }
+    _hrv.window(_readyWindow.startSeq, _readyWindow.startSeq + _readyWindow.length, window.hrv);
+    window.screenScore = -1.0f;     // Scored by the caller
 
     window.heartRateBpm = _lastHR;
     window.spo2Percent = _lastSpO2;
     window.ecgLeadOff = _ecgLeadOff;
-    window.windowStartMs = _windowStartMs;
+    window.windowStartMs = _readyWindowStartMs;
+
+    EcgAcqStats stats;
+    ecgAcqTakeStats(stats);
+    window.ecgDroppedSamples = stats.droppedSamples;
+    window.ecgMaxJitterUs = stats.maxJitterUs;
 
-    // Reset for next window
-    _ecgIndex = 0;
-    _beatIndex = 0;
-    _windowStartMs = millis();
+    // Filters keep their state: the next window continues the same signal
     _windowReady = false;
-    _ecgNotch.reset();
-    _ecgLpf.reset();
-    _ecgDcRemover.reset();
+    _windowQueue.push(slot);
+}
+
+// --- Acquisition and DSP: everything pending, then the hand-offs ---
+// Runs from the sensor task, or from sensorUpdate() when SENSOR_TASK is 0.
+static void sensorService() {
+#if MAX30100_IRQ_MODE == MAX30100_IRQ_POLL
+    // CRITICAL: MAX30100 needs frequent polling
+    ppgService();
+#endif
+
+    uint32_t now = halMillis();
+
+    // --- ECG: drain samples taken by the 250Hz sample clock ---
+    ecgAcqPoll();
+    processEcgSamples();
+    handOffWindow();
+    reportLatency(now);
+
+    // --- Non-blocking LED off after 50ms blink ---
+    static uint32_t ledOnTime = 0;
+    if (halDigitalRead(PIN_BEAT_LED)) {
+        if (ledOnTime == 0) ledOnTime = now;
+        else if (now - ledOnTime > 50) {
+            halDigitalWrite(PIN_BEAT_LED, false);
+            ledOnTime = 0;
+        }
+    }
+}
+
+#if SENSOR_TASK
+// --- Sensor task: woken by the ECG sample clock, above loop() ---
+static HalSignal _sampleSignal = nullptr;
 
-    return true;
+static void sensorTaskFn(void* param) {
+    while (true) {
+        halSignalTake(_sampleSignal, SENSOR_TASK_TIMEOUT_MS);
+        sensorService();
+    }
+}
+#endif
+
+// --- Public: Initialize ---
+bool sensorInit() {
+    halPinMode(PIN_BEAT_LED, HAL_PIN_OUTPUT);
+    halDigitalWrite(PIN_BEAT_LED, false);
+
+    halI2cBegin(PIN_I2C_SDA, PIN_I2C_SCL, i2cClockHz());
+
+    windowPoolInit();
+
+#if MAX30100_IRQ_MODE != MAX30100_IRQ_POLL
+    _ppgSignal = halSignalCreate();
+    halAttachFallingIsr(PIN_MAX30100_INT, onMax30100Int, nullptr);
+#endif
+
+    bool ok = initializeMax30100();
+    if (ok) {
+        _nextWindowStartSeq = _ecgSeq;
+        _windowReady = false;
+    }
+
+#if MAX30100_IRQ_MODE != MAX30100_IRQ_POLL
+    // Started even if init failed: its stall check keeps retrying
+    halTaskStart(ppgTaskFn, "ppg", PPG_TASK_STACK, PPG_TASK_PRIORITY, PPG_TASK_CORE);
+    Serial.printf("[SENSOR] MAX30100 FIFO serviced on INT (GPIO%d, %s).\n", PIN_MAX30100_INT,
+                  MAX30100_IRQ_MODE == MAX30100_IRQ_SAMPLE ? "per sample" : "FIFO almost full");
+#endif
+
+    _tsLastLatencyReport = halMillis();
+#if SENSOR_TASK
+    _sampleSignal = halSignalCreate();
+    ecgAcqBegin(_sampleSignal);
+    halTaskStart(sensorTaskFn, "sensor", SENSOR_TASK_STACK, SENSOR_TASK_PRIORITY, SENSOR_TASK_CORE);
+    Serial.printf("[SENSOR] Acquisition and DSP in the sensor task (core %d, priority %d).\n",
+                  SENSOR_TASK_CORE, SENSOR_TASK_PRIORITY);
+#else
+    ecgAcqBegin();
+#endif
+    Serial.println("[SENSOR] AD8232 ECG ready on GPIO34.");
+    return ok;
+}
+
+// --- Public: Update (acquisition and DSP from loop() without the sensor task) ---
+void sensorUpdate() {
+#if !SENSOR_TASK
+    sensorService();
+#endif
+}
+
+// --- Public: Window ready check ---
+bool sensorIsWindowReady() {
+    return !_windowQueue.empty();
+}
+
+// --- Public: Next window handed off by the acquisition side ---
+SensorWindow* sensorTakeWindow() {
+    SensorWindow* window = nullptr;
+    _windowQueue.pop(window);
+    return window;
+}
+
+bool sensorPollLatencyReport(SensorLatencyReport& report) {
+    return _latencyQueue.pop(report);
 }
 
 // --- Public: Accessors ---
@@ -236,6 +571,13 @@ int      sensorGetLastEcgValue() { return _lastEcgValue; }
 bool     sensorIsEcgLeadOff()    { return _ecgLeadOff; }
 bool     sensorIsOk()            { return _sensorOk; }
 uint32_t sensorGetBeatCount()    { return _beatCountTotal; }
+uint32_t sensorGetRPeakCount()   { return _rPeakSeqCount; }
+
+SensorBusStats sensorGetBusStats() {
+    const MAX30100BusStats& stats = pox.getBusStats();
+    SensorBusStats out = {stats.transactions, stats.bytes, stats.errors, i2cClockHz(), _i2cBurst};
+    return out;
+}
 
 bool sensorShouldPrintEcgText() {
     if (_shouldPrintText) {
@@ -245,5 +587,26 @@ bool sensorShouldPrintEcgText() {
     return false;
 }
 
-uint16_t sensorGetEcgIndex() { return _ecgIndex; }
-const uint16_t* sensorGetEcgBuffer() { return _ecgBuffer; }
+uint32_t sensorGetEcgSeq() { return _ecgSeq; }
+
+uint16_t sensorCopyEcg(uint32_t fromSeq, uint16_t* out, uint16_t count) {
+    // One snapshot of the writer: the sensor task keeps advancing it.
+    // Clamp to what is already written and not about to be overwritten.
+    uint32_t seq = _ecgSeq.load(std::memory_order_acquire);
+    uint32_t oldest = seq > ECG_RING_SIZE - ECG_COPY_GUARD_SAMPLES ? seq - (ECG_RING_SIZE - ECG_COPY_GUARD_SAMPLES) : 0;
+    if ((int32_t)(fromSeq - oldest) < 0) return 0;
+    int32_t available = (int32_t)(seq - fromSeq);
+    if (available <= 0) return 0;
+    if ((int32_t)count > available) count = (uint16_t)available;
+
+    // At most two contiguous runs (before and after the wrap point)
+    uint16_t slot = fromSeq & (ECG_RING_SIZE - 1);
+    uint16_t first = min((uint16_t)(ECG_RING_SIZE - slot), count);
+    memcpy(out, &_ecgRing[slot], first * sizeof(uint16_t));
+    memcpy(out + first, _ecgRing, (count - first) * sizeof(uint16_t));
+
+    // The writer lapped the start of the copy while it ran (reader stalled)
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_ecgSeq.load(std::memory_order_relaxed) - fromSeq > ECG_RING_SIZE) return 0;
+    return count;
+}
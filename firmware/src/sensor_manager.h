@@ -3,30 +3,64 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "hrv.h"
+
+// Completed window as a view over the continuous ECG ring
+struct EcgWindowView {
+    uint32_t startSeq;      // Sequence number of the first sample
+    uint16_t length;        // Samples in the window
+};
 
 // Data window: one 10-second collection ready for transmission
 struct SensorWindow {
     uint16_t ecgSamples[ECG_SAMPLES_PER_WINDOW];
     uint16_t ecgSampleCount;
-    uint16_t beatTimestampsMs[MAX_BEATS_PER_WINDOW];
+    uint16_t beatTimestampsMs[MAX_BEATS_PER_WINDOW];   // PPG beats (MAX30100)
     uint8_t  beatCount;
+    uint16_t rPeakSamples[MAX_BEATS_PER_WINDOW];       // ECG R peaks, sample index in ecgSamples
+    uint8_t  rPeakCount;
+    HrvFeatures hrv;                                   // RR statistics of the R peaks
+    float    screenScore;                              // On-device CNN (ecg_cnn.h), < 0 = not run
     float    heartRateBpm;
     uint8_t  spo2Percent;
     bool     ecgLeadOff;
     uint32_t windowStartMs;
+    uint16_t ecgDroppedSamples;     // Sample clock periods lost in this window
+    uint16_t ecgMaxJitterUs;        // Worst sample spacing error in this window
 };
 
 // Initialize both sensors. Returns false if MAX30100 fails after retries.
 bool sensorInit();
 
-// Must be called from loop() as frequently as possible.
+// Call from loop(). Runs acquisition and DSP when SENSOR_TASK is 0 (then
+// as frequently as possible); a no-op when the sensor task runs them.
 void sensorUpdate();
 
-// Returns true when 1000 ECG samples have been collected.
+// Returns true when a full ECG_SAMPLES_PER_WINDOW window has completed and
+// the QRS detector has decided on its beats (QRS_LATENCY_MS later).
 bool sensorIsWindowReady();
 
-// Copy completed window data and reset for next window.
-bool sensorGetWindow(SensorWindow& window);
+// Next completed window, copied out of the ring into a window_pool buffer
+// by the acquisition side. Caller owns the returned buffer (release or hand
+// it to dataSenderEnqueue()). Returns nullptr if no window is ready. While
+// the pool is exhausted windows wait in the ring, the newest one replacing
+// an older one. Acquisition never pauses and filter state carries across windows.
+SensorWindow* sensorTakeWindow();
+
+// Latency from each ECG sample's scheduled time on the sample clock to it
+// being filtered and in the ring, over one SENSOR_LATENCY_REPORT_MS period.
+// Percentiles are bucket upper bounds (within 12.5%).
+struct SensorLatencyReport {
+    uint32_t samples;
+    uint32_t p50Us;
+    uint32_t p99Us;
+    uint32_t p999Us;
+    uint32_t maxUs;
+    uint32_t overBudget;    // Samples later than SENSOR_LATENCY_BUDGET_US
+};
+
+// Returns true and fills report when a period has completed since the last call.
+bool sensorPollLatencyReport(SensorLatencyReport& report);
 
 // Real-time accessors for serial debug
 float    sensorGetHeartRate();
@@ -34,13 +68,26 @@ uint8_t  sensorGetSpO2();
 int      sensorGetLastEcgValue();
 bool     sensorIsEcgLeadOff();
 bool     sensorIsOk();
-uint32_t sensorGetBeatCount();
+uint32_t sensorGetBeatCount();      // PPG beats since boot
+uint32_t sensorGetRPeakCount();     // ECG R peaks since boot
+
+// MAX30100 bus usage since boot (bytes include address and register bytes)
+struct SensorBusStats {
+    uint32_t transactions;
+    uint32_t bytes;
+    uint32_t errors;
+    uint32_t clockHz;       // Current bus clock
+    bool     burst;         // Burst FIFO reads (false after a fallback)
+};
+SensorBusStats sensorGetBusStats();
 
 // Returns true every ECG_TEXT_DIVISOR samples (for 10Hz text output)
 bool sensorShouldPrintEcgText();
 
-// ECG buffer access for BLE streaming
-uint16_t        sensorGetEcgIndex();
-const uint16_t* sensorGetEcgBuffer();
+// ECG ring access for BLE streaming
+uint32_t sensorGetEcgSeq();     // Total filtered samples written since boot
+// Copies up to count samples from fromSeq, never more. Returns 0 when
+// fromSeq is not written yet or is too close to being overwritten.
+uint16_t sensorCopyEcg(uint32_t fromSeq, uint16_t* out, uint16_t count);
 
 #endif // SENSOR_MANAGER_H
@@ -0,0 +1,248 @@
+#include "vitals_payload.h"
+#include "ecg_codec.h"
+
+// One worst-case codec block (k, raw first sample, all escapes) + carry byte
+#define RICE_BLOCK_MAX_BYTES \
+    ((4 + 16 + ECG_CODEC_BLOCK * (ECG_CODEC_ESCAPE_Q + ECG_CODEC_ESCAPE_BITS) + 7) / 8 + 1)
+
+static inline uint8_t* putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static inline uint8_t* putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+    return p + 4;
+}
+
+// ============================================================
+//  Binary
+// ============================================================
+
+// Packed 12-bit samples, two per 3 bytes
+static size_t writePacked12(Print& out, const uint16_t* s, uint16_t count) {
+    uint8_t buf[48];
+    uint8_t* p = buf;
+    size_t written = 0;
+    uint16_t i = 0;
+    for (; i + 1 < count; i += 2) {
+        uint16_t a = s[i] & 0x0FFF;
+        uint16_t b = s[i + 1] & 0x0FFF;
+        *p++ = (uint8_t)a;
+        *p++ = (uint8_t)((a >> 8) | ((b & 0x0F) << 4));
+        *p++ = (uint8_t)(b >> 4);
+        if (p == buf + sizeof(buf)) {
+            written += out.write(buf, sizeof(buf));
+            p = buf;
+        }
+    }
+    if (i < count) {
+        uint16_t a = s[i] & 0x0FFF;
+        *p++ = (uint8_t)a;
+        *p++ = (uint8_t)(a >> 8);
+    }
+    written += out.write(buf, p - buf);
+    return written;
+}
+
+// Rice frame coded one block at a time. With out == nullptr only the
+// frame length is computed.
+static size_t writeRice(Print* out, const uint16_t* s, uint16_t count) {
+    uint8_t buf[RICE_BLOCK_MAX_BYTES];
+    EcgRiceEncoder enc;
+    enc.begin(buf, sizeof(buf));
+
+    size_t total = 0;
+    for (uint32_t off = 0; off < count; off += ECG_CODEC_BLOCK) {
+        uint16_t n = (count - off < ECG_CODEC_BLOCK) ? count - off : ECG_CODEC_BLOCK;
+        enc.encode(s + off, n);
+        size_t ready = enc.flush();
+        total += out ? out->write(buf, ready) : ready;
+    }
+    size_t tail = enc.finish();
+    total += out ? out->write(buf, tail) : tail;
+    return total;
+}
+
+size_t vitalsWriteBinary(const SensorWindow& window,
+                         const char* deviceId,
+                         time_t timestamp,
+                         uint32_t seq,
+                         Print& out) {
+    size_t idLen = strnlen(deviceId, VITALS_BIN_DEVICE_ID_MAX);
+    uint16_t count = window.ecgSampleCount;
+
+    // Rice only when it beats packed 12-bit for this window
+    uint8_t encoding = VITALS_BIN_ENC_PACKED12;
+    size_t riceLen = 0;
+#if API_ECG_COMPRESSION
+    riceLen = writeRice(nullptr, window.ecgSamples, count);
+    if (riceLen + 2 <= ((size_t)count * 3 + 1) / 2) encoding = VITALS_BIN_ENC_RICE;
+#endif
+
+    uint8_t flags = (uint8_t)(encoding << VITALS_BIN_ENC_SHIFT);
+    if (window.ecgLeadOff) flags |= VITALS_BIN_FLAG_LEAD_OFF;
+
+    uint8_t head[VITALS_BIN_HEADER_MAX + 2];
+    uint8_t* p = head;
+    *p++ = VITALS_BIN_MAGIC0;
+    *p++ = VITALS_BIN_MAGIC1;
+    *p++ = VITALS_BIN_VERSION;
+    *p++ = flags;
+    p = putU32(p, (uint32_t)timestamp);
+    p = putU16(p, ECG_SAMPLE_RATE_HZ);
+    p = putU16(p, ECG_WINDOW_MS);
+    p = putU16(p, (uint16_t)lroundf(window.heartRateBpm * 10.0f));
+    *p++ = window.spo2Percent;
+    *p++ = (uint8_t)idLen;
+    memcpy(p, deviceId, idLen);
+    p += idLen;
+    p = putU16(p, count);
+    *p++ = window.beatCount;
+    if (encoding == VITALS_BIN_ENC_RICE) p = putU16(p, (uint16_t)riceLen);
+
+    size_t written = out.write(head, p - head);
+    if (encoding == VITALS_BIN_ENC_RICE) {
+        written += writeRice(&out, window.ecgSamples, count);
+    } else {
+        written += writePacked12(out, window.ecgSamples, count);
+    }
+
+    uint8_t beats[1 + MAX_BEATS_PER_WINDOW * 2 + HRV_PACKED_SIZE + 2 + 4];
+    p = beats;
+    for (uint8_t b = 0; b < window.beatCount; b++) {
+        p = putU16(p, window.beatTimestampsMs[b]);
+    }
+    written += out.write(beats, p - beats);
+
+    p = beats;
+    *p++ = window.rPeakCount;
+    for (uint8_t b = 0; b < window.rPeakCount; b++) {
+        p = putU16(p, window.rPeakSamples[b]);
+    }
+    p += hrvPack(window.hrv, p);
+    p = putU16(p, window.screenScore >= 0.0f
+                  ? (uint16_t)lroundf(fminf(window.screenScore, 1.0f) * 10000.0f)
+                  : VITALS_BIN_NO_SCREEN);
+    p = putU32(p, seq);
+    written += out.write(beats, p - beats);
+    return written;
+}
+
+// ============================================================
+//  JSON
+// ============================================================
+static size_t putText(Print& out, const char* s) {
+    return out.write((const uint8_t*)s, strlen(s));
+}
+
+static size_t putUInt(Print& out, uint32_t v) {
+    char buf[10];
+    char* p = buf + sizeof(buf);
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    return out.write((const uint8_t*)p, buf + sizeof(buf) - p);
+}
+
+// JSON string (quotes and backslashes escaped, control chars dropped)
+static size_t putString(Print& out, const char* s) {
+    size_t written = out.write('"');
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') written += out.write('\\');
+        if ((uint8_t)*s >= 0x20) written += out.write((uint8_t)*s);
+    }
+    return written + out.write('"');
+}
+
+// Value in [0, 1] with four decimals, as the binary x10000 fields
+static size_t putFixed4(Print& out, float v) {
+    uint32_t x = (uint32_t)lroundf(fminf(fmaxf(v, 0.0f), 1.0f) * 10000.0f);
+    char buf[6] = { (char)('0' + x / 10000), '.',
+                    (char)('0' + x / 1000 % 10), (char)('0' + x / 100 % 10),
+                    (char)('0' + x / 10 % 10), (char)('0' + x % 10) };
+    return out.write((const uint8_t*)buf, sizeof(buf));
+}
+
+// Non-negative value with one decimal, as the binary x10 fields
+static size_t putFixed1(Print& out, float v) {
+    uint32_t x10 = v > 0 ? (uint32_t)lroundf(v * 10.0f) : 0;
+    size_t written = putUInt(out, x10 / 10);
+    if (x10 % 10) {
+        written += out.write('.');
+        written += out.write((uint8_t)('0' + x10 % 10));
+    }
+    return written;
+}
+
+size_t vitalsWriteJson(const SensorWindow& window,
+                       const char* deviceId,
+                       time_t timestamp,
+                       uint32_t seq,
+                       Print& out) {
+    size_t written = putText(out, "{\"device_id\":");
+    written += putString(out, deviceId);
+    written += putText(out, ",\"timestamp\":");
+    written += putUInt(out, (uint32_t)timestamp);
+    written += putText(out, ",\"window_ms\":");
+    written += putUInt(out, ECG_WINDOW_MS);
+    written += putText(out, ",\"sample_rate_hz\":");
+    written += putUInt(out, ECG_SAMPLE_RATE_HZ);
+    written += putText(out, ",\"heart_rate_bpm\":");
+    written += putFixed1(out, window.heartRateBpm);
+    written += putText(out, ",\"spo2_percent\":");
+    written += putUInt(out, window.spo2Percent);
+    written += putText(out, ",\"ecg_lead_off\":");
+    written += putText(out, window.ecgLeadOff ? "true" : "false");
+
+    written += putText(out, ",\"ecg_samples\":[");
+    for (uint16_t i = 0; i < window.ecgSampleCount; i++) {
+        if (i) written += out.write(',');
+        written += putUInt(out, window.ecgSamples[i]);
+    }
+
+    written += putText(out, "],\"beat_timestamps_ms\":[");
+    for (uint8_t i = 0; i < window.beatCount; i++) {
+        if (i) written += out.write(',');
+        written += putUInt(out, window.beatTimestampsMs[i]);
+    }
+
+    written += putText(out, "],\"r_peak_samples\":[");
+    for (uint8_t i = 0; i < window.rPeakCount; i++) {
+        if (i) written += out.write(',');
+        written += putUInt(out, window.rPeakSamples[i]);
+    }
+
+    written += putText(out, "],\"hrv\":{\"rr_count\":");
+    written += putUInt(out, window.hrv.rrCount);
+    written += putText(out, ",\"mean_rr\":");
+    written += putFixed1(out, window.hrv.meanRrMs);
+    written += putText(out, ",\"sdnn\":");
+    written += putFixed1(out, window.hrv.sdnnMs);
+    written += putText(out, ",\"rmssd\":");
+    written += putFixed1(out, window.hrv.rmssdMs);
+    written += putText(out, ",\"pnn50\":");
+    written += putFixed1(out, window.hrv.pnn50Percent);
+    written += putText(out, ",\"mean_hr_ecg\":");
+    written += putFixed1(out, window.hrv.meanHrBpm);
+    written += putText(out, ",\"hr_std\":");
+    written += putFixed1(out, window.hrv.hrStdBpm);
+    written += putText(out, ",\"rr_range\":");
+    written += putFixed1(out, window.hrv.rrRangeMs);
+    written += putText(out, "}");
+    if (window.screenScore >= 0.0f) {
+        written += putText(out, ",\"screen_score\":");
+        written += putFixed4(out, window.screenScore);
+    }
+    if (seq) {
+        written += putText(out, ",\"seq\":");
+        written += putUInt(out, seq);
+    }
+    written += putText(out, "}");
+    return written;
+}
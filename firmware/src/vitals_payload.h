@@ -0,0 +1,98 @@
+#ifndef VITALS_PAYLOAD_H
+#define VITALS_PAYLOAD_H
+
+#include <Arduino.h>
+#include "sensor_manager.h"
+
+// ============================================================
+//  Binary vitals upload format (application/octet-stream)
+// ============================================================
+// All multi-byte fields little-endian.
+//
+//   off  size  field
+//   0    2     magic "CV"
+//   2    1     version (VITALS_BIN_VERSION)
+//   3    1     flags: bit0 = ECG lead off, bits1-3 = sample encoding
+//   4    4     timestamp (unix seconds, uint32)
+//   8    2     sample_rate_hz
+//   10   2     window_ms
+//   12   2     heart_rate_bpm x10
+//   14   1     spo2_percent
+//   15   1     device_id length N (<= VITALS_BIN_DEVICE_ID_MAX)
+//   16   N     device_id (ASCII, no terminator)
+//   +0   2     sample_count
+//   +2   1     beat_count
+//   +3   ...   samples (see encoding)
+//   ...  2*B   beat_timestamps_ms (uint16 each)
+//   ...  1     r_peak_count R (version 2)
+//   ...  2*R   r_peak_samples (uint16 each, index into the samples)
+//   ...  15    HRV of the R peaks (version 3, hrvPack() in hrv.h)
+//   ...  2     screen_score x10000 of the on-device CNN (version 4,
+//              0xFFFF = not run)
+//   ...  4     seq of the window in the device's store (version 5, 0 =
+//              none). A resend repeats it; the server keeps one copy per
+//              (device_id, seq)
+//
+// Sample encoding 0 (packed 12-bit): samples a,b share 3 bytes
+//   [a & 0xFF] [(a >> 8) | ((b & 0x0F) << 4)] [b >> 4]
+// An odd trailing sample uses 2 bytes.
+//
+// Sample encoding 1 (Rice, ecg_codec.h): u16 byte length L, then L bytes of
+// one codec frame holding sample_count samples.
+#define VITALS_BIN_MAGIC0           'C'
+#define VITALS_BIN_MAGIC1           'V'
+#define VITALS_BIN_VERSION          5
+#define VITALS_BIN_FLAG_LEAD_OFF    0x01
+#define VITALS_BIN_ENC_SHIFT        1
+#define VITALS_BIN_ENC_MASK         0x0E
+#define VITALS_BIN_ENC_PACKED12     0
+#define VITALS_BIN_ENC_RICE         1
+#define VITALS_BIN_DEVICE_ID_MAX    32
+#define VITALS_BIN_NO_SCREEN        0xFFFF
+
+// Batch body (POST API_VITALS_BATCH_PATH): several records in one request
+//   0    2     magic "CB"
+//   2    1     version (VITALS_BATCH_VERSION)
+//   3    1     record count
+//   then per record: u16 length L, L bytes of one binary record (above)
+#define VITALS_BATCH_MAGIC1         'B'
+#define VITALS_BATCH_VERSION        1
+#define VITALS_BATCH_HEADER_SIZE    4
+
+#define VITALS_BIN_HEADER_MAX       (16 + VITALS_BIN_DEVICE_ID_MAX + 3)
+#define VITALS_BIN_MAX_SIZE         (VITALS_BIN_HEADER_MAX                      \
+                                     + (ECG_SAMPLES_PER_WINDOW * 3 + 1) / 2     \
+                                     + MAX_BEATS_PER_WINDOW * 2                 \
+                                     + 1 + MAX_BEATS_PER_WINDOW * 2             \
+                                     + HRV_PACKED_SIZE + 2 + 4)
+
+// Streamed serializers: write one window to out without materializing the
+// body (a few hundred bytes of stack). Return the bytes written; a short
+// count means out failed. Output is deterministic, so running a writer into
+// a PayloadCounter first gives the exact Content-Length. seq is the
+// window's store seq (storeTakeSeq()), 0 when it has none.
+size_t vitalsWriteBinary(const SensorWindow& window,
+                         const char* deviceId,
+                         time_t timestamp,
+                         uint32_t seq,
+                         Print& out);
+
+// Same fields as VitalsCreate on the backend (POST API_VITALS_PATH)
+size_t vitalsWriteJson(const SensorWindow& window,
+                       const char* deviceId,
+                       time_t timestamp,
+                       uint32_t seq,
+                       Print& out);
+
+// Print that only counts bytes
+class PayloadCounter : public Print {
+public:
+    size_t write(uint8_t) override { _count++; return 1; }
+    size_t write(const uint8_t* buffer, size_t size) override { _count += size; return size; }
+    size_t count() const { return _count; }
+
+private:
+    size_t _count = 0;
+};
+
+#endif // VITALS_PAYLOAD_H
@@ -0,0 +1,31 @@
+#include "window_pool.h"
+#include "hal.h"
+
+static SensorWindow _pool[WINDOW_POOL_SIZE];
+static HalQueue     _freeQueue = nullptr;      // Holds SensorWindow* of free slots
+
+void windowPoolInit() {
+    if (_freeQueue) return;
+    _freeQueue = halQueueCreate(WINDOW_POOL_SIZE, sizeof(SensorWindow*));
+    for (uint8_t i = 0; i < WINDOW_POOL_SIZE; i++) {
+        SensorWindow* slot = &_pool[i];
+        halQueueSend(_freeQueue, &slot, 0);
+    }
+}
+
+SensorWindow* windowPoolAcquire() {
+    SensorWindow* slot = nullptr;
+    if (!_freeQueue) return nullptr;
+    if (!halQueueReceive(_freeQueue, &slot, 0)) return nullptr;
+    return slot;
+}
+
+void windowPoolRelease(SensorWindow* window) {
+    if (!_freeQueue || !window) return;
+    halQueueSend(_freeQueue, &window, 0);
+}
+
+uint8_t windowPoolAvailable() {
+    if (!_freeQueue) return 0;
+    return (uint8_t)halQueueCount(_freeQueue);
+}
@@ -0,0 +1,22 @@
+#ifndef WINDOW_POOL_H
+#define WINDOW_POOL_H
+
+#include <Arduino.h>
+#include "sensor_manager.h"
+
+// Preallocated SensorWindow buffers shared by sensor_manager (fills) and
+// data_sender (posts). Ownership moves by pointer; nothing is copied.
+// One slot per queued job plus one in flight.
+#define WINDOW_POOL_SIZE    (DATA_SEND_QUEUE_DEPTH + 1)
+
+void          windowPoolInit();
+
+// Take a free buffer. Non-blocking, returns nullptr when all are in use.
+SensorWindow* windowPoolAcquire();
+
+// Return a buffer to the pool (safe from any task).
+void          windowPoolRelease(SensorWindow* window);
+
+uint8_t       windowPoolAvailable();
+
+#endif // WINDOW_POOL_H
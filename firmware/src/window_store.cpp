@@ -0,0 +1,514 @@
+#include "window_store.h"
+#include "config.h"
+#include "vitals_payload.h"
+#include "hal.h"
+
+#include <LittleFS.h>
+#include <Preferences.h>
+
+#define RECORD_HEADER_SIZE      16
+#define RECORD_TRAILER_SIZE     4
+#define RECORD_PAYLOAD_MIN      8               // Up to and including the timestamp
+#define RECORD_PAYLOAD_MAX      VITALS_BIN_MAX_SIZE
+#define PAYLOAD_TS_OFFSET       4               // Timestamp field in vitals_payload.h
+#define MAX_SEGMENTS            (STORE_MAX_BYTES / STORE_SEGMENT_BYTES + 2)
+#define MAX_BOOT_ANCHORS        4
+
+struct Segment {
+    uint32_t id;        // Seq of its first record, also the file name
+    uint32_t size;      // File bytes (capacity accounting)
+    uint32_t end;       // End of the last valid record
+    uint32_t start;     // First unacknowledged record
+    uint16_t pending;   // Unacknowledged records
+};
+
+// Unix time of a boot's millis() == 0, learned from a synced record or NVS
+struct BootAnchor {
+    uint32_t bootId;
+    int64_t  epochMs;
+};
+
+static Segment    _segs[MAX_SEGMENTS];
+static uint8_t    _segCount = 0;
+static uint32_t   _readOffset = 0;      // Into _segs[0]
+static bool       _tailSealed = true;   // Next append opens a new segment
+static uint32_t   _pending = 0;
+static uint32_t   _totalBytes = 0;
+static uint32_t   _nextSeq = 1;
+static uint32_t   _seqReserved = 0;
+static uint32_t   _ackSeq = 0;
+static uint32_t   _ackSeqSaved = 0;     // Last _ackSeq written to NVS
+static uint32_t   _bootId = 0;
+static bool       _clockNoted = false;
+static bool       _ready = false;
+
+static BootAnchor _anchors[MAX_BOOT_ANCHORS];
+static uint8_t    _anchorCount = 0;
+static uint8_t    _anchorNext = 0;
+
+static Preferences _prefs;
+
+// ============================================================
+//  Helpers
+// ============================================================
+static uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t len) {
+    static const uint32_t table[16] = {
+        0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+        0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+        0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+        0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+    };
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc = (crc >> 4) ^ table[(crc ^ data[i]) & 0x0F];
+        crc = (crc >> 4) ^ table[(crc ^ (data[i] >> 4)) & 0x0F];
+    }
+    return ~crc;
+}
+
+static inline void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static inline void putU32(uint8_t* p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static inline uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static inline uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline uint32_t recordSize(uint16_t payloadLen) {
+    return RECORD_HEADER_SIZE + payloadLen + RECORD_TRAILER_SIZE;
+}
+
+static void segPath(uint32_t id, char* buf, size_t len) {
+    snprintf(buf, len, STORE_DIR "/%08lx", (unsigned long)id);
+}
+
+static void nvsPutU32(const char* key, uint32_t value) {
+    _prefs.begin(NVS_STORE_NAMESPACE, false);
+    _prefs.putUInt(key, value);
+    _prefs.end();
+}
+
+// Print that appends to a file while accumulating the record CRC
+class CrcFileWriter : public Print {
+public:
+    explicit CrcFileWriter(File& file) : _file(file), _crc(0) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t len) override {
+        _crc = crc32Update(_crc, data, len);
+        return _file.write(data, len);
+    }
+    uint32_t crc() const { return _crc; }
+
+private:
+    File&    _file;
+    uint32_t _crc;
+};
+
+static void addAnchor(uint32_t bootId, int64_t epochMs) {
+    for (uint8_t i = 0; i < _anchorCount; i++) {
+        if (_anchors[i].bootId == bootId) return;
+    }
+    _anchors[_anchorNext] = { bootId, epochMs };
+    _anchorNext = (_anchorNext + 1) % MAX_BOOT_ANCHORS;
+    if (_anchorCount < MAX_BOOT_ANCHORS) _anchorCount++;
+}
+
+// Read and CRC-check the record at off. False at end of data or on corruption.
+static bool readRecord(File& f, uint32_t off, StoreRecord& rec) {
+    uint8_t buf[64];
+    if (!f.seek(off) || f.read(buf, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE) return false;
+    if (getU16(buf) != STORE_RECORD_MAGIC) return false;
+
+    rec.offset = off;
+    rec.length = getU16(buf + 2);
+    rec.seq    = getU32(buf + 4);
+    rec.bootId = getU32(buf + 8);
+    rec.bootMs = getU32(buf + 12);
+    if (rec.length < RECORD_PAYLOAD_MIN || rec.length > RECORD_PAYLOAD_MAX) return false;
+
+    uint32_t crc = crc32Update(0, buf, RECORD_HEADER_SIZE);
+    uint16_t remaining = rec.length;
+    bool first = true;
+    while (remaining > 0) {
+        size_t n = remaining < sizeof(buf) ? remaining : sizeof(buf);
+        if (f.read(buf, n) != n) return false;
+        if (first) {
+            rec.timestamp = getU32(buf + PAYLOAD_TS_OFFSET);
+            first = false;
+        }
+        crc = crc32Update(crc, buf, n);
+        remaining -= n;
+    }
+
+    if (f.read(buf, RECORD_TRAILER_SIZE) != RECORD_TRAILER_SIZE) return false;
+    return getU32(buf) == crc;
+}
+
+static void dropFront() {
+    char path[24];
+    segPath(_segs[0].id, path, sizeof(path));
+    LittleFS.remove(path);
+
+    _pending -= _segs[0].pending;
+    _totalBytes -= _segs[0].size;
+    for (uint8_t i = 1; i < _segCount; i++) _segs[i - 1] = _segs[i];
+    _segCount--;
+    _readOffset = _segCount ? _segs[0].start : 0;
+}
+
+// ============================================================
+//  Recovery
+// ============================================================
+static void scanSegment(Segment& seg, uint32_t& lastSeq) {
+    char path[24];
+    segPath(seg.id, path, sizeof(path));
+
+    seg.size = seg.end = seg.start = 0;
+    seg.pending = 0;
+    File f = LittleFS.open(path, "r");
+    if (!f) return;
+
+    seg.size = f.size();
+    seg.start = seg.size;
+    uint32_t off = 0;
+    StoreRecord rec;
+    while (readRecord(f, off, rec)) {
+        if (rec.seq > _ackSeq) {
+            if (seg.pending == 0) seg.start = off;
+            seg.pending++;
+        }
+        if (rec.timestamp != 0) {
+            addAnchor(rec.bootId, (int64_t)rec.timestamp * 1000 - rec.bootMs);
+        }
+        if (rec.seq > lastSeq) lastSeq = rec.seq;
+        off += recordSize(rec.length);
+    }
+    seg.end = off;
+    f.close();
+
+    if (seg.end < seg.size) {
+        Serial.printf("[STORE] %s: %lu bytes unreadable after offset %lu (torn write?)\n",
+                      path, (unsigned long)(seg.size - seg.end), (unsigned long)seg.end);
+    }
+}
+
+bool storeInit() {
+    if (_ready) return true;
+    if (!LittleFS.begin(true)) {
+        Serial.println("[STORE] LittleFS mount FAILED, store-and-forward disabled");
+        return false;
+    }
+
+    _prefs.begin(NVS_STORE_NAMESPACE, false);
+    _bootId = _prefs.getUInt("boot_id", 0) + 1;
+    _prefs.putUInt("boot_id", _bootId);
+    _ackSeq = _prefs.getUInt("ack_seq", 0);
+    _ackSeqSaved = _ackSeq;
+    _seqReserved = _prefs.getUInt("seq_rsv", 0);
+    uint32_t anchorBoot = _prefs.getUInt("anchor_boot", 0);
+    int64_t anchorMs = _prefs.getLong64("anchor_ms", 0);
+    _prefs.end();
+    if (anchorBoot != 0) addAnchor(anchorBoot, anchorMs);
+
+    if (!LittleFS.exists(STORE_DIR)) LittleFS.mkdir(STORE_DIR);
+
+    // Segment ids in ascending order (too many files: oldest are deleted)
+    File dir = LittleFS.open(STORE_DIR);
+    File entry;
+    while (dir && (entry = dir.openNextFile())) {
+        uint32_t id = strtoul(entry.name(), nullptr, 16);
+        entry.close();
+
+        uint8_t pos = _segCount;
+        while (pos > 0 && _segs[pos - 1].id > id) pos--;
+        if (_segCount == MAX_SEGMENTS) {
+            if (pos == 0) {
+                char path[24];
+                segPath(id, path, sizeof(path));
+                LittleFS.remove(path);
+                continue;
+            }
+            char path[24];
+            segPath(_segs[0].id, path, sizeof(path));
+            LittleFS.remove(path);
+            for (uint8_t i = 1; i < pos; i++) _segs[i - 1] = _segs[i];
+            pos--;
+        } else {
+            for (uint8_t i = _segCount; i > pos; i--) _segs[i] = _segs[i - 1];
+            _segCount++;
+        }
+        _segs[pos].id = id;
+    }
+    if (dir) dir.close();
+
+    uint32_t lastSeq = 0;
+    _pending = 0;
+    _totalBytes = 0;
+    for (uint8_t i = 0; i < _segCount; i++) {
+        scanSegment(_segs[i], lastSeq);
+        _pending += _segs[i].pending;
+        _totalBytes += _segs[i].size;
+    }
+
+    // Fully acknowledged segments are leftovers of an interrupted delete
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < _segCount; i++) {
+        if (_segs[i].pending == 0) {
+            char path[24];
+            segPath(_segs[i].id, path, sizeof(path));
+            LittleFS.remove(path);
+            _totalBytes -= _segs[i].size;
+        } else {
+            _segs[kept++] = _segs[i];
+        }
+    }
+    _segCount = kept;
+    _readOffset = _segCount ? _segs[0].start : 0;
+
+    // Never append after a record written by a previous boot
+    _tailSealed = true;
+
+    _nextSeq = lastSeq + 1;
+    if (_nextSeq <= _ackSeq) _nextSeq = _ackSeq + 1;
+    if (_nextSeq < _seqReserved) _nextSeq = _seqReserved;
+
+    _ready = true;
+    Serial.printf("[STORE] Boot %lu: %lu pending windows in %u segments (%lu bytes), next seq %lu\n",
+                  (unsigned long)_bootId, (unsigned long)_pending, _segCount,
+                  (unsigned long)_totalBytes, (unsigned long)_nextSeq);
+    return true;
+}
+
+// ============================================================
+//  Append
+// ============================================================
+uint32_t storeTakeSeq() {
+    if (!_ready) return 0;
+
+    // Seq numbers are reserved in blocks so they stay monotonic across
+    // reboots without an NVS write per record
+    if (_nextSeq >= _seqReserved) {
+        _seqReserved = _nextSeq + STORE_SEQ_RESERVE;
+        nvsPutU32("seq_rsv", _seqReserved);
+    }
+    return _nextSeq++;
+}
+
+bool storeAppend(const SensorWindow& window, const char* deviceId,
+                 time_t timestamp, uint32_t bootMs, uint32_t seq) {
+    if (!_ready || seq == 0) return false;
+
+    PayloadCounter counter;
+    size_t len = vitalsWriteBinary(window, deviceId, timestamp, seq, counter);
+    if (len > RECORD_PAYLOAD_MAX) return false;
+    uint32_t size = recordSize((uint16_t)len);
+
+    // Bounded capacity: the oldest data goes first
+    while (_segCount > 0 && _totalBytes + size > STORE_MAX_BYTES) {
+        Serial.printf("[STORE] Full, dropping %u oldest windows\n", _segs[0].pending);
+        dropFront();
+    }
+
+    // Rotate to a new segment
+    Segment* tail = _segCount ? &_segs[_segCount - 1] : nullptr;
+    if (!tail || _tailSealed || tail->size + size > STORE_SEGMENT_BYTES) {
+        if (_segCount == MAX_SEGMENTS) {
+            Serial.printf("[STORE] Too many segments, dropping %u oldest windows\n", _segs[0].pending);
+            dropFront();
+        }
+        tail = &_segs[_segCount++];
+        tail->id = seq;
+        tail->size = tail->end = tail->start = 0;
+        tail->pending = 0;
+        _tailSealed = false;
+        if (_segCount == 1) _readOffset = 0;
+    }
+
+    uint8_t head[RECORD_HEADER_SIZE];
+    putU16(head, STORE_RECORD_MAGIC);
+    putU16(head + 2, (uint16_t)len);
+    putU32(head + 4, seq);
+    putU32(head + 8, _bootId);
+    putU32(head + 12, bootMs);
+
+    char path[24];
+    segPath(tail->id, path, sizeof(path));
+    File f = LittleFS.open(path, FILE_APPEND);
+    if (!f) {
+        Serial.printf("[STORE] Cannot open %s\n", path);
+        _tailSealed = true;
+        return false;
+    }
+    CrcFileWriter writer(f);
+    size_t written = writer.write(head, sizeof(head));
+    written += vitalsWriteBinary(window, deviceId, timestamp, seq, writer);
+    uint8_t trailer[RECORD_TRAILER_SIZE];
+    putU32(trailer, writer.crc());
+    written += f.write(trailer, sizeof(trailer));
+    f.close();
+
+    if (written != size) {
+        // Partial record at the end of the file: never append after it
+        Serial.printf("[STORE] Append failed (%lu of %lu bytes), segment sealed\n",
+                      (unsigned long)written, (unsigned long)size);
+        tail->size += written;
+        _totalBytes += written;
+        _tailSealed = true;
+        return false;
+    }
+
+    tail->size += size;
+    tail->end += size;
+    tail->pending++;
+    _pending++;
+    _totalBytes += size;
+    return true;
+}
+
+// ============================================================
+//  Drain
+// ============================================================
+bool storeIsEmpty() {
+    return _pending == 0;
+}
+
+uint32_t storePendingCount() {
+    return _pending;
+}
+
+bool storePeek(StoreRecord& rec) {
+    while (_pending > 0 && _segCount > 0) {
+        Segment& seg = _segs[0];
+        if (seg.pending == 0) {
+            dropFront();
+            continue;
+        }
+
+        char path[24];
+        segPath(seg.id, path, sizeof(path));
+        File f = LittleFS.open(path, "r");
+        bool ok = f && _readOffset < seg.end && readRecord(f, _readOffset, rec);
+        if (f) f.close();
+        if (ok) {
+            rec.segment = seg.id;
+            return true;
+        }
+
+        Serial.printf("[STORE] Corrupt record in %s, dropping %u windows\n", path, seg.pending);
+        if (_segCount == 1) _tailSealed = true;
+        dropFront();
+    }
+    return false;
+}
+
+uint8_t storePeekMany(StoreRecord* recs, uint8_t max) {
+    if (max == 0 || !storePeek(recs[0])) return 0;
+
+    uint8_t n = 1;
+    uint8_t seg = 0;
+    uint32_t off = _readOffset + recordSize(recs[0].length);
+    File f;
+    while (n < max && seg < _segCount) {
+        if (off >= _segs[seg].end) {
+            if (f) f.close();
+            if (++seg < _segCount) off = _segs[seg].start;
+            continue;
+        }
+        if (!f) {
+            char path[24];
+            segPath(_segs[seg].id, path, sizeof(path));
+            f = LittleFS.open(path, "r");
+        }
+        // A bad record ends the batch; storePeek() drops it once it is oldest
+        if (!f || !readRecord(f, off, recs[n])) break;
+        recs[n].segment = _segs[seg].id;
+        off += recordSize(recs[n].length);
+        n++;
+    }
+    if (f) f.close();
+    return n;
+}
+
+void storeSetClock(time_t now) {
+    if (_clockNoted || now == 0 || !_ready) return;
+    _clockNoted = true;
+
+    // One NVS write per boot lets records stored before this sync be
+    // re-based even if they are only drained after a reboot
+    int64_t epochMs = (int64_t)now * 1000 - halMillis();
+    addAnchor(_bootId, epochMs);
+    _prefs.begin(NVS_STORE_NAMESPACE, false);
+    _prefs.putUInt("anchor_boot", _bootId);
+    _prefs.putLong64("anchor_ms", epochMs);
+    _prefs.end();
+}
+
+time_t storeResolveTime(const StoreRecord& rec, time_t now) {
+    if (rec.timestamp != 0) return rec.timestamp;
+    if (rec.bootId == _bootId) {
+        return now ? now - (time_t)((halMillis() - rec.bootMs) / 1000) : 0;
+    }
+    for (uint8_t i = 0; i < _anchorCount; i++) {
+        if (_anchors[i].bootId == rec.bootId) {
+            return (time_t)((_anchors[i].epochMs + rec.bootMs) / 1000);
+        }
+    }
+    return 0;
+}
+
+size_t storeWritePayload(const StoreRecord& rec, time_t ts, Print& out) {
+    char path[24];
+    segPath(rec.segment, path, sizeof(path));
+    File f = LittleFS.open(path, "r");
+    if (!f || !f.seek(rec.offset + RECORD_HEADER_SIZE)) return 0;
+
+    uint8_t buf[128];
+    size_t written = 0;
+    uint16_t remaining = rec.length;
+    bool first = true;
+    while (remaining > 0) {
+        size_t n = remaining < sizeof(buf) ? remaining : sizeof(buf);
+        if (f.read(buf, n) != n) break;
+        if (first) {
+            putU32(buf + PAYLOAD_TS_OFFSET, (uint32_t)ts);
+            first = false;
+        }
+        written += out.write(buf, n);
+        remaining -= n;
+    }
+    f.close();
+    return written;
+}
+
+void storeAck(const StoreRecord& rec) {
+    if (_segCount == 0 || _segs[0].pending == 0) return;
+    if (rec.segment != _segs[0].id || rec.offset != _readOffset) return;
+
+    _readOffset += recordSize(rec.length);
+    _segs[0].pending--;
+    _pending--;
+    _ackSeq = rec.seq;
+
+    if (_segs[0].pending == 0) {
+        if (_segCount == 1) _tailSealed = true;
+        dropFront();
+    }
+}
+
+void storeCommitAcks() {
+    if (!_ready || _ackSeq == _ackSeqSaved) return;
+    nvsPutU32("ack_seq", _ackSeq);
+    _ackSeqSaved = _ackSeq;
+}
@@ -0,0 +1,85 @@
+#ifndef WINDOW_STORE_H
+#define WINDOW_STORE_H
+
+#include <Arduino.h>
+#include "sensor_manager.h"
+
+// ============================================================
+//  Store-and-forward log of encoded windows (LittleFS)
+// ============================================================
+// Append-only segment files under STORE_DIR. Each record:
+//
+//   off  size  field (little-endian)
+//   0    2     magic STORE_RECORD_MAGIC
+//   2    2     payload length N
+//   4    4     seq (monotonic across boots)
+//   8    4     boot id (NVS counter, +1 per boot)
+//   12   4     millis() at capture
+//   16   N     payload: binary vitals record (vitals_payload.h), its
+//              timestamp is 0 if the clock was not synced at capture
+//   16+N 4     CRC-32 of bytes 0..16+N
+//
+// Segments are only ever appended to and deleted whole (no in-place
+// rewrites). A segment with a bad record is sealed and read up to it.
+// The last acknowledged seq is kept in NVS so a reboot does not resend.
+// Not thread safe: used by the DataSender task only.
+
+#define STORE_RECORD_MAGIC      0x5143      // "CQ"
+
+struct StoreRecord {
+    uint32_t seq;
+    uint32_t bootId;
+    uint32_t bootMs;        // millis() at capture
+    uint32_t timestamp;     // Unix seconds from the payload (0 = not synced)
+    uint16_t length;        // Payload bytes
+    uint32_t segment;       // Location in the log (set by storePeek)
+    uint32_t offset;
+};
+
+// Mount LittleFS, recover the log and bump the boot id.
+bool     storeInit();
+
+// Next seq for a window (0 if the store is not ready). Taken before the
+// live upload, so a window stored after a failed one keeps the seq the
+// server may already have.
+uint32_t storeTakeSeq();
+
+// Append one window (binary encoding) under seq from storeTakeSeq(), in
+// increasing seq order. Drops the oldest segment when the log would exceed
+// STORE_MAX_BYTES.
+bool     storeAppend(const SensorWindow& window, const char* deviceId,
+                     time_t timestamp, uint32_t bootMs, uint32_t seq);
+
+bool     storeIsEmpty();
+uint32_t storePendingCount();
+
+// Oldest unacknowledged record (CRC checked). Corrupt records are skipped.
+bool     storePeek(StoreRecord& rec);
+
+// Up to max oldest records in order, without removing them (for a batch
+// upload). Returns the count; acknowledge them one by one with storeAck().
+uint8_t  storePeekMany(StoreRecord* recs, uint8_t max);
+
+// Report the synced wall clock. The first call per boot persists this
+// boot's epoch so its unsynced records can be re-based after a reboot.
+void     storeSetClock(time_t now);
+
+// Capture time of rec in Unix seconds, re-based from its boot-relative
+// millis when it was stored before NTP sync. now = current synced time
+// (0 if unknown). Returns 0 when the record cannot be placed in time.
+time_t   storeResolveTime(const StoreRecord& rec, time_t now);
+
+// Stream rec's payload to out with its timestamp replaced by ts.
+// Returns bytes written (rec.length on success).
+size_t   storeWritePayload(const StoreRecord& rec, time_t ts, Print& out);
+
+// Remove the oldest record (after upload, or when it is being dropped).
+// Ignored unless rec is the oldest record. Held in RAM until
+// storeCommitAcks(); a reboot before that resends those records.
+void     storeAck(const StoreRecord& rec);
+
+// Persist the last acknowledged seq: one NVS write per drained batch
+// instead of one per record. No-op when nothing was acknowledged.
+void     storeCommitAcks();
+
+#endif // WINDOW_STORE_H
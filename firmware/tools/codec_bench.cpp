@@ -0,0 +1,143 @@
+// Host benchmark for the ECG codec (src/ecg_codec.cpp).
+//
+// Build and run from firmware/:
+//   g++ -O2 -Isrc tools/codec_bench.cpp src/ecg_codec.cpp -o codec_bench
+//   ./codec_bench [--window N] [--dump out.bin] recording.txt ...
+//
+// Each recording is a text file of integer ADC samples separated by
+// whitespace or commas (e.g. the ecg_samples array of stored windows). It is
+// cut into windows of N samples (default 2500 = 10s @ 250Hz), every window is
+// encoded, decoded and compared, and the size and speed are reported.
+// --dump writes every window for backend/app/services/ecg_codec.py to verify.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ecg_codec.h"
+
+static bool loadSamples(const char* path, std::vector<uint16_t>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    int c;
+    long value = -1;
+    while ((c = fgetc(f)) != EOF) {
+        if (c >= '0' && c <= '9') {
+            value = (value < 0 ? 0 : value * 10) + (c - '0');
+        } else if (value >= 0) {
+            out.push_back((uint16_t)value);
+            value = -1;
+        }
+    }
+    if (value >= 0) out.push_back((uint16_t)value);
+    fclose(f);
+    return true;
+}
+
+static void putU16(FILE* f, uint16_t v) {
+    uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+    fwrite(b, 1, 2, f);
+}
+
+int main(int argc, char** argv) {
+    size_t window = 2500;
+    const char* dumpPath = nullptr;
+    std::vector<const char*> files;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--window") && i + 1 < argc) {
+            window = (size_t)atoi(argv[++i]);
+        } else if (!strcmp(argv[i], "--dump") && i + 1 < argc) {
+            dumpPath = argv[++i];
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty() || window == 0 || window > 65535) {
+        fprintf(stderr, "usage: %s [--window N] [--dump out.bin] recording.txt ...\n", argv[0]);
+        return 2;
+    }
+
+    FILE* dump = dumpPath ? fopen(dumpPath, "wb") : nullptr;
+    if (dumpPath && !dump) {
+        fprintf(stderr, "cannot open %s\n", dumpPath);
+        return 2;
+    }
+
+    // Worst case: an escape on every residual plus a 4-bit k per block
+    std::vector<uint8_t> frame(window * 5 + 16);
+    std::vector<uint16_t> decoded(window);
+    size_t totalSamples = 0, totalBytes = 0, windows = 0;
+    double totalEncodeUs = 0.0;
+    int failures = 0;
+
+    printf("%-32s %8s %8s %9s %9s %10s\n",
+           "recording", "windows", "bits/smp", "vs 16bit", "vs 12bit", "enc us/smp");
+
+    for (const char* path : files) {
+        std::vector<uint16_t> samples;
+        if (!loadSamples(path, samples)) {
+            fprintf(stderr, "cannot read %s\n", path);
+            return 2;
+        }
+
+        size_t fileSamples = 0, fileBytes = 0, fileWindows = 0;
+        double fileUs = 0.0;
+        for (size_t off = 0; off + window <= samples.size(); off += window) {
+            const uint16_t* w = &samples[off];
+            EcgRiceEncoder enc;
+
+            // Repeat short encodes so the timer resolution does not dominate
+            const int reps = 20;
+            size_t len = 0;
+            auto t0 = std::chrono::steady_clock::now();
+            for (int r = 0; r < reps; r++) {
+                enc.begin(frame.data(), frame.size());
+                enc.encode(w, (uint16_t)window);
+                len = enc.finish();
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            fileUs += std::chrono::duration<double, std::micro>(t1 - t0).count() / reps;
+
+            if (!ecgCodecDecode(frame.data(), len, decoded.data(), (uint16_t)window) ||
+                memcmp(decoded.data(), w, window * sizeof(uint16_t)) != 0) {
+                fprintf(stderr, "%s: window %zu does not round-trip\n", path, fileWindows);
+                failures++;
+            }
+
+            if (dump) {
+                putU16(dump, (uint16_t)window);
+                for (size_t i = 0; i < window; i++) putU16(dump, w[i]);
+                putU16(dump, (uint16_t)len);
+                fwrite(frame.data(), 1, len, dump);
+            }
+
+            fileSamples += window;
+            fileBytes += len;
+            fileWindows++;
+        }
+
+        if (fileWindows == 0) {
+            printf("%-32s shorter than one window\n", path);
+            continue;
+        }
+        double bits = 8.0 * fileBytes / fileSamples;
+        printf("%-32s %8zu %8.2f %8.2fx %8.2fx %10.3f\n", path, fileWindows, bits,
+               16.0 / bits, 12.0 / bits, fileUs / fileSamples);
+
+        totalSamples += fileSamples;
+        totalBytes += fileBytes;
+        totalEncodeUs += fileUs;
+        windows += fileWindows;
+    }
+
+    if (dump) fclose(dump);
+    if (windows > 0) {
+        double bits = 8.0 * totalBytes / totalSamples;
+        printf("%-32s %8zu %8.2f %8.2fx %8.2fx %10.3f\n", "TOTAL", windows, bits,
+               16.0 / bits, 12.0 / bits, totalEncodeUs / totalSamples);
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+// Host accuracy/latency check for the on-device ECG CNN (src/ecg_cnn.cpp).
+//
+// Export, then build and run from firmware/:
+//   (cd ../ml && python3 src/distill_tiny_cnn.py)      # or src/tiny_ecg_cnn.py --weights ...
+//   g++ -O2 -Isrc tools/ecg_cnn_check.cpp src/ecg_cnn.cpp -o ecg_cnn_check
+//   ./ecg_cnn_check [--tolerance T] [--skip-below S] [tools/ecg_cnn_vectors.bin]
+//
+// The vectors file is written by the exporter: test windows as the device
+// uploads them (2500 ADC counts at 250Hz) with their label, the ECGFounder
+// (teacher) probability and the host float and int8 reference
+// probabilities. Every window is scored by the firmware code and compared
+// with the int8 reference (exit status 1 above the tolerance). The report
+// gives the AUC of each model, agreement with the teacher, the share of
+// windows a server skip threshold would screen out and the abnormal ones
+// among them, and the time per window on this host.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "ecg_cnn.h"
+
+struct Vector {
+    std::vector<uint16_t> samples;
+    int label;
+    float teacher, floatRef, int8Ref;
+};
+
+static bool loadVectors(const char* path, std::vector<Vector>& out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    char magic[4];
+    uint32_t count = 0;
+    uint16_t length = 0;
+    bool ok = fread(magic, 1, 4, f) == 4 && !memcmp(magic, "ECNN", 4)
+              && fread(&count, 4, 1, f) == 1 && fread(&length, 2, 1, f) == 1;
+    for (uint32_t i = 0; ok && i < count; i++) {
+        Vector v;
+        v.samples.resize(length);
+        uint8_t label;
+        float probs[3];
+        ok = fread(v.samples.data(), 2, length, f) == length
+             && fread(&label, 1, 1, f) == 1 && fread(probs, 4, 3, f) == 3;
+        v.label = label;
+        v.teacher = probs[0];
+        v.floatRef = probs[1];
+        v.int8Ref = probs[2];
+        if (ok) out.push_back(v);
+    }
+    fclose(f);
+    return ok;
+}
+
+// Area under the ROC curve (Mann-Whitney U, ties count half); NaN scores skipped
+static double auc(const std::vector<Vector>& vectors, const std::vector<float>& scores) {
+    std::vector<std::pair<float, int>> s;
+    for (size_t i = 0; i < vectors.size(); i++) {
+        if (!std::isnan(scores[i])) s.push_back(std::make_pair(scores[i], vectors[i].label));
+    }
+    std::sort(s.begin(), s.end());
+    double pos = 0, neg = 0, rankSum = 0;
+    for (size_t i = 0; i < s.size();) {
+        size_t j = i;
+        while (j < s.size() && s[j].first == s[i].first) j++;
+        double rank = (i + j + 1) / 2.0;        // Average 1-based rank of the tie group
+        for (size_t k = i; k < j; k++) {
+            if (s[k].second) {
+                pos++;
+                rankSum += rank;
+            } else {
+                neg++;
+            }
+        }
+        i = j;
+    }
+    if (pos == 0 || neg == 0) return NAN;
+    return (rankSum - pos * (pos + 1) / 2) / (pos * neg);
+}
+
+int main(int argc, char** argv) {
+    const char* path = "tools/ecg_cnn_vectors.bin";
+    double tolerance = 1e-5;
+    double skipBelow = 0.1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--skip-below") && i + 1 < argc) skipBelow = atof(argv[++i]);
+        else path = argv[i];
+    }
+
+    if (!ecgCnnAvailable()) {
+        fprintf(stderr, "No src/ecg_cnn_data.h: run ml/src/distill_tiny_cnn.py first\n");
+        return 1;
+    }
+
+    std::vector<Vector> vectors;
+    if (!loadVectors(path, vectors) || vectors.empty()) {
+        fprintf(stderr, "Cannot read vectors from %s\n", path);
+        return 1;
+    }
+
+    std::vector<float> scores(vectors.size(), NAN);
+    auto t0 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < vectors.size(); i++) {
+        if (!ecgCnnScore(vectors[i].samples.data(), (uint16_t)vectors[i].samples.size(), scores[i])) {
+            fprintf(stderr, "Window %zu not scored (length %zu)\n", i, vectors[i].samples.size());
+            return 1;
+        }
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count()
+                / vectors.size();
+
+    std::vector<float> teacher, floatRef, int8Ref;
+    double maxDiff = 0.0, maxFloatDiff = 0.0;
+    size_t worst = 0, failed = 0, agree = 0, teacherCount = 0, skipped = 0, skippedAbnormal = 0, abnormal = 0;
+    for (size_t i = 0; i < vectors.size(); i++) {
+        const Vector& v = vectors[i];
+        teacher.push_back(v.teacher);
+        floatRef.push_back(v.floatRef);
+        int8Ref.push_back(v.int8Ref);
+
+        double diff = fabs((double)scores[i] - v.int8Ref);
+        if (diff > maxDiff) {
+            maxDiff = diff;
+            worst = i;
+        }
+        if (diff > tolerance) failed++;
+        maxFloatDiff = std::max(maxFloatDiff, fabs((double)scores[i] - v.floatRef));
+        if (!std::isnan(v.teacher)) {
+            teacherCount++;
+            if ((scores[i] > 0.5f) == (v.teacher > 0.5f)) agree++;
+        }
+        abnormal += v.label;
+        if (scores[i] < skipBelow) {
+            skipped++;
+            skippedAbnormal += v.label;
+        }
+    }
+
+    printf("%zu windows: max |diff| vs int8 reference %.2e (window %zu: %.6f vs %.6f), %zu above %.0e\n",
+           vectors.size(), maxDiff, worst, scores[worst], vectors[worst].int8Ref, failed, tolerance);
+    printf("max |diff| vs float model %.4f\n", maxFloatDiff);
+    printf("AUC: teacher %.4f, float %.4f, int8 reference %.4f, firmware %.4f\n",
+           auc(vectors, teacher), auc(vectors, floatRef), auc(vectors, int8Ref), auc(vectors, scores));
+    if (teacherCount) printf("label agreement with the teacher: %.1f%%\n", 100.0 * agree / teacherCount);
+    printf("score < %.2f: %.1f%% of windows skip ECGFounder, %zu of %zu abnormal among them\n",
+           skipBelow, 100.0 * skipped / vectors.size(), skippedAbnormal, abnormal);
+    printf("%.1f us per window on this host\n", us);
+    return failed ? 1 : 0;
+}
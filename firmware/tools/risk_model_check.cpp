@@ -0,0 +1,101 @@
+// Host check for the on-device risk model (src/risk_model.cpp) against the
+// Python XGBoost model it was exported from.
+//
+// Export, then build and run from firmware/:
+//   (cd ../ml && python3 src/export_xgboost_c.py)
+//   g++ -O2 -Iinclude -Isrc -Isrc/native/include tools/risk_model_check.cpp src/risk_model.cpp -o risk_model_check
+//   ./risk_model_check [--tolerance T] [tools/risk_model_vectors.csv]
+//
+// The vectors file is written by the exporter: one feature vector per line
+// ("nan" = missing) followed by XGBClassifier.predict_proba()[:, 1]. Every
+// vector is scored, the largest difference and the time per inference are
+// reported, and the exit status is 1 if any difference exceeds the tolerance.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "risk_model.h"
+
+struct Vector {
+    float features[RF_COUNT];
+    float probability;
+};
+
+static bool loadVectors(const char* path, std::vector<Vector>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[4096];
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') continue;
+        Vector v;
+        char* p = line;
+        int n = 0;
+        for (; n <= RF_COUNT && *p; n++) {
+            char* end;
+            float x = strtof(p, &end);      // Also parses "nan"
+            if (end == p) break;
+            if (n < RF_COUNT) v.features[n] = x;
+            else v.probability = x;
+            p = *end == ',' ? end + 1 : end;
+        }
+        if (n != RF_COUNT + 1) {
+            fprintf(stderr, "Bad vector (%d values, expected %d): %s", n, RF_COUNT + 1, line);
+            fclose(f);
+            return false;
+        }
+        out.push_back(v);
+    }
+    fclose(f);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* path = "tools/risk_model_vectors.csv";
+    double tolerance = 1e-5;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--tolerance") && i + 1 < argc) tolerance = atof(argv[++i]);
+        else path = argv[i];
+    }
+
+    if (!riskModelAvailable()) {
+        fprintf(stderr, "No src/risk_model_data.h: run ml/src/export_xgboost_c.py first\n");
+        return 1;
+    }
+
+    std::vector<Vector> vectors;
+    if (!loadVectors(path, vectors) || vectors.empty()) {
+        fprintf(stderr, "Cannot read vectors from %s\n", path);
+        return 1;
+    }
+
+    std::vector<float> scores(vectors.size());
+    auto t0 = std::chrono::steady_clock::now();
+    const int repeat = 20;
+    for (int r = 0; r < repeat; r++) {
+        for (size_t i = 0; i < vectors.size(); i++) scores[i] = riskModelScore(vectors[i].features);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count()
+                / (repeat * vectors.size());
+
+    double maxDiff = 0.0;
+    size_t worst = 0, failed = 0, labelMismatch = 0;
+    for (size_t i = 0; i < vectors.size(); i++) {
+        double diff = fabs((double)scores[i] - vectors[i].probability);
+        if (diff > maxDiff) {
+            maxDiff = diff;
+            worst = i;
+        }
+        if (diff > tolerance) failed++;
+        if (strcmp(riskModelLabel(scores[i]), riskModelLabel(vectors[i].probability))) labelMismatch++;
+    }
+
+    printf("%zu vectors: max |diff| %.2e (vector %zu: %.6f vs %.6f), %zu above %.0e, %zu labels differ\n",
+           vectors.size(), maxDiff, worst, scores[worst], vectors[worst].probability,
+           failed, tolerance, labelMismatch);
+    printf("%.2f us per inference on this host\n", us);
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,151 @@
+// Host two-thread stress test for SpscRing (include/spsc_ring.h).
+//
+// Build and run from firmware/:
+//   g++ -std=gnu++11 -O2 -pthread -Iinclude tools/spsc_ring_stress.cpp -o spsc_ring_stress
+//   ./spsc_ring_stress [items]
+// For the memory ordering, also under ThreadSanitizer:
+//   g++ -std=gnu++11 -O1 -g -fsanitize=thread -pthread -Iinclude tools/spsc_ring_stress.cpp -o spsc_ring_stress_tsan
+//
+// One producer thread and one consumer thread move a numbered sequence
+// through small rings, mixing single and batch push/pop of random sizes so
+// the indices wrap constantly and batches straddle the end of the buffer.
+// Every item carries its number, its complement and a checksum. The
+// consumer checks that each item arrives intact, exactly once and in
+// order (exit status 1 otherwise). The report gives the throughput of each
+// ring.
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "spsc_ring.h"
+
+// Wide enough that a torn copy shows up as a field mismatch
+struct Item {
+    uint32_t seq;
+    uint32_t inverse;
+    uint64_t check;
+};
+
+static Item makeItem(uint32_t seq) {
+    Item item;
+    item.seq = seq;
+    item.inverse = ~seq;
+    item.check = (uint64_t)seq * 0x9E3779B97F4A7C15ULL;
+    return item;
+}
+
+// Small xorshift per thread: batch sizes and single/batch choice
+struct Rng {
+    uint32_t state;
+    explicit Rng(uint32_t seed) : state(seed) {}
+    uint32_t next() {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+};
+
+// Spin briefly, then sleep: on a single core yield() alone can starve the other side
+static void backOff(uint32_t& misses) {
+    if (++misses < 64) {
+        std::this_thread::yield();
+    } else {
+        misses = 0;
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+}
+
+template <size_t N>
+static bool run(uint32_t total) {
+    static SpscRing<Item, N> ring;
+    const size_t maxBatch = N + N / 2;     // Larger than the ring: partial batches too
+    std::atomic<bool> failed(false);
+    uint64_t fullPushes = 0, emptyPops = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+
+    std::thread producer([&]() {
+        Rng rng(0x1234567u + N);
+        Item batch[N + N / 2];
+        uint32_t seq = 0, misses = 0;
+        while (seq < total && !failed.load(std::memory_order_relaxed)) {
+            if (rng.next() & 1) {
+                if (ring.push(makeItem(seq))) {
+                    seq++;
+                } else {
+                    fullPushes++;
+                    backOff(misses);
+                }
+            } else {
+                size_t want = 1 + rng.next() % maxBatch;
+                if (want > total - seq) want = total - seq;
+                for (size_t i = 0; i < want; i++) batch[i] = makeItem(seq + (uint32_t)i);
+                size_t pushed = ring.push(batch, want);
+                if (pushed == 0) {
+                    fullPushes++;
+                    backOff(misses);
+                }
+                seq += (uint32_t)pushed;
+            }
+        }
+    });
+
+    std::thread consumer([&]() {
+        Rng rng(0x7654321u + N);
+        Item batch[N + N / 2];
+        uint32_t expected = 0, misses = 0;
+        while (expected < total && !failed.load(std::memory_order_relaxed)) {
+            size_t got;
+            if (rng.next() & 1) {
+                got = ring.pop(batch[0]) ? 1 : 0;
+            } else {
+                got = ring.pop(batch, 1 + rng.next() % maxBatch);
+            }
+            if (got == 0) {
+                emptyPops++;
+                backOff(misses);
+                continue;
+            }
+            if (ring.size() > N) {
+                fprintf(stderr, "N=%zu: size() %zu above capacity\n", N, ring.size());
+                failed = true;
+            }
+            for (size_t i = 0; i < got; i++) {
+                const Item& item = batch[i];
+                Item want = makeItem(expected);
+                if (item.seq != want.seq || item.inverse != want.inverse || item.check != want.check) {
+                    fprintf(stderr, "N=%zu: expected item %u, got seq %u inverse %08x check %016llx\n",
+                            N, expected, item.seq, item.inverse, (unsigned long long)item.check);
+                    failed = true;
+                    break;
+                }
+                expected++;
+            }
+        }
+    });
+
+    producer.join();
+    consumer.join();
+    double s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    bool ok = !failed && ring.empty();
+    printf("N=%-4zu %s: %u items in %.2fs (%.1f M items/s), %llu full pushes, %llu empty pops\n",
+           N, ok ? "ok  " : "FAIL", total, s, total / s / 1e6,
+           (unsigned long long)fullPushes, (unsigned long long)emptyPops);
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    uint32_t total = argc > 1 ? (uint32_t)strtoul(argv[1], nullptr, 10) : 5000000u;
+
+    bool ok = true;
+    ok &= run<2>(total / 4);
+    ok &= run<4>(total);
+    ok &= run<16>(total);
+    ok &= run<128>(total);
+    return ok ? 0 : 1;
+}
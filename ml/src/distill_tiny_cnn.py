@@ -0,0 +1,201 @@
+"""
+Distill the fine-tuned ECGFounder into the tiny on-device CNN (tiny_ecg_cnn.py).
+
+The teacher sees PTB-XL Lead II at 500Hz as in finetune_ecgfounder.py. The
+student sees the same 10 s as the device would upload it: 2500 ADC counts
+at 250Hz, z-scored. Loss: BCE against the teacher's probability blended with
+BCE against the label. The best validation AUC is quantized to int8 and
+exported to the firmware with test vectors.
+
+Usage:
+    cd ml/
+    python3 src/distill_tiny_cnn.py                 # needs models/ecgfounder_best.pt
+"""
+
+import os
+import sys
+import numpy as np
+import torch
+import torch.nn as nn
+from torch.utils.data import DataLoader, TensorDataset
+from sklearn.metrics import roc_auc_score
+
+sys.path.insert(0, os.path.dirname(__file__))
+from finetune_ecgfounder import build_model  # noqa: E402
+import tiny_ecg_cnn as tiny  # noqa: E402
+
+# data_loader z-scores each record; rescale to a typical Lead II amplitude
+# before converting to ADC counts so clipping and rounding match the device
+LEAD_II_STD_MV = 0.25
+
+
+class TinyEcgCnn(nn.Module):
+    """Float twin of firmware/src/ecg_cnn.cpp, layers from tiny.CONV_LAYERS."""
+
+    def __init__(self):
+        super().__init__()
+        layers = []
+        in_ch = 1
+        for out_ch, kernel, stride in tiny.CONV_LAYERS:
+            layers += [nn.Conv1d(in_ch, out_ch, kernel, stride=stride, padding=kernel // 2), nn.ReLU()]
+            in_ch = out_ch
+        self.features = nn.Sequential(*layers)
+        self.fc = nn.Linear(in_ch, 1)
+
+    def forward(self, x):
+        return self.fc(self.features(x).mean(dim=2))
+
+    def numpy_weights(self) -> dict:
+        weights = {}
+        convs = [m for m in self.features if isinstance(m, nn.Conv1d)]
+        for i, conv in enumerate(convs):
+            weights[f"conv{i}_w"] = conv.weight.detach().cpu().numpy().astype(np.float32)
+            weights[f"conv{i}_b"] = conv.bias.detach().cpu().numpy().astype(np.float32)
+        weights["fc_w"] = self.fc.weight.detach().cpu().numpy().astype(np.float32)
+        weights["fc_b"] = self.fc.bias.detach().cpu().numpy().astype(np.float32)
+        return weights
+
+
+def device_windows(X: np.ndarray) -> np.ndarray:
+    """(N, 1, 5000) z-scored 500Hz -> (N, 2500) uint16 device windows"""
+    return np.stack([tiny.to_device_window(x.flatten() * LEAD_II_STD_MV) for x in X])
+
+
+def student_inputs(windows: np.ndarray) -> torch.Tensor:
+    return torch.FloatTensor(np.stack([tiny.normalize(w) for w in windows])).unsqueeze(1)
+
+
+@torch.no_grad()
+def teacher_probs(model, X: np.ndarray, device, batch_size: int = 64) -> np.ndarray:
+    model.eval()
+    probs = []
+    for i in range(0, len(X), batch_size):
+        batch = torch.FloatTensor(X[i:i + batch_size]).to(device)
+        probs.append(torch.sigmoid(model(batch)).cpu().numpy().flatten())
+    return np.concatenate(probs)
+
+
+@torch.no_grad()
+def student_probs(model, inputs: torch.Tensor, device, batch_size: int = 256) -> np.ndarray:
+    model.eval()
+    probs = []
+    for i in range(0, len(inputs), batch_size):
+        probs.append(torch.sigmoid(model(inputs[i:i + batch_size].to(device))).cpu().numpy().flatten())
+    return np.concatenate(probs)
+
+
+def distill(data_path: str = None, output_dir: str = "models", epochs: int = 40,
+            batch_size: int = 128, lr: float = 2e-3, alpha: float = 0.7,
+            calibration_count: int = 200, vector_count: int = 500):
+    if torch.cuda.is_available():
+        device = torch.device("cuda:0")
+    elif hasattr(torch.backends, "mps") and torch.backends.mps.is_available():
+        device = torch.device("mps")
+    else:
+        device = torch.device("cpu")
+    print(f"[DISTILL] Using device: {device}")
+
+    if data_path is None:
+        data_path = os.path.join(os.path.dirname(__file__), "..", "data", "processed", "ptbxl_500hz.npz")
+    data = np.load(data_path)
+    splits = {name: (data[f"X_{name}"], data[f"y_{name}"]) for name in ("train", "val", "test")}
+
+    # Teacher probabilities
+    teacher = build_model(n_classes=1, device=device)
+    teacher.load_state_dict(torch.load(os.path.join(output_dir, "ecgfounder_best.pt"), map_location=device))
+    soft = {}
+    for name, (X, _) in splits.items():
+        soft[name] = teacher_probs(teacher, X, device)
+        print(f"[TEACHER] {name}: {len(X)} windows")
+    del teacher
+
+    windows = {name: device_windows(X) for name, (X, _) in splits.items()}
+    inputs = {name: student_inputs(w) for name, w in windows.items()}
+
+    y_train = splits["train"][1]
+    pw = float((y_train == 0).sum()) / max(float((y_train == 1).sum()), 1)
+    hard_loss = nn.BCEWithLogitsLoss(pos_weight=torch.tensor([pw], device=device))
+    soft_loss = nn.BCEWithLogitsLoss()
+
+    train_ds = TensorDataset(inputs["train"], torch.FloatTensor(soft["train"]).unsqueeze(1),
+                             torch.FloatTensor(y_train).unsqueeze(1))
+    train_loader = DataLoader(train_ds, batch_size=batch_size, shuffle=True, num_workers=0)
+
+    model = TinyEcgCnn().to(device)
+    n_params = sum(p.numel() for p in model.parameters())
+    print(f"[DISTILL] Student: {n_params} parameters, teacher weight {alpha}")
+    optimizer = torch.optim.Adam(model.parameters(), lr=lr, weight_decay=1e-4)
+    scheduler = torch.optim.lr_scheduler.CosineAnnealingLR(optimizer, T_max=epochs)
+
+    best_auc = 0
+    best_path = os.path.join(output_dir, "tiny_ecg_cnn_best.pt")
+    for epoch in range(epochs):
+        model.train()
+        total_loss = 0
+        for x, p, y in train_loader:
+            x, p, y = x.to(device), p.to(device), y.to(device)
+            optimizer.zero_grad()
+            logits = model(x)
+            loss = alpha * soft_loss(logits, p) + (1 - alpha) * hard_loss(logits, y)
+            loss.backward()
+            optimizer.step()
+            total_loss += loss.item() * len(y)
+        scheduler.step()
+
+        val_probs = student_probs(model, inputs["val"], device)
+        val_auc = roc_auc_score(splits["val"][1], val_probs)
+        agree = np.mean((val_probs > 0.5) == (soft["val"] > 0.5)) * 100
+        print(f"  Epoch {epoch + 1}/{epochs}: loss={total_loss / len(train_ds):.4f} "
+              f"val_auc={val_auc:.4f} teacher_agreement={agree:.1f}%")
+        if val_auc > best_auc:
+            best_auc = val_auc
+            torch.save(model.state_dict(), best_path)
+
+    model.load_state_dict(torch.load(best_path, map_location=device))
+    weights = model.numpy_weights()
+
+    # Quantize and export; the test vectors are a fixed random subset
+    rng = np.random.default_rng(42)
+    calibration = windows["train"][rng.choice(len(windows["train"]), calibration_count, replace=False)]
+    pick = rng.choice(len(windows["test"]), min(vector_count, len(windows["test"])), replace=False)
+    test_windows = windows["test"][pick]
+    test_labels = splits["test"][1][pick]
+    test_teacher = soft["test"][pick]
+
+    weights_path = os.path.join(output_dir, "tiny_ecg_cnn.npz")
+    np.savez(weights_path, **weights, calibration=calibration, test_windows=test_windows,
+             test_labels=test_labels, test_teacher=test_teacher)
+    probs = tiny.export(weights, list(calibration), list(test_windows), test_labels, test_teacher,
+                        source=os.path.basename(weights_path))
+
+    print("\n[TEST] AUC on the exported test windows:")
+    print(f"  ECGFounder (teacher): {roc_auc_score(test_labels, test_teacher):.4f}")
+    print(f"  Tiny CNN (float):     {roc_auc_score(test_labels, probs['float']):.4f}")
+    print(f"  Tiny CNN (int8):      {roc_auc_score(test_labels, probs['int8']):.4f}")
+
+    test_all = student_probs(model, inputs["test"], device)
+    np.savez(os.path.join(output_dir, "tiny_ecg_cnn_test_preds.npz"),
+             preds=test_all, labels=splits["test"][1], teacher=soft["test"])
+    print(f"\n[DONE] Float weights saved to {weights_path}")
+    return best_auc
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--data", default=None, help="Path to ptbxl_500hz.npz")
+    parser.add_argument("--output", default="models", help="Directory with ecgfounder_best.pt")
+    parser.add_argument("--epochs", type=int, default=40)
+    parser.add_argument("--batch-size", type=int, default=128)
+    parser.add_argument("--lr", type=float, default=2e-3)
+    parser.add_argument("--alpha", type=float, default=0.7, help="Weight of the teacher loss")
+    args = parser.parse_args()
+
+    distill(
+        data_path=args.data,
+        output_dir=args.output,
+        epochs=args.epochs,
+        batch_size=args.batch_size,
+        lr=args.lr,
+        alpha=args.alpha,
+    )
@@ -0,0 +1,232 @@
+"""
+Export the XGBoost risk model to C++ for on-device inference.
+
+Writes firmware/src/risk_model_data.h: every tree flattened into one node
+array in flash, children of a split stored next to each other, evaluated by
+firmware/src/risk_model.cpp. Also writes test vectors with the Python
+model's probabilities for firmware/tools/risk_model_check.cpp.
+
+Usage:
+    cd ml/
+    python3 src/export_xgboost_c.py                       # backend/ml_models/xgboost_cardiac.joblib
+    python3 src/export_xgboost_c.py --model models/xgboost_cardiac.joblib \
+        --test-set models/xgboost_test_preds.npz
+"""
+
+import json
+import os
+import sys
+
+import numpy as np
+
+sys.path.insert(0, os.path.dirname(__file__))
+from feature_extractor import FEATURE_NAMES  # noqa: E402
+
+ROOT = os.path.join(os.path.dirname(__file__), "..", "..")
+DEFAULT_MODEL = os.path.join(ROOT, "backend", "ml_models", "xgboost_cardiac.joblib")
+DEFAULT_HEADER = os.path.join(ROOT, "firmware", "src", "risk_model_data.h")
+DEFAULT_VECTORS = os.path.join(ROOT, "firmware", "tools", "risk_model_vectors.csv")
+
+# Node layout limits of risk_model.h (uint8 feature, uint16 child offset)
+MAX_FEATURES = 127
+MAX_TREE_NODES = 65535
+
+
+def load_booster(path: str):
+    """XGBClassifier (joblib) or Booster (.json / .ubj) -> xgboost.Booster"""
+    import xgboost as xgb
+
+    if path.endswith(".joblib") or path.endswith(".pkl"):
+        import joblib
+        return joblib.load(path).get_booster()
+    booster = xgb.Booster()
+    booster.load_model(path)
+    return booster
+
+
+def booster_trees(booster) -> tuple:
+    """Trees used by predict() and the base margin, from the JSON model."""
+    model = json.loads(booster.save_raw(raw_format="json"))
+    learner = model["learner"]
+    objective = learner["objective"]["name"]
+    if objective != "binary:logistic":
+        raise ValueError(f"unsupported objective {objective}")
+
+    trees = learner["gradient_booster"]["model"]["trees"]
+    # Early stopping: predict() stops after the best iteration
+    best = learner.get("attributes", {}).get("best_iteration")
+    if best is not None:
+        trees = trees[:int(best) + 1]
+
+    for tree in trees:
+        if any(tree.get("split_type", [])):
+            raise ValueError("categorical splits are not supported")
+
+    # Probability for binary:logistic ("[5E-1]" from XGBoost 3)
+    base_score = float(str(learner["learner_model_param"]["base_score"]).strip("[]"))
+    base_margin = float(np.log(base_score / (1.0 - base_score)))
+    return trees, base_margin
+
+
+def flatten_tree(tree: dict) -> list:
+    """Breadth-first node list; the right child always follows the left.
+
+    Each node is (feature, default_left, value, child): feature -1 marks a
+    leaf holding value, otherwise go to child if x < value (or missing and
+    default_left), else to child + 1.
+    """
+    left = tree["left_children"]
+    right = tree["right_children"]
+    feature = tree["split_indices"]
+    cond = tree["split_conditions"]
+    default_left = tree["default_left"]
+
+    nodes = []
+    order = [0]                     # XGBoost node ids in output order
+    for nid in order:
+        if left[nid] == -1:
+            nodes.append((-1, 0, float(cond[nid]), 0))
+        else:
+            nodes.append((int(feature[nid]), int(default_left[nid]), float(cond[nid]), len(order)))
+            order += [left[nid], right[nid]]
+    return nodes
+
+
+def c_float(v: float) -> str:
+    """float32 literal that round-trips exactly"""
+    f = np.float32(v)
+    text = np.format_float_positional(f, unique=True, trim="0") \
+        if abs(f) >= 1e-4 or f == 0 else np.format_float_scientific(f, unique=True)
+    if "." not in text and "e" not in text:
+        text += ".0"
+    return text + "f"
+
+
+def write_header(path: str, trees: list, base_margin: float, source: str) -> int:
+    flat = [flatten_tree(t) for t in trees]
+    n_features = len(FEATURE_NAMES)
+    if n_features > MAX_FEATURES:
+        raise ValueError("too many features for the node layout")
+
+    roots = []
+    nodes = []
+    for tree in flat:
+        if len(tree) > MAX_TREE_NODES:
+            raise ValueError("tree too large for the node layout")
+        for feat, _, _, _ in tree:
+            if feat >= n_features:
+                raise ValueError(f"split on feature {feat}, model has {n_features}")
+        roots.append(len(nodes))
+        nodes.extend(tree)
+
+    lines = [
+        "// Generated by ml/src/export_xgboost_c.py - do not edit.",
+        f"// Source: {os.path.basename(source)}, {len(flat)} trees, {len(nodes)} nodes",
+        "#ifndef RISK_MODEL_DATA_H",
+        "#define RISK_MODEL_DATA_H",
+        "",
+        '#include "risk_model.h"',
+        "",
+        f"#define RISK_MODEL_FEATURE_COUNT    {n_features}",
+        f"#define RISK_MODEL_TREE_COUNT       {len(flat)}",
+        f"#define RISK_MODEL_NODE_COUNT       {len(nodes)}",
+        f"#define RISK_MODEL_BASE_MARGIN      {c_float(base_margin)}",
+        "",
+        "// Training order (feature_extractor.FEATURE_NAMES)",
+        "static const char* const RISK_MODEL_FEATURE_NAMES[RISK_MODEL_FEATURE_COUNT] = {",
+    ]
+    lines += [f'    "{name}",' for name in FEATURE_NAMES]
+    lines += [
+        "};",
+        "",
+        "static const uint32_t RISK_MODEL_ROOTS[RISK_MODEL_TREE_COUNT] = {",
+    ]
+    for i in range(0, len(roots), 8):
+        lines.append("    " + " ".join(f"{r}," for r in roots[i:i + 8]))
+    lines += [
+        "};",
+        "",
+        "// {value, feature (RISK_NODE_LEAF for leaves), flags, child offset from the root}",
+        "static const RiskNode RISK_MODEL_NODES[RISK_MODEL_NODE_COUNT] = {",
+    ]
+    for tree in flat:
+        for feat, dleft, value, child in tree:
+            if feat < 0:
+                lines.append(f"    {{{c_float(value)}, RISK_NODE_LEAF, 0, 0}},")
+            else:
+                flags = "RISK_NODE_DEFAULT_LEFT" if dleft else "0"
+                lines.append(f"    {{{c_float(value)}, {feat}, {flags}, {child}}},")
+    lines += [
+        "};",
+        "",
+        "#endif // RISK_MODEL_DATA_H",
+        "",
+    ]
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+    return len(nodes)
+
+
+def split_sweep(trees: list, n_features: int, count: int, seed: int = 42) -> np.ndarray:
+    """Vectors with every feature on either side of the model's thresholds,
+    some missing, for when no real test set is available."""
+    rng = np.random.default_rng(seed)
+    thresholds = [[] for _ in range(n_features)]
+    for tree in trees:
+        for nid, feat in enumerate(tree["split_indices"]):
+            if tree["left_children"][nid] != -1:
+                thresholds[feat].append(float(tree["split_conditions"][nid]))
+
+    X = np.zeros((count, n_features), dtype=np.float32)
+    for j in range(n_features):
+        t = np.array(thresholds[j] or [0.0], dtype=np.float32)
+        picks = rng.choice(t, count)
+        X[:, j] = picks + rng.choice([-1.0, 0.0, 1.0], count) * np.maximum(np.abs(picks), 1.0) * 1e-3
+    X[rng.random(X.shape) < 0.05] = np.nan
+    return X
+
+
+def write_vectors(path: str, booster, X: np.ndarray):
+    import xgboost as xgb
+
+    probs = booster.predict(xgb.DMatrix(X, missing=np.nan))
+    with open(path, "w") as f:
+        f.write("# " + ",".join(FEATURE_NAMES) + ",probability\n")
+        for row, p in zip(X, probs):
+            values = ["nan" if np.isnan(v) else repr(float(v)) for v in row]
+            f.write(",".join(values) + f",{float(p)!r}\n")
+    return len(X)
+
+
+def export(model_path: str, header_path: str, vectors_path: str,
+           test_set: str = None, vector_count: int = 2000):
+    booster = load_booster(model_path)
+    trees, base_margin = booster_trees(booster)
+    nodes = write_header(header_path, trees, base_margin, model_path)
+    print(f"[EXPORT] {len(trees)} trees, {nodes} nodes ({nodes * 8 / 1024:.1f} KB flash) -> {header_path}")
+
+    X = None
+    if test_set and os.path.exists(test_set):
+        data = np.load(test_set)
+        if "features" in data:
+            X = data["features"].astype(np.float32)[:, :len(FEATURE_NAMES)]
+            print(f"[EXPORT] Test set: {len(X)} vectors from {test_set}")
+    if X is None:
+        X = split_sweep(trees, len(FEATURE_NAMES), vector_count)
+        print(f"[EXPORT] Test set: {len(X)} threshold-sweep vectors")
+    write_vectors(vectors_path, booster, X)
+    print(f"[EXPORT] Vectors with Python probabilities -> {vectors_path}")
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--model", default=DEFAULT_MODEL, help="XGBClassifier .joblib or Booster .json")
+    parser.add_argument("--header", default=DEFAULT_HEADER, help="Generated C++ header")
+    parser.add_argument("--vectors", default=DEFAULT_VECTORS, help="Test vectors CSV")
+    parser.add_argument("--test-set", default=os.path.join("models", "xgboost_test_preds.npz"),
+                        help="npz with a 'features' array (train_xgboost.py output)")
+    parser.add_argument("--count", type=int, default=2000, help="Sweep vectors without a test set")
+    args = parser.parse_args()
+
+    export(args.model, args.header, args.vectors, args.test_set, args.count)
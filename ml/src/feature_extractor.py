@@ -11,7 +11,8 @@ from scipy.stats import kurtosis, skew
 
 def extract_ecg_features(ecg_signal: np.ndarray, sample_rate: int = 100,
                          heart_rate_sensor: float = None,
-                         spo2: float = None) -> dict:
+                         spo2: float = None, r_peaks=None,
+                         hrv: dict = None) -> dict:
     """
     Extract 26 features from single-lead ECG signal.
 
@@ -20,6 +21,10 @@ def extract_ecg_features(ecg_signal: np.ndarray, sample_rate: int = 100,
         sample_rate: Sampling rate in Hz (100 for ESP32, 500 for PTB-XL)
         heart_rate_sensor: HR from MAX30100 (optional, for device features)
         spo2: SpO2 from MAX30100 (optional, for device features)
+        r_peaks: R peak sample indices from the device QRS detector (optional,
+            skips peak detection when there are at least 3)
+        hrv: HRV time-domain features computed on the device for r_peaks
+            (optional, used instead of recomputing them)
 
     Returns:
         dict of 26 features (keys match XGBoost training feature names)
@@ -30,9 +35,14 @@ def extract_ecg_features(ecg_signal: np.ndarray, sample_rate: int = 100,
         # Clean the ECG signal
         ecg_cleaned = nk.ecg_clean(ecg_signal, sampling_rate=sample_rate)
 
-        # Detect R-peaks
-        _, rpeaks = nk.ecg_peaks(ecg_cleaned, sampling_rate=sample_rate)
-        r_peak_indices = rpeaks.get("ECG_R_Peaks", np.array([]))
+        # Detect R-peaks (or take the device's)
+        if r_peaks is not None and len(r_peaks) >= 3:
+            r_peak_indices = np.asarray(r_peaks, dtype=int)
+            rpeaks = {"ECG_R_Peaks": r_peak_indices}
+        else:
+            _, rpeaks = nk.ecg_peaks(ecg_cleaned, sampling_rate=sample_rate)
+            r_peak_indices = rpeaks.get("ECG_R_Peaks", np.array([]))
+            hrv = None
 
         if len(r_peak_indices) < 3:
             return _fallback_features(ecg_signal, heart_rate_sensor, spo2)
@@ -40,17 +50,21 @@ def extract_ecg_features(ecg_signal: np.ndarray, sample_rate: int = 100,
         # --- HRV Time-Domain Features (7) ---
         rr_intervals = np.diff(r_peak_indices) / sample_rate * 1000  # ms
 
-        features["mean_rr"] = float(np.mean(rr_intervals))
-        features["sdnn"] = float(np.std(rr_intervals, ddof=1)) if len(rr_intervals) > 1 else 0.0
-        features["rmssd"] = float(np.sqrt(np.mean(np.diff(rr_intervals) ** 2))) if len(rr_intervals) > 1 else 0.0
+        if hrv and hrv.get("rr_count", 0) >= 2:
+            # Computed on the device for the same peaks
+            features.update({key: float(hrv[key]) for key in HRV_FEATURE_NAMES})
+        else:
+            features["mean_rr"] = float(np.mean(rr_intervals))
+            features["sdnn"] = float(np.std(rr_intervals, ddof=1)) if len(rr_intervals) > 1 else 0.0
+            features["rmssd"] = float(np.sqrt(np.mean(np.diff(rr_intervals) ** 2))) if len(rr_intervals) > 1 else 0.0
 
-        nn_diff = np.abs(np.diff(rr_intervals))
-        features["pnn50"] = float(np.sum(nn_diff > 50) / len(nn_diff) * 100) if len(nn_diff) > 0 else 0.0
+            nn_diff = np.abs(np.diff(rr_intervals))
+            features["pnn50"] = float(np.sum(nn_diff > 50) / len(nn_diff) * 100) if len(nn_diff) > 0 else 0.0
 
-        hr_from_rr = 60000.0 / rr_intervals
-        features["mean_hr_ecg"] = float(np.mean(hr_from_rr))
-        features["hr_std"] = float(np.std(hr_from_rr))
-        features["rr_range"] = float(np.max(rr_intervals) - np.min(rr_intervals))
+            hr_from_rr = 60000.0 / rr_intervals
+            features["mean_hr_ecg"] = float(np.mean(hr_from_rr))
+            features["hr_std"] = float(np.std(hr_from_rr))
+            features["rr_range"] = float(np.max(rr_intervals) - np.min(rr_intervals))
 
         # --- ECG Morphology Features (9) ---
         try:
@@ -218,6 +232,11 @@ def _fallback_features(ecg_signal, heart_rate_sensor=None, spo2=None) -> dict:
     }
 
 
+# HRV time-domain features the device can send with its R peaks
+HRV_FEATURE_NAMES = [
+    "mean_rr", "sdnn", "rmssd", "pnn50", "mean_hr_ecg", "hr_std", "rr_range",
+]
+
 # Ordered feature names for XGBoost (must match training order)
 FEATURE_NAMES = [
     "mean_rr", "sdnn", "rmssd", "pnn50", "mean_hr_ecg", "hr_std", "rr_range",
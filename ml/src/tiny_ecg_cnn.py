@@ -0,0 +1,291 @@
+"""
+Tiny 1D CNN for on-device ECG screening: int8 quantization, integer
+reference and export to firmware/src/ecg_cnn_data.h.
+
+The network runs directly on the device's 10 s windows at 250 Hz (2500
+samples, z-scored like the server does for ECGFounder):
+
+    5 x [Conv1d (stride 2, "same" padding) + ReLU] -> global average -> Linear
+
+Weights are int8 with one scale per output channel, activations int8 with
+one scale per layer, accumulators int32. Each layer is requantized with an
+integer multiplier and shift, so reference_int8() here and
+firmware/src/ecg_cnn.cpp compute the same numbers.
+
+distill_tiny_cnn.py trains the float network against ECGFounder and calls
+export(). The float weights are kept in models/tiny_ecg_cnn.npz, so the
+export can be repeated without torch:
+
+    cd ml/
+    python3 src/tiny_ecg_cnn.py --weights models/tiny_ecg_cnn.npz
+"""
+
+import os
+import struct
+
+import numpy as np
+from scipy.signal import resample
+
+SAMPLE_RATE = 250
+INPUT_LEN = SAMPLE_RATE * 10
+
+# (out_channels, kernel, stride) per conv layer, ReLU after each
+CONV_LAYERS = [(8, 7, 2), (16, 5, 2), (16, 5, 2), (32, 5, 2), (32, 3, 2)]
+
+# Input: z-score clipped at +-INPUT_CLIP standard deviations
+INPUT_CLIP = 8.0
+INPUT_SCALE = 127.0 / INPUT_CLIP        # quantized units per standard deviation
+
+ROOT = os.path.join(os.path.dirname(__file__), "..", "..")
+DEFAULT_HEADER = os.path.join(ROOT, "firmware", "src", "ecg_cnn_data.h")
+DEFAULT_VECTORS = os.path.join(ROOT, "firmware", "tools", "ecg_cnn_vectors.bin")
+
+# Test vector file (firmware/tools/ecg_cnn_check.cpp), little-endian:
+#   "ECNN", u32 count, u16 samples per window
+#   per window: u16 samples[], u8 label, f32 teacher, f32 float model, f32 int8 model
+VECTORS_MAGIC = b"ECNN"
+
+
+def layer_lengths(length: int = INPUT_LEN) -> list:
+    """Output length of every conv layer."""
+    lengths = []
+    for _, kernel, stride in CONV_LAYERS:
+        length = (length + 2 * (kernel // 2) - kernel) // stride + 1
+        lengths.append(length)
+    return lengths
+
+
+def to_device_window(signal: np.ndarray, gain: float = 1100.0) -> np.ndarray:
+    """10 s of ECG in mV at any rate -> 2500 ADC counts around 2048 at 250 Hz,
+    the way the device uploads them."""
+    x = resample(np.asarray(signal, dtype=np.float64).flatten(), INPUT_LEN)
+    x = (x - np.mean(x)) * gain / 1000.0 * 4095 / 3.3
+    return np.clip(np.round(x + 2048), 0, 4095).astype(np.uint16)
+
+
+def normalize(window: np.ndarray) -> np.ndarray:
+    """Float model input: z-score of the window."""
+    x = np.asarray(window, dtype=np.float32)
+    return (x - x.mean()) / (x.std() + 1e-8)
+
+
+def quantize_input(window: np.ndarray) -> np.ndarray:
+    """int8 model input, float32 steps in the order ecg_cnn.cpp uses."""
+    counts = np.asarray(window, dtype=np.int64) - 2048
+    n = len(counts)
+    total = int(counts.sum())
+    total2 = int((counts * counts).sum())
+    var_n2 = n * total2 - total * total          # n^2 * variance, exact
+    if var_n2 <= 0:
+        return np.zeros(n, dtype=np.int8)
+    mean = np.float32(np.int64(total)) / np.float32(n)
+    scale = np.float32(INPUT_SCALE) * np.float32(n) / np.sqrt(np.float32(np.int64(var_n2)))
+    x = (counts.astype(np.float32) - mean) * scale
+    q = np.sign(x) * np.floor(np.abs(x) + np.float32(0.5))     # lroundf: halves away from zero
+    return np.clip(q, -127, 127).astype(np.int8)
+
+
+# ── Float reference ──
+
+def _conv_same(x: np.ndarray, w: np.ndarray, b: np.ndarray, stride: int) -> np.ndarray:
+    """x (C_in, T), w (C_out, C_in, K) -> (C_out, T_out)"""
+    k = w.shape[2]
+    pad = k // 2
+    xp = np.pad(x, ((0, 0), (pad, pad)))
+    t_out = (x.shape[1] + 2 * pad - k) // stride + 1
+    cols = np.stack([xp[:, i:i + stride * (t_out - 1) + 1:stride] for i in range(k)], axis=1)
+    return np.einsum("oik,ikt->ot", w, cols) + b[:, None]
+
+
+def forward_float(weights: dict, x: np.ndarray) -> tuple:
+    """Logit and the activations of every conv layer for one z-scored window."""
+    acts = []
+    h = np.asarray(x, dtype=np.float32)[None, :]
+    for i, (_, _, stride) in enumerate(CONV_LAYERS):
+        h = np.maximum(_conv_same(h, weights[f"conv{i}_w"], weights[f"conv{i}_b"], stride), 0)
+        acts.append(h)
+    logit = float(weights["fc_w"][0] @ h.mean(axis=1) + weights["fc_b"][0])
+    return logit, acts
+
+
+def sigmoid(x):
+    return 1.0 / (1.0 + np.exp(-x))
+
+
+# ── Quantization ──
+
+def _multiplier(m: float) -> tuple:
+    """Real multiplier -> (int32 mult, right shift) with m ~ mult * 2^-shift."""
+    frac, exp = np.frexp(m)
+    mult = int(round(frac * (1 << 31)))
+    if mult == 1 << 31:
+        mult //= 2
+        exp += 1
+    shift = 31 - exp
+    if not 1 <= shift <= 62:
+        raise ValueError(f"requantization multiplier {m} out of range")
+    return mult, shift
+
+
+def quantize(weights: dict, calibration: list, percentile: float = 99.99) -> dict:
+    """Post-training quantization from float weights and calibration windows
+    (device windows, uint16 counts)."""
+    peaks = [[] for _ in CONV_LAYERS]
+    for window in calibration:
+        _, acts = forward_float(weights, normalize(window))
+        for i, a in enumerate(acts):
+            peaks[i].append(np.percentile(a, percentile))
+
+    q = {"layers": []}
+    s_in = 1.0 / INPUT_SCALE
+    for i, (_, kernel, stride) in enumerate(CONV_LAYERS):
+        w = weights[f"conv{i}_w"].astype(np.float64)
+        b = weights[f"conv{i}_b"].astype(np.float64)
+        s_out = max(float(np.mean(peaks[i])), 1e-6) / 127.0
+        s_w = np.maximum(np.abs(w).reshape(w.shape[0], -1).max(axis=1), 1e-12) / 127.0
+        layer = {
+            "kernel": kernel,
+            "stride": stride,
+            "weights": np.clip(np.round(w / s_w[:, None, None]), -127, 127).astype(np.int8),
+            "bias": np.round(b / (s_in * s_w)).astype(np.int32),
+            "mult": [],
+            "shift": [],
+        }
+        for c in range(w.shape[0]):
+            mult, shift = _multiplier(s_in * s_w[c] / s_out)
+            layer["mult"].append(mult)
+            layer["shift"].append(shift)
+        q["layers"].append(layer)
+        s_in = s_out
+
+    fc_w = weights["fc_w"][0].astype(np.float64)
+    s_fc = max(np.abs(fc_w).max(), 1e-12) / 127.0
+    q["fc_weights"] = np.clip(np.round(fc_w / s_fc), -127, 127).astype(np.int8)
+    # logit = sum_c w_q[c] * sum_t y_q[c, t] * fc_scale + fc_bias
+    q["fc_scale"] = float(np.float32(s_in * s_fc / layer_lengths()[-1]))
+    q["fc_bias"] = float(np.float32(weights["fc_b"][0]))
+    return q
+
+
+def reference_int8(q: dict, window: np.ndarray) -> float:
+    """Probability from the quantized network, integer arithmetic as on the device."""
+    h = quantize_input(window).astype(np.int64)[None, :]
+    for layer in q["layers"]:
+        acc = _conv_same(h, layer["weights"].astype(np.int64), layer["bias"].astype(np.int64),
+                         layer["stride"])
+        mult = np.array(layer["mult"], dtype=np.int64)[:, None]
+        shift = np.array(layer["shift"], dtype=np.int64)[:, None]
+        # Rounded, arithmetic shift; |acc| < 2^24 so the product fits int64
+        h = np.clip((acc * mult + (np.int64(1) << (shift - 1))) >> shift, 0, 127)
+    sums = h.sum(axis=1)
+    acc = int(q["fc_weights"].astype(np.int64) @ sums)
+    logit = np.float32(acc) * np.float32(q["fc_scale"]) + np.float32(q["fc_bias"])
+    return float(np.float32(1.0) / (np.float32(1.0) + np.exp(-logit, dtype=np.float32)))
+
+
+# ── Export ──
+
+def _c_float(v: float) -> str:
+    """float32 literal that round-trips exactly"""
+    return np.format_float_scientific(np.float32(v), unique=True) + "f"
+
+
+def _c_array(ctype: str, name: str, values, per_line: int = 16) -> list:
+    values = [int(v) for v in np.asarray(values).flatten()]
+    lines = [f"static const {ctype} {name}[{len(values)}] = {{"]
+    for i in range(0, len(values), per_line):
+        lines.append("    " + " ".join(f"{v}," for v in values[i:i + per_line]))
+    lines.append("};")
+    return lines
+
+
+def write_header(path: str, q: dict, source: str) -> tuple:
+    lengths = [INPUT_LEN] + layer_lengths()
+    channels = [1] + [c for c, _, _ in CONV_LAYERS]
+    sizes = [c * n for c, n in zip(channels, lengths)]
+    # Layer i reads buffer i % 2 and writes the other one
+    buffer_bytes = max(max(sizes[0::2]), max(sizes[1::2]))
+    param_bytes = 0
+
+    lines = [
+        "// Generated by ml/src/tiny_ecg_cnn.py - do not edit.",
+        f"// Source: {os.path.basename(source)}",
+        "#ifndef ECG_CNN_DATA_H",
+        "#define ECG_CNN_DATA_H",
+        "",
+        '#include "ecg_cnn.h"',
+        "",
+        f"#define ECG_CNN_INPUT_LEN       {INPUT_LEN}",
+        f"#define ECG_CNN_INPUT_SCALE     {_c_float(INPUT_SCALE)}    // int8 units per standard deviation",
+        f"#define ECG_CNN_LAYER_COUNT     {len(CONV_LAYERS)}",
+        f"#define ECG_CNN_BUFFER_BYTES    {buffer_bytes}",
+        f"#define ECG_CNN_FC_SCALE        {_c_float(q['fc_scale'])}",
+        f"#define ECG_CNN_FC_BIAS         {_c_float(q['fc_bias'])}",
+        "",
+    ]
+    for i, layer in enumerate(q["layers"]):
+        lines += _c_array("int8_t", f"ECG_CNN_W{i}", layer["weights"])
+        lines += _c_array("int32_t", f"ECG_CNN_B{i}", layer["bias"], 8)
+        lines += _c_array("int32_t", f"ECG_CNN_M{i}", layer["mult"], 8)
+        lines += _c_array("uint8_t", f"ECG_CNN_S{i}", layer["shift"])
+        lines.append("")
+        param_bytes += layer["weights"].size + 9 * len(layer["bias"])
+    lines += _c_array("int8_t", "ECG_CNN_FC_WEIGHTS", q["fc_weights"])
+    param_bytes += q["fc_weights"].size
+    lines += [
+        "",
+        "// {in channels, out channels, kernel, stride, in length, out length, weights, bias, mult, shift}",
+        "static const EcgCnnLayer ECG_CNN_LAYERS[ECG_CNN_LAYER_COUNT] = {",
+    ]
+    for i, layer in enumerate(q["layers"]):
+        lines.append(f"    {{{channels[i]}, {channels[i + 1]}, {layer['kernel']}, {layer['stride']}, "
+                     f"{lengths[i]}, {lengths[i + 1]}, "
+                     f"ECG_CNN_W{i}, ECG_CNN_B{i}, ECG_CNN_M{i}, ECG_CNN_S{i}}},")
+    lines += ["};", "", "#endif // ECG_CNN_DATA_H", ""]
+
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+    return param_bytes, 2 * buffer_bytes
+
+
+def write_vectors(path: str, windows: list, labels, teacher, float_probs, int8_probs):
+    with open(path, "wb") as f:
+        f.write(VECTORS_MAGIC + struct.pack("<IH", len(windows), INPUT_LEN))
+        for w, y, pt, pf, pq in zip(windows, labels, teacher, float_probs, int8_probs):
+            f.write(np.asarray(w, dtype="<u2").tobytes())
+            f.write(struct.pack("<Bfff", int(y), pt, pf, pq))
+
+
+def export(weights: dict, calibration: list, test_windows: list, test_labels,
+           teacher_probs=None, header_path: str = DEFAULT_HEADER,
+           vectors_path: str = DEFAULT_VECTORS, source: str = "tiny_ecg_cnn.npz") -> dict:
+    """Quantize, write the firmware header and the check vectors. Returns the
+    float and int8 test probabilities."""
+    q = quantize(weights, calibration)
+    param_bytes, arena_bytes = write_header(header_path, q, source)
+    print(f"[EXPORT] {param_bytes / 1024:.1f} KB parameters, {arena_bytes / 1024:.1f} KB arena -> {header_path}")
+
+    float_probs = np.array([sigmoid(forward_float(weights, normalize(w))[0]) for w in test_windows])
+    int8_probs = np.array([reference_int8(q, w) for w in test_windows])
+    if teacher_probs is None:
+        teacher_probs = np.full(len(test_windows), np.nan)
+    write_vectors(vectors_path, test_windows, test_labels, teacher_probs, float_probs, int8_probs)
+    print(f"[EXPORT] {len(test_windows)} test windows -> {vectors_path}")
+    print(f"[EXPORT] int8 vs float: max |diff| {np.max(np.abs(int8_probs - float_probs)):.4f}, "
+          f"label agreement {np.mean((int8_probs > 0.5) == (float_probs > 0.5)) * 100:.1f}%")
+    return {"float": float_probs, "int8": int8_probs}
+
+
+if __name__ == "__main__":
+    import argparse
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--weights", default=os.path.join("models", "tiny_ecg_cnn.npz"),
+                        help="Float weights and test windows saved by distill_tiny_cnn.py")
+    parser.add_argument("--header", default=DEFAULT_HEADER)
+    parser.add_argument("--vectors", default=DEFAULT_VECTORS)
+    args = parser.parse_args()
+
+    data = np.load(args.weights)
+    weights = {k: data[k] for k in data.files if k.startswith(("conv", "fc_"))}
+    export(weights, list(data["calibration"]), list(data["test_windows"]), data["test_labels"],
+           data["test_teacher"], args.header, args.vectors, os.path.basename(args.weights))
@@ -145,7 +145,7 @@ def train_xgboost(data_path: str = None, output_dir: str = "models",
     print(f"\n[DONE] Model saved to {model_path}")
 
     np.savez(os.path.join(output_dir, "xgboost_test_preds.npz"),
-             preds=test_probs, labels=y_test_valid)
+             preds=test_probs, labels=y_test_valid, features=X_test_feat)
 
     return test_auc
 
@@ -94,6 +94,16 @@ def main():
     else:
         print("\n[SKIP] ECGFounder training (--xgboost-only)")
 
+    # Step 3b: Distill ECGFounder into the on-device CNN
+    if not args.xgboost_only and os.path.exists(os.path.join(model_dir, "ecgfounder_best.pt")):
+        print("\n" + "=" * 60)
+        print("STEP 3b: Distilling the on-device CNN")
+        print("=" * 60)
+        from distill_tiny_cnn import distill
+        distill(data_path=data_500hz, output_dir=model_dir)
+    else:
+        print("\n[SKIP] On-device CNN distillation (needs ECGFounder)")
+
     # Step 4: Train XGBoost
     if not args.ecgfounder_only:
         print("\n" + "=" * 60)